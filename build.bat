@@ -7,6 +7,8 @@ REM SET rdr_arg=-DRENDERER_VULKAN -I %VULKAN_SDK%\include -L %VULKAN_SDK%\lib -l
 SET rdr_arg=-DRENDERER_OPENGL -lOpenGL32.lib -lGdi32.lib
 
 SET args= -std=c17 -D__WIN32__ -g -DDEBUG -D_DEBUG -debug -D_CRT_SECURE_NO_WARNINGS -Wall -Wno-unused-function -Wgnu-empty-initializer
+REM Uncomment to use the AVX and FMA paths of sMath.h, the CPU running the game must support them
+REM SET args=%args% -mavx -mfma
 SET include_path=-I include/ -I src/
 SET linker_options=-Xlinker -incremental:no
 SET libs=
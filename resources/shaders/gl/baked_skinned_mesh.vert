@@ -0,0 +1,59 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+layout (location = 3) in vec4 joints;
+layout (location = 4) in vec4 weights;
+// Per instance, see BakedCrowdInstance
+layout (location = 5) in mat4 transform; // Locations 5 to 8
+layout (location = 9) in float time_offset;
+
+out vec3 Normal;
+out vec2 TexCoord;
+out vec4 shadow_map_texcoord;
+out vec3 worldpos;
+
+uniform mat4 vp;
+uniform mat4 light_matrix;
+
+// One row per frame, 3 texels per joint holding the first 3 rows of its matrix, see BakedAnimation
+uniform sampler2D baked_palettes;
+uniform float time;
+uniform float frame_rate;
+uniform int frame_count;
+
+mat4 FetchJoint(int joint, int frame) {
+	int x = joint * 3;
+	vec4 row0 = texelFetch(baked_palettes, ivec2(x, frame), 0);
+	vec4 row1 = texelFetch(baked_palettes, ivec2(x + 1, frame), 0);
+	vec4 row2 = texelFetch(baked_palettes, ivec2(x + 2, frame), 0);
+	return transpose(mat4(row0, row1, row2, vec4(0.0, 0.0, 0.0, 1.0)));
+}
+
+// Skinning is linear in the joint matrices, blending them is blending the skinned vertices
+mat4 JointMatrix(int joint, int frame, int next_frame, float blend) {
+	return (1.0 - blend) * FetchJoint(joint, frame) + blend * FetchJoint(joint, next_frame);
+}
+
+void main() {
+	// The clip loops, the frame after the last one is the first
+	float frame_time = mod((time + time_offset) * frame_rate, float(frame_count));
+	int frame = min(int(frame_time), frame_count - 1);
+	int next_frame = (frame + 1) % frame_count;
+	float blend = frame_time - float(frame);
+
+	mat4 skin_mat = weights.x * JointMatrix(int(joints.x), frame, next_frame, blend) + 
+		weights.y * JointMatrix(int(joints.y), frame, next_frame, blend) +
+		weights.z * JointMatrix(int(joints.z), frame, next_frame, blend) +
+		weights.w * JointMatrix(int(joints.w), frame, next_frame, blend);
+
+    vec4 pos = transform * skin_mat * vec4(aPos, 1.0);
+    worldpos = pos.xyz;
+
+	mat4 inv_skin = inverse(transform * skin_mat);
+    Normal = vec4(vec4(aNormal, 1.0) * inv_skin).xyz;
+    TexCoord = aTexCoord;
+    shadow_map_texcoord = light_matrix * pos;
+
+	gl_Position = vp * pos;
+}
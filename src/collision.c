@@ -8,7 +8,7 @@
 bool IsPointInBoundingBox(const Vec3 p, const Mat4 m) {
     // We'll first transform the point by the inverse bb matrix to do our calculations in normalized space
     Mat4 inv;
-    mat4_inverse(m, inv);
+    mat4_inverse_affine(m, inv);
     
     Vec3 t = mat4_mul_vec3(inv, p);
     
@@ -38,11 +38,8 @@ bool IsLineIntersectingPlane(const Vec3 l1, const Vec3 l2, const Vec3 plane_pos,
 
 bool IsLineIntersectingBoundingBox(const Vec3 l1, const Vec3 l2, const Transform *xform) {
     // Transform the line into the bb coord system
-    Mat4 m;
-    transform_to_mat4(xform, &m);
-    
     Mat4 inv;
-    mat4_inverse(m, inv);
+    transform_inverse_to_mat4(xform, inv);
     
     Vec3 lb1 = mat4_mul_vec3(inv, l1);
     Vec3 lb2 = mat4_mul_vec3(inv, l2);
@@ -87,61 +84,65 @@ bool IsLineIntersectingBoundingBox(const Vec3 l1, const Vec3 l2, const Transform
 void TESTCOLLISION() {
     sLog("Collision");
     
-    Mat4 mat = mat4_identity();
-    mat4_scaleby(&mat, (Vec3){2.3f, 5.6f, 0.4f});
-    mat4_translateby(&mat, (Vec3){1.0f, 4.0f, -5.0f});
+    Mat4 mat;
+    mat4_identity(mat);
+    mat4_scaleby(mat, (Vec3){2.3f, 5.6f, 0.4f});
+    mat4_translateby(mat, (Vec3){1.0f, 4.0f, -5.0f});
     
-    TEST_BOOL(IsPointInBoundingBox((Vec3){0.0f, 5.0f, -5.0f}, &mat));
-    TEST_BOOL(IsPointInBoundingBox((Vec3){1.0f, 4.1f, -5.0f}, &mat));
-    TEST_BOOL(!IsPointInBoundingBox((Vec3){-1.0f, 0.0f, -5.0f}, &mat));
-    TEST_BOOL(!IsPointInBoundingBox((Vec3){0.0f, 0.0f, -0.0f}, &mat));
+    TEST_BOOL(IsPointInBoundingBox((Vec3){0.0f, 5.0f, -5.0f}, mat));
+    TEST_BOOL(IsPointInBoundingBox((Vec3){1.0f, 4.1f, -5.0f}, mat));
+    TEST_BOOL(!IsPointInBoundingBox((Vec3){-1.0f, 0.0f, -5.0f}, mat));
+    TEST_BOOL(!IsPointInBoundingBox((Vec3){0.0f, 0.0f, -0.0f}, mat));
     
     TEST_BOOL(IsLineIntersectingAAPlane((Vec3){-1.0f, 0.0f, 0.0f}, (Vec3){1.0f, 0.0f, 0.0f}, (Vec3){0.5f, 0.0f, 0.0f}));
     TEST_BOOL(!IsLineIntersectingAAPlane((Vec3){-1.0f, 0.5f, 0.0f}, (Vec3){1.0f, 0.5f, 0.0f}, (Vec3){0.0f, 1.0f, 0.0f}));
     
     sLog("Cube");
-    mat = mat4_identity();
+    mat4_identity(mat);
+    Transform xform;
+    mat4_to_transform(&mat, &xform);
     
     // Crossing 2 parallel planes
     Vec3 l1 = {1.0f, 0.1f, 0.0f};
     Vec3 l2 = {-1.0f, 0.1f, 0.0f};
-    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &mat));
+    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &xform));
     
     // From inside
     l1 = (Vec3){0.0f, 0.5f, 0.0f};
     l2 = (Vec3){-1.0f, 0.0f, 0.0f};
-    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &mat));
+    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &xform));
     
     // From outside
     l1 = (Vec3){-1.0f, 0.5f, 0.0f};
     l2 = (Vec3){0.0f, 0.5f, 0.0f};
-    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &mat));
+    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &xform));
     
     // Miss Parallel
     l1 = (Vec3){-1.0f, 1.0f, 0.0f};
     l2 = (Vec3){-1.0f, 0.0f, 0.0f};
-    TEST_BOOL(!IsLineIntersectingBoundingBox(l1, l2, &mat));
+    TEST_BOOL(!IsLineIntersectingBoundingBox(l1, l2, &xform));
     
     // Hit xz planes
     l1 = (Vec3){-1.0f, 0.5f, 0.0f};
     l2 = (Vec3){0.0f, 0.5f, -1.0f};
-    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &mat));
+    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &xform));
     
     // Hit zy planes
     l1 = (Vec3){0.0f, -0.5f, 0.0f};
     l2 = (Vec3){0.0f, 0.5f, -1.0f};
-    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &mat));
+    TEST_BOOL(IsLineIntersectingBoundingBox(l1, l2, &xform));
     
     // Too short
     l1 = (Vec3){1.0f, 0.5f, 0.0f};
     l2 = (Vec3){0.5f, 0.5f, 0.0f};
-    TEST_BOOL(!IsLineIntersectingBoundingBox(l1, l2, &mat));
+    TEST_BOOL(!IsLineIntersectingBoundingBox(l1, l2, &xform));
     
     // Matrix rotation
     l1 = (Vec3){0.0f, -0.5f, 0.0f};
     l2 = (Vec3){0.0f, 0.5f, -1.0f};
-    mat4_rotate_euler(&mat, (Vec3){45.0f, 45.0f, 45.0f});
-    TEST_BOOL(!IsLineIntersectingBoundingBox(l1, l2, &mat));
+    mat4_rotate_euler(mat, (Vec3){45.0f, 45.0f, 45.0f});
+    mat4_to_transform(&mat, &xform);
+    TEST_BOOL(!IsLineIntersectingBoundingBox(l1, l2, &xform));
     
     sLog("");
 }
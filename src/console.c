@@ -31,19 +31,147 @@ void CommandShadowMap(ConsoleArgs *args, GameData *game_data){
     sLog("Toggling shadow map");
 }
 
+void CommandAllocs(ConsoleArgs *args, GameData *game_data) {
+    Leak_DumpStats();
+}
+
+void CommandPerf(ConsoleArgs *args, GameData *game_data) {
+    sDumpPerf();
+}
+
+void CommandMem(ConsoleArgs *args, GameData *game_data) {
+    sMemDumpTags();
+    PlatformMemory *memory = platform->memory;
+    sLog("Permanent arena | Used: %llu bytes | Peak: %llu bytes | Size: %llu bytes", memory->permanent.used, memory->permanent.peak, memory->permanent.size);
+    sLog("Level arena | Used: %llu bytes | Peak: %llu bytes | Size: %llu bytes", memory->level.used, memory->level.peak, memory->level.size);
+    sLog("Frame arena | Peak: %llu bytes | Size: %llu bytes", memory->frame.peak, memory->frame.size);
+}
+
+// Spawns the crowd the first time, then times the animation update with the instances split in 1, 2, 4 and 8 jobs.
+// A job runs on a single thread, so the job count is the number of threads working on the update.
+// These run without LODs, the last run uses the current LOD settings and every thread.
+void CommandAnimBench(ConsoleArgs *args, GameData *game_data) {
+    const u32 crowd_size = 1000;
+    const u32 frames = 100;
+    const f32 delta_time = 1.0f / 60.0f;
+    
+    if(game_data->crowd_count == 0) {
+        WorldSpawnCrowd(&game_data->world, global_renderer, game_data->npc.skin, game_data->npc.walk_animation, crowd_size);
+        game_data->crowd_count = crowd_size;
+    }
+    
+    sArena *frame_arena = &platform->memory->frame;
+    const u32 thread_counts[] = {1, 2, 4, 8, 0};
+    for(u32 t = 0; t < ARRAY_SIZE(thread_counts); t++) {
+        if(thread_counts[t] > platform->worker_count + 1) {
+            sWarn("Only %u threads available, %u jobs will share them", platform->worker_count + 1, thread_counts[t]);
+        }
+        const AnimationLODSettings *lod = thread_counts[t] == 0 ? &game_data->animation_lod : NULL;
+        u64 mark = sArenaGetMark(frame_arena);
+        u32 instance_count = 0;
+        const f64 start = platform->GetTime();
+        for(u32 f = 0; f < frames; f++) {
+            instance_count = WorldAnimateEntities(&game_data->world, global_renderer, lod, delta_time, thread_counts[t]);
+            sArenaPopToMark(frame_arena, mark);
+        }
+        const f64 ms = (platform->GetTime() - start) * 1000.0;
+        if(lod) {
+            sLog("Animation | %u instances | LODs, every thread | %.3f ms/frame", instance_count, ms / frames);
+        } else {
+            sLog("Animation | %u instances | %u threads | %.3f ms/frame", instance_count, thread_counts[t], ms / frames);
+        }
+    }
+}
+
+// animlod [throttle distance] [freeze distance] [interval], prints the settings without arguments
+void CommandAnimLOD(ConsoleArgs *args, GameData *game_data) {
+    AnimationLODSettings *lod = &game_data->animation_lod;
+    if((*args)[1][0] != '\0') {
+        lod->throttle_distance = atof((*args)[1]);
+    }
+    if((*args)[2][0] != '\0') {
+        lod->freeze_distance = atof((*args)[2]);
+    }
+    if((*args)[3][0] != '\0') {
+        lod->interval = MAX(atoi((*args)[3]), 1);
+    }
+    sLog("Animation LOD | Throttled from %.1fm, every %u frames | Frozen from %.1fm", lod->throttle_distance, lod->interval, lod->freeze_distance);
+}
+
+// bakedcrowd [count], fills the background with count walking NPCs drawn in one instanced call, 0 removes them.
+// The walk cycle is baked the first time.
+void CommandBakedCrowd(ConsoleArgs *args, GameData *game_data) {
+    const i32 requested = (*args)[1][0] != '\0' ? atoi((*args)[1]) : 5000;
+    if(requested == 0) {
+        RendererDestroyBakedCrowd(global_renderer, game_data->baked_crowd);
+        game_data->baked_crowd = 0;
+        return;
+    }
+    if(requested < 0 || requested > BAKED_CROWD_MAX_INSTANCES) {
+        sError("bakedcrowd : count must be between 0 and %d", BAKED_CROWD_MAX_INSTANCES);
+        return;
+    }
+    const u32 count = (u32)requested;
+    
+    const Animation *walk = sPoolGet(&global_renderer->animations, game_data->npc.walk_animation);
+    if(!walk || !sPoolGet(&global_renderer->skins, game_data->npc.skin)) {
+        sError("bakedcrowd : the NPC's skin or walk animation isn't loaded");
+        return;
+    }
+    if(!sPoolGet(&global_renderer->baked_animations, game_data->baked_walk)) {
+        game_data->baked_walk = RendererBakeAnimation(global_renderer, game_data->npc.skin, game_data->npc.walk_animation, BAKED_ANIMATION_RATE);
+    }
+    
+    // Rows behind the animated crowd, past the distance where its animation freezes
+    const u32 row_size = 100;
+    sArena *frame_arena = &platform->memory->frame;
+    u64 mark = sArenaGetMark(frame_arena);
+    BakedCrowdInstance *instances = sArenaPushArray(frame_arena, count, BakedCrowdInstance);
+    if(!instances) {
+        sError("bakedcrowd : no room for %u instances in the frame arena", count);
+        return;
+    }
+    for(u32 i = 0; i < count; i++) {
+        Transform xform;
+        transform_identity(&xform);
+        xform.translation = (Vec3){(f32)(i % row_size) - row_size / 2.0f, 0.0f, -45.0f - (f32)(i / row_size)};
+        transform_to_mat4(&xform, &instances[i].world);
+        // Golden ratio sequence, spreads the start times evenly
+        instances[i].time_offset = fmodf(i * 0.618034f, 1.0f) * walk->length;
+    }
+    if(sPoolGet(&global_renderer->baked_crowds, game_data->baked_crowd)) {
+        RendererUpdateBakedCrowd(global_renderer, game_data->baked_crowd, instances, count);
+    } else {
+        game_data->baked_crowd = RendererCreateBakedCrowd(global_renderer, game_data->npc.skin, game_data->baked_walk, instances, count);
+    }
+    sArenaPopToMark(frame_arena, mark);
+    sLog("Baked crowd | %u instances in 1 draw call", count);
+}
+
 void ConsoleInit(Console *console) {
     console->commands[0] = (ConsoleCommand){"exit", &CommandExit};
     console->commands[1] = (ConsoleCommand){"freecam", &CommandFreeCam};
     console->commands[2] = (ConsoleCommand){"restart", &CommandRestart};
     console->commands[3] = (ConsoleCommand){"reload", &CommandReloadRenderer};
     console->commands[4] = (ConsoleCommand){"shadowmap", &CommandShadowMap};
+    console->commands[5] = (ConsoleCommand){"allocs", &CommandAllocs};
+    console->commands[6] = (ConsoleCommand){"perf", &CommandPerf};
+    console->commands[7] = (ConsoleCommand){"mem", &CommandMem};
+    console->commands[8] = (ConsoleCommand){"animbench", &CommandAnimBench};
+    console->commands[9] = (ConsoleCommand){"animlod", &CommandAnimLOD};
+    console->commands[10] = (ConsoleCommand){"bakedcrowd", &CommandBakedCrowd};
     
     console->command_count = ARRAY_SIZE(console->commands);
+    for(u32 i = 0; i < console->command_count; ++i) {
+        console->commands[i].id = sIntern(console->commands[i].command);
+    }
 }
 
 void ConsoleCallCommand(ConsoleArgs *args, GameData *game_data) {
-    for(u32 i = 0; i < global_console->command_count; ++i) {
-        if(strcmp(*args[0], global_console->commands[i].command) == 0) {
+    // Typed text is only looked up, an unknown command doesn't end up in the table
+    sStringID id = sInternFind(*args[0]);
+    for(u32 i = 0; id != STRING_ID_NONE && i < global_console->command_count; ++i) {
+        if(global_console->commands[i].id == id) {
             global_console->commands[i].function(args, game_data);
             return;
         }
@@ -88,7 +216,7 @@ internal void ConsoleParseMessage(const char *message, GameData *game_data) {
     
     length -= StringEatSpaces(&head, length);
     
-    ConsoleArgs args;
+    ConsoleArgs args = {0}; // Missing arguments are empty strings
     //char args[5][64];
     u32 argc = 0;
     while(argc < 5 && length > 0) {
@@ -13,6 +13,7 @@ typedef void ConsoleFunction(ConsoleArgs *args, struct GameData *game_data);
 typedef struct ConsoleCommand {
     const char *command;
     ConsoleFunction *function;
+    sStringID id; // Interned command, set in ConsoleInit
 } ConsoleCommand;
 
 typedef struct ConsoleHistoryEntry {
@@ -27,7 +28,7 @@ typedef struct Console {
     u32 current_char;
     char current_command[128];
     ConsoleHistoryEntry command_history[32];
-    ConsoleCommand commands[5];
+    ConsoleCommand commands[11];
     u32 command_count;
     
     u32 history_browser;
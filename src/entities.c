@@ -7,11 +7,11 @@ EntityID CreatePlayer(World *world, MeshHandle mesh) {
     return result;
 }
 
-EntityID CreateSword(World *world) {
+EntityID CreateSword(World *world, MeshHandle mesh) {
     Entity *sword_entity;
     EntityID result = WorldCreateAndGetEntity(world, &sword_entity);
     sword_entity->color = (Vec3){0.0f, 0.0f, 0.0f};
-    sword_entity->static_mesh = MakeCuboid(global_renderer, (Vec3){-.1f, -.1f, .2f}, (Vec3){.1f, .1f, 1.f});
+    sword_entity->static_mesh = mesh;
     sword_entity->flags = EntityFlag_Hidden | EntityFlag_Sleeping;
     sword_entity->type = EntityType_Sword;
     return result;
@@ -31,13 +31,94 @@ EntityID CreateEnemy(World *world, MeshHandle mesh) {
     return result;
 }
 
+// Removes every animation layer, the pose stays where it is
+void EntityStopAnimations(Entity *e) {
+    ASSERT(e->render_type == RenderingType_SkinnedMesh);
+    for(u32 i = 0; i < e->animation_count; i++) {
+        AnimationSamplerDestroy(&e->animations[i].sampler);
+    }
+    e->animation_count = 0;
+}
+
+// Adds a layer on top of the others. The mask isn't copied, it must outlive the layer.
+// Returns the index of the layer, or ENTITY_ANIMATION_LAYERS when they are all in use.
+u32 EntityAddAnimationLayer(Renderer *renderer, Entity *e, AnimationHandle animation, f32 time, f32 weight, AnimationBlendMode mode, const f32 *joint_weights) {
+    ASSERT(e->render_type == RenderingType_SkinnedMesh);
+    if(e->animation_count == ENTITY_ANIMATION_LAYERS) {
+        sWarn("Entity has too many animation layers");
+        return ENTITY_ANIMATION_LAYERS;
+    }
+    const u32 index = e->animation_count++;
+    EntityAnimation *layer = &e->animations[index];
+    *layer = (EntityAnimation){animation, time, weight, 0.0f, mode, joint_weights};
+    AnimationSamplerInit(&layer->sampler, sPoolGet(&renderer->animations, animation));
+    return index;
+}
+
+// Replaces the animations with this one. The pose of the entity is then updated by WorldAnimateEntities
+void EntityPlayAnimation(Renderer *renderer, Entity *e, AnimationHandle animation, f32 time) {
+    EntityStopAnimations(e);
+    EntityAddAnimationLayer(renderer, e, animation, time, 1.0f, ANIMATION_BLEND_OVERRIDE, NULL);
+}
+
+// Fades the animation in over duration seconds on top of the current ones, which are dropped once it is at full weight.
+// When the layers are full, the top one is replaced.
+void EntityCrossfade(Renderer *renderer, Entity *e, AnimationHandle animation, f32 duration) {
+    if(e->animation_count == 0 || duration <= 0.0f) {
+        EntityPlayAnimation(renderer, e, animation, 0.0f);
+        return;
+    }
+    if(e->animation_count == ENTITY_ANIMATION_LAYERS) {
+        AnimationSamplerDestroy(&e->animations[--e->animation_count].sampler);
+    }
+    u32 index = EntityAddAnimationLayer(renderer, e, animation, 0.0f, 0.0f, ANIMATION_BLEND_OVERRIDE, NULL);
+    e->animations[index].weight_speed = 1.0f / duration;
+}
+
+// Advances the times and the fading weights of the layers, and removes the layers hidden by a full override.
+// Layers at weight 0 are kept, they are only skipped by the evaluation. Returns false if an animation doesn't exist anymore.
+bool EntityUpdateAnimations(Renderer *renderer, Entity *e, f32 delta_time) {
+    u32 base = 0;
+    for(u32 i = 0; i < e->animation_count; i++) {
+        EntityAnimation *layer = &e->animations[i];
+        const Animation *animation = sPoolGet(&renderer->animations, layer->animation);
+        if(!animation) {
+            return false;
+        }
+        layer->time = AnimationWrapTime(layer->time + delta_time, animation->length);
+        if(layer->weight_speed != 0.0f) {
+            layer->weight += layer->weight_speed * delta_time;
+            if(layer->weight >= 1.0f || layer->weight <= 0.0f) {
+                layer->weight = layer->weight > 0.0f ? 1.0f : 0.0f;
+                layer->weight_speed = 0.0f;
+            }
+        }
+        if(layer->mode == ANIMATION_BLEND_OVERRIDE && layer->weight >= 1.0f && !layer->joint_weights) {
+            base = i;
+        }
+    }
+    
+    u32 count = 0;
+    for(u32 i = 0; i < e->animation_count; i++) {
+        EntityAnimation *layer = &e->animations[i];
+        if(i < base) {
+            AnimationSamplerDestroy(&layer->sampler);
+        } else {
+            e->animations[count++] = *layer;
+        }
+    }
+    e->animation_count = count;
+    return true;
+}
+
 void CreateNPC(World *world, Renderer *renderer, PlatformAPI *platform, NPC *npc) {
-    SkinnedMeshHandle sk;
-    LoadFromGLTF("resources/3d/character/walk.gltf", renderer, platform, NULL, &sk, &npc->walk_animation);
-    npc->entity = InstantiateSkin(global_renderer, world, sk);
+    LoadFromGLTF("resources/3d/character/walk.gltf", renderer, platform, NULL, &npc->skin, &npc->animations);
+    // The walk cycle is the only clip of the file
+    npc->walk_animation = AnimationLibraryGetClip(sPoolGet(&renderer->animation_libraries, npc->animations), 0);
+    npc->entity = InstantiateSkin(global_renderer, world, npc->skin);
     Entity *npc_e = WorldGetEntity(world, npc->entity);
     npc_e->type = EntityType_NPC;
-    npc->anim_time = 0.0f;
+    EntityPlayAnimation(renderer, npc_e, npc->walk_animation, 0.0f);
     npc->walk_speed = 1.0f;
 }
 
@@ -134,7 +215,8 @@ void UpdateEnemy(GameData *game_data, Entity *e) {
         if(!e->collided) { // On enter...
             e->health--;
             if(e->health <= 0) {
-                e->flags |= EntityFlag_Hidden;
+                WorldDestroyEntity(&game_data->world, e->id);
+                return;
             }
             e->color = (Vec3){1.0f, 1.0f, 1.0f};
         }
@@ -149,35 +231,32 @@ void UpdateEnemy(GameData *game_data, Entity *e) {
 void UpdateNPC(World *world, NPC *npc, f32 delta_time) {
     Entity *e = WorldGetEntity(world, npc->entity);
 
-    npc->anim_time = fmod(npc->anim_time + delta_time, npc->walk_animation.length);
-    AnimationEvaluate(&npc->walk_animation, e->skeleton, npc->anim_time);
-
     Vec3 diff = vec3_sub(npc->destination, e->transform.translation);
     npc->distance_to_dest = vec3_length(diff);
 
     npc->walk_speed = 1.3f;
 
     if(npc->distance_to_dest > 0.1f) {
-        Vec3 dir = vec3_normalize(diff);
+        Vec3 dir = fast_vec3_normalize(diff);
         e->transform.translation = vec3_add(vec3_fmul(dir, npc->walk_speed * delta_time), e->transform.translation);
     } else {
         // Get new dest
         static u32 i = 0;
         if(i == 0) {
             npc->destination = (Vec3) {0.0f, 0.0f, 0.0f};
-            e->transform.rotation = quat_lookat(e->transform.translation, npc->destination, (Vec3){0.0f, 1.0f, 0.0f});
+            e->transform.rotation = fast_quat_lookat(e->transform.translation, npc->destination, (Vec3){0.0f, 1.0f, 0.0f});
             i++;
         } else if(i == 1) {
             npc->destination = (Vec3) {5.0f, 0.0f, 0.0f};
-            e->transform.rotation = quat_lookat(e->transform.translation, npc->destination, (Vec3){0.0f, 1.0f, 0.0f});
+            e->transform.rotation = fast_quat_lookat(e->transform.translation, npc->destination, (Vec3){0.0f, 1.0f, 0.0f});
             i++;
         } else if(i == 2) {
             npc->destination = (Vec3) {5.0f, 0.0f, -5.0f};
-            e->transform.rotation = quat_lookat(e->transform.translation, npc->destination, (Vec3){0.0f, 1.0f, 0.0f});
+            e->transform.rotation = fast_quat_lookat(e->transform.translation, npc->destination, (Vec3){0.0f, 1.0f, 0.0f});
             i++;
         } else if (i == 3) {
             npc->destination = (Vec3) {0.0f, 0.0f, -5.0f};
-            e->transform.rotation = quat_lookat(e->transform.translation, npc->destination, (Vec3){0.0f, 1.0f, 0.0f});
+            e->transform.rotation = fast_quat_lookat(e->transform.translation, npc->destination, (Vec3){0.0f, 1.0f, 0.0f});
             i = 0;
         }
     }
@@ -1,6 +1,6 @@
 #pragma once
 
-typedef u32 EntityID;
+typedef sPoolHandle EntityID;
 
 typedef u32 EntityFlags;
 
@@ -9,6 +9,28 @@ typedef enum EntityFlag {
     EntityFlag_Hidden   = 1 << 1, // Don't draw
 } EntityFlag;
 
+// Animation level of detail, picked from the distance to the camera by WorldAnimateEntities
+typedef enum AnimationLOD {
+    AnimationLOD_Full,      // Evaluated every frame
+    AnimationLOD_Throttled, // Evaluated every AnimationLODSettings.interval frames, blended in between
+    AnimationLOD_Frozen,    // Not updated, only the time moves
+    AnimationLOD_Count,
+} AnimationLOD;
+
+// Most animations playing at once on an entity, the base and the layers blended on top of it
+#define ENTITY_ANIMATION_LAYERS 3
+
+// One layer of the animation of an entity, see AnimationLayer
+typedef struct EntityAnimation {
+    AnimationHandle animation;
+    f32 time;
+    f32 weight;
+    f32 weight_speed; // Weight change per second, the weight is clamped to [0, 1]
+    AnimationBlendMode mode;
+    const f32 *joint_weights; // Per-joint mask, NULL for every joint. Not owned by the entity
+    AnimationSampler sampler;
+} EntityAnimation;
+
 typedef enum RenderingType {
     RenderingType_StaticMesh,
     RenderingType_SkinnedMesh,
@@ -31,6 +53,7 @@ typedef enum Direction {
 
 typedef struct Entity {
     EntityID id;
+    u32 alive_index; // Position in World.alive
     EntityFlags flags;
     Transform transform;
     Vec3 color;
@@ -42,7 +65,10 @@ typedef struct Entity {
         };
         struct {
             SkinnedMeshHandle skinned_mesh;
-            Transform *skeleton;
+            u32 pose; // Instance index in the skin's poses
+            EntityAnimation animations[ENTITY_ANIMATION_LAYERS]; // Bottom to top, see EntityPlayAnimation
+            u32 animation_count; // 0 when the pose isn't animated
+            AnimationLOD animation_lod;
         };
     };
 
@@ -10,11 +10,14 @@ enum event_type {
 
 typedef u32 EventType;
 
+#define EVENT_QUEUE_CAPACITY 64
+
 typedef struct EventQueue {
     EventType *queue;
     u32 size;
     u32 capacity;
 } EventQueue;
 
+void EventQueueInit(EventQueue *event_queue, sArena *arena, u32 capacity);
 void EventPush(EventQueue *event_queue, EventType new);
 bool EventConsume(EventQueue *event_queue, EventType *result);
@@ -48,18 +48,33 @@ DLL_EXPORT u32 GameGetSize() {
 DLL_EXPORT void GameInit(GameData *game_data, Renderer *renderer, PlatformAPI *platform_api) {
     global_renderer = renderer;
     platform = platform_api;
+    sInternSetTable(platform_api->strings);
     
     ConsoleInit(&game_data->console);
     global_console = &game_data->console;
     sLogSetCallback(&ConsoleLogMessage);
     
     Leak_SetList(platform_api->DebugInfo);
+    sMemSetTagCounters(platform_api->memory_tags);
+    sInitPerf();
+    
+    // GameData lives in the permanent arena, so the queue survives reloads
+    if(!game_data->event_queue.queue) {
+        EventQueueInit(&game_data->event_queue, &platform_api->memory->permanent, EVENT_QUEUE_CAPACITY);
+    }
+    // Same for the settings changed from the console
+    if(game_data->animation_lod.interval == 0) {
+        game_data->animation_lod = (AnimationLODSettings){ANIMATION_LOD_THROTTLE_DISTANCE, ANIMATION_LOD_FREEZE_DISTANCE, ANIMATION_LOD_INTERVAL};
+    }
 }
 
 /// This is called ONCE before the first frame. Won't be called upon reloading.
 DLL_EXPORT void GameStart(GameData *game_data) {
     
-    WorldInit(&game_data->world, 128);
+    // Everything from the previous level is released at once
+    sArenaReset(&platform->memory->level);
+    
+    WorldInit(&game_data->world, &platform->memory->level, 128);
     game_data->light_dir = (Vec3){0.67f, -0.67f, 0.1f};
     game_data->cos = 0;
     RendererSetSunDirection(global_renderer, vec3_normalize(vec3_fmul(game_data->light_dir, -1.0)));
@@ -68,6 +83,7 @@ DLL_EXPORT void GameStart(GameData *game_data) {
     
     game_data->mesh_quad = LoadQuad(global_renderer);
     game_data->mesh_cube = LoadCube(global_renderer);
+    game_data->mesh_sword = MakeCuboid(global_renderer, (Vec3){-.1f, -.1f, .2f}, (Vec3){.1f, .1f, 1.f});
 
     // @Todo : maybe this shouldn't be an entity?
     for(i32 x = -5; x < 5; x++) {
@@ -85,23 +101,36 @@ DLL_EXPORT void GameStart(GameData *game_data) {
     game_data->player = CreatePlayer(&game_data->world, game_data->mesh_cube);
 
     game_data->enemy_count = 5;
-    game_data->enemies = sCalloc(game_data->enemy_count, sizeof(EntityID));
+    game_data->enemies = sArenaPushArray(&platform->memory->level, game_data->enemy_count, EntityID);
     for(u32 i = 0; i < game_data->enemy_count; i++) {
         game_data->enemies[i] = CreateEnemy(&game_data->world, game_data->mesh_cube);
     }
-    game_data->sword = CreateSword(&game_data->world);
+    game_data->sword = CreateSword(&game_data->world, game_data->mesh_sword);
 
     CreateNPC(&game_data->world, global_renderer, platform, &game_data->npc);
+    game_data->crowd_count = 0;
+    game_data->baked_walk = 0;
+    game_data->baked_crowd = 0;
+    game_data->baked_crowd_time = 0.0f;
+}
+
+/// Releases the renderer resources loaded by GameStart
+internal void GameUnloadLevel(GameData *game_data) {
+    WorldDestroy(&game_data->world);
+    // The crowd draws the NPC's skin
+    RendererDestroyBakedCrowd(global_renderer, game_data->baked_crowd);
+    RendererDestroyBakedAnimation(global_renderer, game_data->baked_walk);
+    RendererDestroyMesh(global_renderer, game_data->mesh_quad);
+    RendererDestroyMesh(global_renderer, game_data->mesh_cube);
+    RendererDestroyMesh(global_renderer, game_data->mesh_sword);
+    RendererDestroySkin(global_renderer, game_data->npc.skin);
+    RendererDestroyAnimationLibrary(global_renderer, game_data->npc.animations);
 }
 
 /// Do deallocation here
+/// The renderer is destroyed before this is called, it releases the remaining meshes, skins and animations
 DLL_EXPORT void GameEnd(GameData *game_data) {
-    sFree(game_data->enemies);
-    if(game_data->event_queue.queue) {
-        sFree(game_data->event_queue.queue);
-    }
     WorldDestroy(&game_data->world);
-    DestroyAnimation(&game_data->npc.walk_animation);
 }
 
 internal void FPSCamera(Camera *camera, Input *input, bool is_free_cam) {
@@ -119,7 +148,7 @@ internal void FPSCamera(Camera *camera, Input *input, bool is_free_cam) {
     
     camera->forward = spherical_to_carthesian(camera->spherical_coordinates);
     
-    Vec3 flat_forward = vec3_normalize((Vec3){camera->forward.x, 0.0f, camera->forward.z});
+    Vec3 flat_forward = fast_vec3_normalize((Vec3){camera->forward.x, 0.0f, camera->forward.z});
     Vec3 right = vec3_cross(flat_forward, (Vec3){0.0f, 1.0f, 0.0f});
     
     // --------------
@@ -178,6 +207,7 @@ DLL_EXPORT void GameLoop(float delta_time, GameData *game_data, Input *input) {
                     platform->RequestExit();
                 } break;
                 case(EVENT_TYPE_RESTART): {
+                    GameUnloadLevel(game_data);
                     GameStart(game_data);
                 } break;
                 case(EVENT_TYPE_RELOAD): {
@@ -238,7 +268,7 @@ DLL_EXPORT void GameLoop(float delta_time, GameData *game_data, Input *input) {
             Mat4 cam;
             Vec3 camera_offset = {0.0f, 10.0f, 5.0f};
             game_data->camera.position = vec3_add(player->transform.translation, camera_offset);
-            game_data->camera.forward  = vec3_normalize(vec3_sub(game_data->camera.position, player->transform.translation));
+            game_data->camera.forward  = fast_vec3_normalize(vec3_sub(game_data->camera.position, player->transform.translation));
             mat4_look_at(player->transform.translation, game_data->camera.position, (Vec3){0.0f, 1.0f, 0.0f}, cam);
             RendererSetCamera(global_renderer, cam, game_data->camera.position);
         } else {
@@ -246,6 +276,18 @@ DLL_EXPORT void GameLoop(float delta_time, GameData *game_data, Input *input) {
         }
     }   
 
+    // After the camera, the animation LODs depend on it
+    sBeginTimer("Animation");
+    WorldAnimateEntities(&game_data->world, global_renderer, &game_data->animation_lod, delta_time, 0);
+    sEndTimer("Animation");
+    
+    // No CPU work per instance, the whole crowd is one draw
+    if(game_data->baked_crowd) {
+        const Animation *walk = sPoolGet(&global_renderer->animations, game_data->npc.walk_animation);
+        game_data->baked_crowd_time = walk ? AnimationWrapTime(game_data->baked_crowd_time + delta_time, walk->length) : 0.0f;
+        PushBakedCrowd(&global_renderer->scene_pushbuffer, game_data->baked_crowd, game_data->baked_crowd_time, (Vec3){1.0f, 1.0f, 1.0f});
+    }
+
 
     if(game_data->show_shadowmap)
         UIPushTexture(&global_renderer->ui_pushbuffer, global_renderer->backend->shadowmap_pass.texture, 0, global_renderer->height - 200, 200, 200);
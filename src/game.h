@@ -8,9 +8,9 @@ typedef struct Camera {
 
 typedef struct NPC {
     EntityID entity;
-    Animation walk_animation;
-
-    f32 anim_time;
+    SkinnedMeshHandle skin;
+    AnimationLibraryHandle animations;
+    AnimationHandle walk_animation;
     
     Vec3 destination;
     f32 walk_speed;
@@ -26,11 +26,14 @@ typedef struct GameData {
     Camera camera;
     bool is_free_cam;
     
+    AnimationLODSettings animation_lod; // Set from the console with "animlod"
+    
     Vec3 light_dir;
     f32 cos;
     
     MeshHandle mesh_quad;
     MeshHandle mesh_cube;
+    MeshHandle mesh_sword;
 
     EntityID ground;
     EntityID player;
@@ -40,6 +43,11 @@ typedef struct GameData {
     EntityID *enemies;
 
     NPC npc;
+    u32 crowd_count; // Copies of the NPC spawned by the "animbench" command
+    // Background crowd of the "bakedcrowd" command, playing the baked walk cycle
+    BakedAnimationHandle baked_walk;
+    BakedCrowdHandle baked_crowd;
+    f32 baked_crowd_time;
     
     f32 attack_time;
 
@@ -11,6 +11,21 @@ typedef void PlatformGetInstanceExtensions_t(u32 *count, const char **extensions
 typedef void PlatformSetCaptureMouse_t(bool val);
 typedef void PlatformRequestExit_t();
 typedef void PlatformRequestReload_t();
+typedef f64 PlatformGetTime_t(); // Seconds from an arbitrary origin, for timings
+
+// Work queue shared by the worker threads. Work is only added from the main thread.
+// CompleteAllWork has the main thread help until the queue is empty, nothing is left running after it returns.
+typedef void PlatformWorkCallback_t(void *data);
+typedef void PlatformAddWork_t(PlatformWorkCallback_t *callback, void *data);
+typedef void PlatformCompleteAllWork_t();
+
+// The platform reserves one block at startup and splits it into these arenas.
+// The block never moves, so pointers stay valid through hot reloads.
+typedef struct PlatformMemory {
+    sArena permanent; // Lives as long as the program. GameData and the Renderer are in here
+    sArena level;     // Reset by GameStart when the level is (re)started
+    sArena frame;     // Reset at the end of each frame by RendererDrawFrame
+} PlatformMemory;
 
 typedef struct PlatformAPI {
     PlatformReadBinary_t *ReadBinary;
@@ -19,7 +34,14 @@ typedef struct PlatformAPI {
     PlatformSetCaptureMouse_t *SetCaptureMouse;
     PlatformRequestExit_t *RequestExit;
     PlatformRequestReload_t *RequestReload;
+    PlatformAddWork_t *AddWork;
+    PlatformCompleteAllWork_t *CompleteAllWork;
+    PlatformGetTime_t *GetTime;
+    u32 worker_count; // Threads running the queued work, not counting the main thread
     void *DebugInfo;
+    MemTagCounters *memory_tags;
+    sInternTable *strings;
+    PlatformMemory *memory;
 } PlatformAPI;
 
 #define MOUSE_LEFT 1
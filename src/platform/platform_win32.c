@@ -14,11 +14,34 @@
 #include "renderer/renderer_api.h"
 #include "game_api.h"
 
+#define PERMANENT_MEMORY_SIZE Megabytes(64)
+#define LEVEL_MEMORY_SIZE Megabytes(256)
+#define FRAME_MEMORY_SIZE Megabytes(64)
+#define INTERN_TABLE_CAPACITY 8192 // Strings interned by the whole program : glTF names, console commands, perf timers
+#define INTERN_TABLE_BYTES Kilobytes(256)
+#define WORK_QUEUE_CAPACITY 256
+#define MAX_WORKER_COUNT 15
+
 typedef struct ShaderCode {
     const char *spv_path;
     FILETIME last_write_time;
 } ShaderCode;
 
+typedef struct WorkQueueEntry {
+    PlatformWorkCallback_t *callback;
+    void *data;
+} WorkQueueEntry;
+
+// Ring buffer filled by the main thread, the workers take the entries with a compare exchange on next_read
+typedef struct WorkQueue {
+    volatile LONG next_write;
+    volatile LONG next_read;
+    volatile LONG completion_goal;
+    volatile LONG completion_count;
+    HANDLE semaphore;
+    WorkQueueEntry entries[WORK_QUEUE_CAPACITY];
+} WorkQueue;
+
 /* GLOBALS */
 
 global HANDLE stderrHandle;
@@ -26,9 +49,11 @@ global bool mouse_captured; // @TODO this probably shouldn't be a global
 global Renderer *renderer;  // Global to have it in the window proc
 global PlatformWindow global_window;
 global PlatformAPI platform_api;
+global PlatformMemory platform_memory;
 global GameData *game_data;
 global bool running;
 global Module game_module = {0};
+global WorkQueue work_queue;
 
 /* FUNCTIONS */
 void Win32GameLoadFunctions(Module *dll) {
@@ -60,6 +85,8 @@ void PlatformRequestExit() {
 }
 
 void PlatformRequestReload() {
+    // The queued callbacks live in the module
+    platform_api.CompleteAllWork();
     pfn_RendererDestroyBackend(renderer);
     Win32CloseModule(&game_module);
     Win32LoadModule(&game_module, "game");
@@ -75,6 +102,13 @@ i64 PlatformGetTicks() {
     return ticks.QuadPart;
 }
 
+f64 PlatformGetTime() {
+    LARGE_INTEGER ticks, frequency;
+    QueryPerformanceCounter(&ticks);
+    QueryPerformanceFrequency(&frequency);
+    return (f64)ticks.QuadPart / (f64)frequency.QuadPart;
+}
+
 void PlatformSetCaptureMouse(bool val) {
     if(mouse_captured == val)
         return;
@@ -132,6 +166,67 @@ void PlatformReadBinary(const char *path, i64 *file_size, u32 *result) {
     fclose(file);
 }
 
+void PlatformAddWork(PlatformWorkCallback_t *callback, void *data) {
+    WorkQueue *queue = &work_queue;
+    LONG next_write = (queue->next_write + 1) % WORK_QUEUE_CAPACITY;
+    ASSERT_MSG(next_write != queue->next_read, "Work queue is full");
+    queue->entries[queue->next_write] = (WorkQueueEntry){callback, data};
+    queue->completion_goal++;
+    // The entry must be visible before the workers can see the new write index
+    MemoryBarrier();
+    queue->next_write = next_write;
+    ReleaseSemaphore(queue->semaphore, 1, NULL);
+}
+
+// Returns false if there was nothing to do
+internal bool Win32DoNextWork(WorkQueue *queue) {
+    LONG next_read = queue->next_read;
+    if(next_read == queue->next_write) {
+        return false;
+    }
+    LONG new_next_read = (next_read + 1) % WORK_QUEUE_CAPACITY;
+    if(InterlockedCompareExchange(&queue->next_read, new_next_read, next_read) == next_read) {
+        WorkQueueEntry entry = queue->entries[next_read];
+        entry.callback(entry.data);
+        InterlockedIncrement(&queue->completion_count);
+    }
+    return true;
+}
+
+void PlatformCompleteAllWork() {
+    WorkQueue *queue = &work_queue;
+    while(queue->completion_count != queue->completion_goal) {
+        Win32DoNextWork(queue);
+    }
+    queue->completion_goal = 0;
+    queue->completion_count = 0;
+}
+
+DWORD WINAPI Win32WorkerThreadProc(LPVOID param) {
+    WorkQueue *queue = (WorkQueue *)param;
+    while(true) {
+        if(!Win32DoNextWork(queue)) {
+            WaitForSingleObjectEx(queue->semaphore, INFINITE, FALSE);
+        }
+    }
+    return 0;
+}
+
+// One worker per logical core, the main thread takes the last one
+internal u32 Win32StartWorkers(WorkQueue *queue) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    u32 worker_count = info.dwNumberOfProcessors > 1 ? info.dwNumberOfProcessors - 1 : 0;
+    worker_count = MIN(worker_count, MAX_WORKER_COUNT);
+    
+    queue->semaphore = CreateSemaphoreEx(NULL, 0, WORK_QUEUE_CAPACITY, NULL, 0, SEMAPHORE_ALL_ACCESS);
+    for(u32 i = 0; i < worker_count; i++) {
+        HANDLE thread = CreateThread(NULL, 0, Win32WorkerThreadProc, queue, 0, NULL);
+        CloseHandle(thread);
+    }
+    return worker_count;
+}
+
 // @TODO : Handle UTF8
 void Win32Log(const char *message, u8 level) {
     unsigned long charsWritten;
@@ -233,14 +328,43 @@ i32 WINAPI WinMain(HINSTANCE instance, HINSTANCE prev_instance, PSTR cmd_line, I
     platform_api.SetCaptureMouse = &PlatformSetCaptureMouse;
     platform_api.RequestExit = &PlatformRequestExit;
     platform_api.RequestReload = &PlatformRequestReload;
+    platform_api.AddWork = &PlatformAddWork;
+    platform_api.CompleteAllWork = &PlatformCompleteAllWork;
+    platform_api.GetTime = &PlatformGetTime;
+    platform_api.worker_count = Win32StartWorkers(&work_queue);
     platform_api.DebugInfo = Leak_GetList();
+    platform_api.memory_tags = sMemGetTagCounters();
+    
+    // All of the game's memory comes from this block
+    const u64 memory_size = PERMANENT_MEMORY_SIZE + LEVEL_MEMORY_SIZE + FRAME_MEMORY_SIZE;
+#ifdef DEBUG
+    // Fixed address so pointers are the same from one run to the other
+    LPVOID memory_base = (LPVOID)Gigabytes(2048);
+#else
+    LPVOID memory_base = NULL;
+#endif
+    void *memory = VirtualAlloc(memory_base, memory_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if(!memory) {
+        sError("WIN32 : Unable to allocate %llu bytes of memory", memory_size);
+        return -1;
+    }
+    sArena memory_block = sArenaCreateFromMemory(memory, memory_size);
+    platform_memory.permanent = sArenaCarve(&memory_block, PERMANENT_MEMORY_SIZE);
+    platform_memory.level = sArenaCarve(&memory_block, LEVEL_MEMORY_SIZE);
+    platform_memory.frame = sArenaCarve(&memory_block, FRAME_MEMORY_SIZE);
+    platform_api.memory = &platform_memory;
+    
+    sInternTable *strings = sArenaPushArray(&platform_memory.permanent, 1, sInternTable);
+    *strings = sInternCreate(&platform_memory.permanent, INTERN_TABLE_CAPACITY, INTERN_TABLE_BYTES);
+    sInternSetTable(strings);
+    platform_api.strings = strings;
     
     Win32LoadModule(&game_module, "game");
     Win32LoadFunctions(&game_module);
     
-    game_data = sCalloc(1, pfn_GameGetSize());
-    renderer = sCalloc(1, pfn_GetRendererSize());
-    Input *input = sCalloc(1, sizeof(Input));
+    game_data = sArenaPush(&platform_memory.permanent, pfn_GameGetSize());
+    renderer = sArenaPush(&platform_memory.permanent, pfn_GetRendererSize());
+    Input *input = sArenaPushArray(&platform_memory.permanent, 1, Input);
     
     pfn_GameInit(game_data, renderer, &platform_api);
     pfn_RendererInit(renderer, &platform_api, &global_window);
@@ -329,6 +453,7 @@ i32 WINAPI WinMain(HINSTANCE instance, HINSTANCE prev_instance, PSTR cmd_line, I
         
         pfn_GameLoop(delta_time, game_data, input);
         pfn_RendererDrawFrame(renderer);
+        Leak_EndFrame();
         
         {
             // 60 fps cap
@@ -362,9 +487,7 @@ i32 WINAPI WinMain(HINSTANCE instance, HINSTANCE prev_instance, PSTR cmd_line, I
     pfn_RendererDestroy(renderer);
     pfn_GameEnd(game_data);
     
-    sFree(renderer);
-    sFree(game_data);
-    sFree(input);
+    VirtualFree(memory, 0, MEM_RELEASE);
     
     DestroyWindow(global_window.hwnd);
     ReleaseDC(global_window.hwnd, global_window.dc);
@@ -1,13 +1,41 @@
 
-void LoadAnimation(Animation *result, const GLTF *gltf) {
-    
-    ASSERT_MSG(gltf->animation_count == 1, "ASSERT : More than one animation in GLTF, this isn't handled yet.");
+// Keys closer than this fraction of the interval to the uniform grid count as evenly spaced
+#define ANIMATION_UNIFORM_TOLERANCE 0.001f
+
+// Sets the interval if the times are evenly spaced, 0 otherwise
+internal void AnimationFindInterval(const f32 *times, const u32 count, f32 *interval, f32 *inv_interval) {
+    *interval = 0.0f;
+    *inv_interval = 0.0f;
+    if(count < 2)
+        return;
     
-    GLTFAnimation *anim = &gltf->animations[0];
+    const f32 start = times[0];
+    const f32 step = (times[count - 1] - start) / (count - 1);
+    if(step <= 0.0f)
+        return;
+    for(u32 i = 1; i < count - 1; i++) {
+        if(fabsf(times[i] - (start + i * step)) > step * ANIMATION_UNIFORM_TOLERANCE)
+            return;
+    }
+    *interval = step;
+    *inv_interval = 1.0f / step;
+}
+
+// Exporters usually bake one key per frame
+internal void AnimationTrackFindInterval(AnimationTrack *track) {
+    AnimationFindInterval(track->key_times, track->key_count, &track->key_interval, &track->inv_key_interval);
+}
+
+// Loads the clip at index in the glTF's animations
+void LoadAnimation(Animation *result, const GLTF *gltf, const u32 index) {
+    ASSERT(index < gltf->animation_count);
+    GLTFAnimation *anim = &gltf->animations[index];
     
     result->track_count = anim->channel_count;
-    result->tracks = sCalloc(result->track_count, sizeof(AnimationTrack));
+    result->tracks = sCallocTagged(result->track_count, sizeof(AnimationTrack), MEM_TAG_ANIMATION);
     result->length = 0;
+    result->frame_count = 0;
+    result->frame_times = NULL;
     
     sLog("LOAD - Animation - %d tracks", result->track_count);
     
@@ -43,31 +71,505 @@ void LoadAnimation(Animation *result, const GLTF *gltf) {
         GLTFAccessor *input = &gltf->accessors[sampler->input];
         
         track->key_count = input->count;
-        track->key_times = sCalloc(track->key_count, sizeof(f32));
+        track->key_times = sCallocTagged(track->key_count, sizeof(f32), MEM_TAG_ANIMATION);
         GLTFCopyAccessor(gltf, sampler->input, track->key_times, 0, sizeof(f32));
         
         GLTFAccessor *output_acc = &gltf->accessors[sampler->output];
         
-        track->keys = sCalloc(output_acc->count, key_size);
+        track->keys = sCallocTagged(output_acc->count, key_size, MEM_TAG_ANIMATION);
         GLTFCopyAccessor(gltf, sampler->output, track->keys, 0, key_size);
         ASSERT_MSG(output_acc->count == input->count, "Gltf has a different amount of key times and data keys. Blender has a bug that does this apparently...");
         
         if (result->length < track->key_times[track->key_count - 1]) 
             result->length = track->key_times[track->key_count - 1];
         
+        AnimationTrackFindInterval(track);
     }
 }
 
+// Each array is aligned on 16 bytes in the storage
+#define ANIMATION_STORAGE_ALIGNMENT 16
+
+internal u64 AnimationStorageArraySize(const u64 size) {
+    return size + ANIMATION_STORAGE_ALIGNMENT;
+}
+
+// Bytes needed by AnimationMoveToStorage
+u64 AnimationStorageSize(const Animation *anim) {
+    u64 result = AnimationStorageArraySize(anim->track_count * sizeof(AnimationTrack));
+    result += AnimationStorageArraySize(anim->frame_count * sizeof(f32));
+    for(u32 i = 0; i < anim->track_count; i++) {
+        const AnimationTrack *track = &anim->tracks[i];
+        if(track->key_frames) {
+            result += AnimationStorageArraySize(track->key_count * sizeof(u16));
+            result += AnimationStorageArraySize(track->key_count * 3 * sizeof(u16));
+        } else {
+            const u32 key_size = track->type == ANIM_TYPE_QUATERNION ? sizeof(Quat) : sizeof(Vec3);
+            result += AnimationStorageArraySize(track->key_count * sizeof(f32));
+            result += AnimationStorageArraySize(track->key_count * key_size);
+        }
+    }
+    return result;
+}
+
+// Copies a heap array to the storage and frees it
+internal void *AnimationMoveArray(sArena *storage, void *array, const u64 size) {
+    if(!array) {
+        return NULL;
+    }
+    void *result = sArenaPushAligned(storage, size, ANIMATION_STORAGE_ALIGNMENT);
+    memcpy(result, array, size);
+    sFree(array);
+    return result;
+}
+
+// Moves the tracks and keys to storage, next to the ones of the other clips of the same file.
+// The animation doesn't own its arrays anymore, don't call DestroyAnimation on it.
+void AnimationMoveToStorage(Animation *anim, sArena *storage) {
+    for(u32 i = 0; i < anim->track_count; i++) {
+        AnimationTrack *track = &anim->tracks[i];
+        if(track->key_frames) {
+            track->key_frames = AnimationMoveArray(storage, track->key_frames, track->key_count * sizeof(u16));
+            track->keys = AnimationMoveArray(storage, track->keys, track->key_count * 3 * sizeof(u16));
+        } else {
+            const u32 key_size = track->type == ANIM_TYPE_QUATERNION ? sizeof(Quat) : sizeof(Vec3);
+            track->key_times = AnimationMoveArray(storage, track->key_times, track->key_count * sizeof(f32));
+            track->keys = AnimationMoveArray(storage, track->keys, track->key_count * key_size);
+        }
+    }
+    anim->tracks = AnimationMoveArray(storage, anim->tracks, anim->track_count * sizeof(AnimationTrack));
+    anim->frame_times = AnimationMoveArray(storage, anim->frame_times, anim->frame_count * sizeof(f32));
+}
+
 void DestroyAnimation(Animation *anim) {
     for(u32 i = 0; i < anim->track_count; i++) {
-        sFree(anim->tracks[i].keys);
-        sFree(anim->tracks[i].key_times);
+        AnimationTrack *track = &anim->tracks[i];
+        sFree(track->keys);
+        if(track->key_times)
+            sFree(track->key_times);
+        if(track->key_frames)
+            sFree(track->key_frames);
     }
     sFree(anim->tracks);
+    if(anim->frame_times)
+        sFree(anim->frame_times);
 }
 
+// Last time at or before time, searched in [first, last]. times[first] <= time is assumed.
+internal u32 AnimationSearchKey(const f32 *times, const f32 time, u32 first, u32 last) {
+    while(first < last) {
+        u32 middle = (first + last + 1) / 2;
+        if(times[middle] <= time) {
+            first = middle;
+        } else {
+            last = middle - 1;
+        }
+    }
+    return first;
+}
+
+// Above this many keys from the cursor, a binary search is cheaper than walking
+#define ANIMATION_CURSOR_MAX_STEPS 4
+
+// Key k so that times[k] <= time < times[k + 1], time must be inside [times[0], times[count - 1][
+// inv_interval is 0 for irregular times. cursor is the key found last time and can be NULL
+internal u32 AnimationFindKey(const f32 *times, const u32 count, const f32 inv_interval, const f32 time, u32 *cursor) {
+    const u32 last = count - 2;
+    if(inv_interval > 0.0f) {
+        u32 key = (u32)((time - times[0]) * inv_interval);
+        return key > last ? last : key;
+    }
+    
+    if(cursor == NULL) {
+        return AnimationSearchKey(times, time, 0, last);
+    }
+    
+    u32 key = *cursor;
+    if(key > last || time < times[key]) {
+        // Looped or seeked backwards
+        key = AnimationSearchKey(times, time, 0, key > last ? last : key);
+    } else {
+        u32 steps = 0;
+        while(key < last && time >= times[key + 1]) {
+            if(++steps > ANIMATION_CURSOR_MAX_STEPS) {
+                key = AnimationSearchKey(times, time, key, last);
+                break;
+            }
+            key++;
+        }
+    }
+    *cursor = key;
+    return key;
+}
+
+internal u32 AnimationTrackFindKey(const AnimationTrack *track, const f32 time, u32 *cursor) {
+    return AnimationFindKey(track->key_times, track->key_count, track->inv_key_interval, time, cursor);
+}
+
+// Same as AnimationSearchKey on the frames of a compressed track
+internal u32 AnimationSearchFrame(const u16 *frames, const u32 frame, u32 first, u32 last) {
+    while(first < last) {
+        u32 middle = (first + last + 1) / 2;
+        if(frames[middle] <= frame) {
+            first = middle;
+        } else {
+            last = middle - 1;
+        }
+    }
+    return first;
+}
+
+// Key k of a compressed track so that key_frames[k] <= frame < key_frames[k + 1]
+internal u32 AnimationTrackFindFrameKey(const AnimationTrack *track, const u32 frame, u32 *cursor) {
+    const u32 last = track->key_count - 2;
+    if(cursor == NULL) {
+        return AnimationSearchFrame(track->key_frames, frame, 0, last);
+    }
+    
+    u32 key = *cursor;
+    if(key > last || frame < track->key_frames[key]) {
+        key = AnimationSearchFrame(track->key_frames, frame, 0, key > last ? last : key);
+    } else {
+        u32 steps = 0;
+        while(key < last && frame >= track->key_frames[key + 1]) {
+            if(++steps > ANIMATION_CURSOR_MAX_STEPS) {
+                key = AnimationSearchFrame(track->key_frames, frame, key, last);
+                break;
+            }
+            key++;
+        }
+    }
+    *cursor = key;
+    return key;
+}
+
+// Value of the track at time, used when resampling
+internal void AnimationTrackSample(const AnimationTrack *track, f32 time, void *result) {
+    u32 key_1 = 0; u32 key_2 = 0;
+    f32 norm_t = 0.0f;
+    if(time >= track->key_times[track->key_count - 1]) {
+        key_1 = key_2 = track->key_count - 1;
+    } else if(time > track->key_times[0]) {
+        key_1 = AnimationTrackFindKey(track, time, NULL);
+        key_2 = key_1 + 1;
+        norm_t = (time - track->key_times[key_1]) / (track->key_times[key_2] - track->key_times[key_1]);
+    }
+    
+    if(track->type == ANIM_TYPE_QUATERNION) {
+        Quat *keys = (Quat *)track->keys;
+        *(Quat *)result = key_1 == key_2 ? keys[key_1] : quat_slerp(keys[key_1], keys[key_2], norm_t);
+    } else {
+        ASSERT(track->type == ANIM_TYPE_VEC3);
+        Vec3 *keys = (Vec3 *)track->keys;
+        *(Vec3 *)result = key_1 == key_2 ? keys[key_1] : vec3_lerp(keys[key_1], keys[key_2], norm_t);
+    }
+}
+
+// Replaces the keys of every track with keys evenly spaced at rate keys per second.
+// The first and last keys are kept, so a track is never shortened, and the key lookup becomes a multiply.
+void AnimationResample(Animation *anim, const f32 rate) {
+    ASSERT(rate > 0.0f);
+    ASSERT_MSG(anim->frame_times == NULL, "Compressed animations can't be resampled");
+    for(u32 i = 0; i < anim->track_count; i++) {
+        AnimationTrack *track = &anim->tracks[i];
+        if(track->key_count < 2)
+            continue;
+        
+        const f32 start = track->key_times[0];
+        const f32 duration = track->key_times[track->key_count - 1] - start;
+        if(duration <= 0.0f)
+            continue;
+        const u32 key_count = (u32)ceilf(duration * rate) + 1;
+        const f32 interval = duration / (key_count - 1);
+        const u32 key_size = track->type == ANIM_TYPE_QUATERNION ? sizeof(Quat) : sizeof(Vec3);
+        
+        f32 *key_times = sCallocTagged(key_count, sizeof(f32), MEM_TAG_ANIMATION);
+        u8 *keys = sCallocTagged(key_count, key_size, MEM_TAG_ANIMATION);
+        for(u32 k = 0; k < key_count; k++) {
+            key_times[k] = k == key_count - 1 ? track->key_times[track->key_count - 1] : start + k * interval;
+            AnimationTrackSample(track, key_times[k], keys + k * key_size);
+        }
+        
+        sFree(track->key_times);
+        sFree(track->keys);
+        track->key_count = key_count;
+        track->key_times = key_times;
+        track->keys = keys;
+        track->key_interval = interval;
+        track->inv_key_interval = 1.0f / interval;
+    }
+}
+
+// --------
+// Compression
+// Keys that the interpolation of their neighbours reproduces are removed, the remaining keys are quantized to 48 bits :
+// - rotations keep their three smallest components on 15 bits, the largest is rebuilt from the unit length
+// - translations and scales are quantized to 16 bits per component in the range of their track
+// Key times are replaced by the index of the frame in the time track shared by all the tracks. The tracks of an
+// exported clip are usually sampled at the same times, only the equal times are merged so no key moves.
+
+// Max error of a removed key, in quaternion components for rotations and in units for translations and scales
+#define ANIMATION_COMPRESS_QUAT_ERROR 0.0002f
+#define ANIMATION_COMPRESS_VEC3_ERROR 0.0002f
+
+// The 3 smallest components of a unit quaternion are in [-1/sqrt(2), 1/sqrt(2)]
+#define ANIMATION_QUAT_RANGE 0.70710678118f
+
+internal void AnimationEncodeQuat(const Quat q, u16 *key) {
+    const f32 c[4] = {q.x, q.y, q.z, q.w};
+    u32 largest = 0;
+    for(u32 i = 1; i < 4; i++) {
+        if(fabsf(c[i]) > fabsf(c[largest]))
+            largest = i;
+    }
+    // q and -q are the same rotation, the largest component is kept positive so its sign needn't be stored
+    const f32 sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+    u32 j = 0;
+    for(u32 i = 0; i < 4; i++) {
+        if(i == largest)
+            continue;
+        f32 v = c[i] * sign * (0.5f / ANIMATION_QUAT_RANGE) + 0.5f;
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        key[j++] = (u16)(v * 32767.0f + 0.5f);
+    }
+    key[0] |= (largest & 1) << 15;
+    key[1] |= (largest >> 1) << 15;
+}
+
+internal Quat AnimationDecodeQuat(const u16 *key) {
+    const u32 largest = (key[0] >> 15) | ((key[1] >> 15) << 1);
+    f32 c[4];
+    f32 sum = 0.0f;
+    u32 j = 0;
+    for(u32 i = 0; i < 4; i++) {
+        if(i == largest)
+            continue;
+        c[i] = (key[j++] & 0x7fff) * (2.0f * ANIMATION_QUAT_RANGE / 32767.0f) - ANIMATION_QUAT_RANGE;
+        sum += c[i] * c[i];
+    }
+    c[largest] = sqrtf(fmaxf(0.0f, 1.0f - sum));
+    return quat(c[0], c[1], c[2], c[3]);
+}
+
+internal void AnimationEncodeVec3(const AnimationTrack *track, const Vec3 v, u16 *key) {
+    const f32 c[3] = {v.x - track->range_min.x, v.y - track->range_min.y, v.z - track->range_min.z};
+    const f32 scale[3] = {track->range_scale.x, track->range_scale.y, track->range_scale.z};
+    for(u32 i = 0; i < 3; i++) {
+        f32 q = scale[i] > 0.0f ? c[i] / scale[i] + 0.5f : 0.0f;
+        key[i] = (u16)(q > 65535.0f ? 65535.0f : q);
+    }
+}
+
+internal Vec3 AnimationDecodeVec3(const AnimationTrack *track, const u16 *key) {
+    return (Vec3){
+        track->range_min.x + key[0] * track->range_scale.x,
+        track->range_min.y + key[1] * track->range_scale.y,
+        track->range_min.z + key[2] * track->range_scale.z,
+    };
+}
+
+internal Vec3 AnimationTrackGetVec3(const AnimationTrack *track, const u32 key) {
+    if(track->key_frames) {
+        return AnimationDecodeVec3(track, (u16 *)track->keys + key * 3);
+    }
+    return ((Vec3 *)track->keys)[key];
+}
+
+internal Quat AnimationTrackGetQuat(const AnimationTrack *track, const u32 key) {
+    if(track->key_frames) {
+        return AnimationDecodeQuat((u16 *)track->keys + key * 3);
+    }
+    return ((Quat *)track->keys)[key];
+}
+
+// Error of the uncompressed key k when interpolated between the keys a and b
+internal f32 AnimationTrackKeyError(const AnimationTrack *track, const u32 a, const u32 k, const u32 b) {
+    const f32 t = (track->key_times[k] - track->key_times[a]) / (track->key_times[b] - track->key_times[a]);
+    if(track->type == ANIM_TYPE_QUATERNION) {
+        const Quat *keys = (Quat *)track->keys;
+        Quat q = quat_slerp(keys[a], keys[b], t);
+        Quat r = keys[k];
+        const f32 sign = q.x * r.x + q.y * r.y + q.z * r.z + q.w * r.w < 0.0f ? -1.0f : 1.0f;
+        return fmaxf(fmaxf(fabsf(q.x - sign * r.x), fabsf(q.y - sign * r.y)), fmaxf(fabsf(q.z - sign * r.z), fabsf(q.w - sign * r.w)));
+    } else {
+        const Vec3 *keys = (Vec3 *)track->keys;
+        Vec3 d = vec3_sub(vec3_lerp(keys[a], keys[b], t), keys[k]);
+        return fmaxf(fabsf(d.x), fmaxf(fabsf(d.y), fabsf(d.z)));
+    }
+}
+
+// Keys needed to stay under max_error, greedily extending each segment as far as it goes. Returns the kept count.
+internal u32 AnimationTrackReduceKeys(const AnimationTrack *track, const f32 max_error, u32 *kept) {
+    const u32 last = track->key_count - 1;
+    
+    // Constant tracks keep a single key
+    bool constant = true;
+    for(u32 k = 1; k <= last && constant; k++) {
+        if(track->type == ANIM_TYPE_QUATERNION) {
+            Quat a = ((Quat *)track->keys)[0];
+            Quat b = ((Quat *)track->keys)[k];
+            const f32 sign = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f ? -1.0f : 1.0f;
+            constant = fabsf(a.x - sign * b.x) <= max_error && fabsf(a.y - sign * b.y) <= max_error &&
+                       fabsf(a.z - sign * b.z) <= max_error && fabsf(a.w - sign * b.w) <= max_error;
+        } else {
+            Vec3 d = vec3_sub(((Vec3 *)track->keys)[0], ((Vec3 *)track->keys)[k]);
+            constant = fabsf(d.x) <= max_error && fabsf(d.y) <= max_error && fabsf(d.z) <= max_error;
+        }
+    }
+    kept[0] = 0;
+    if(constant)
+        return 1;
+    
+    u32 kept_count = 1;
+    u32 a = 0;
+    while(a < last) {
+        u32 b = a + 1;
+        while(b < last) {
+            bool fits = true;
+            for(u32 k = a + 1; k <= b && fits; k++) {
+                fits = AnimationTrackKeyError(track, a, k, b + 1) <= max_error;
+            }
+            if(!fits)
+                break;
+            b++;
+        }
+        kept[kept_count++] = b;
+        a = b;
+    }
+    return kept_count;
+}
+
+internal int AnimationCompareTimes(const void *a, const void *b) {
+    const f32 ta = *(const f32 *)a;
+    const f32 tb = *(const f32 *)b;
+    return (ta > tb) - (ta < tb);
+}
+
+// Bytes of key data and key times
+internal u64 AnimationKeyBytes(const Animation *anim) {
+    u64 result = anim->frame_count * sizeof(f32);
+    for(u32 i = 0; i < anim->track_count; i++) {
+        const AnimationTrack *track = &anim->tracks[i];
+        if(track->key_frames) {
+            result += track->key_count * (sizeof(u16) + 3 * sizeof(u16));
+        } else {
+            const u32 key_size = track->type == ANIM_TYPE_QUATERNION ? sizeof(Quat) : sizeof(Vec3);
+            result += track->key_count * (sizeof(f32) + key_size);
+        }
+    }
+    return result;
+}
+
+// Converts every track to the compressed format, AnimationEvaluate decodes it directly
+void AnimationCompress(Animation *anim) {
+    ASSERT_MSG(anim->frame_times == NULL, "Animation is already compressed");
+    const u64 uncompressed_bytes = AnimationKeyBytes(anim);
+    
+    // Shared time track, the sorted times of all the tracks without duplicates
+    u32 time_count = 0;
+    for(u32 i = 0; i < anim->track_count; i++) {
+        time_count += anim->tracks[i].key_count;
+    }
+    f32 *times = sCalloc(time_count, sizeof(f32));
+    u32 offset = 0;
+    for(u32 i = 0; i < anim->track_count; i++) {
+        memcpy(times + offset, anim->tracks[i].key_times, anim->tracks[i].key_count * sizeof(f32));
+        offset += anim->tracks[i].key_count;
+    }
+    qsort(times, time_count, sizeof(f32), AnimationCompareTimes);
+    u32 frame_count = 0;
+    for(u32 i = 0; i < time_count; i++) {
+        if(frame_count == 0 || times[i] != times[frame_count - 1]) {
+            times[frame_count++] = times[i];
+        }
+    }
+    ASSERT_MSG(frame_count <= 65536, "Too many frames for the compressed animation format");
+    anim->frame_count = frame_count;
+    anim->frame_times = sCallocTagged(frame_count, sizeof(f32), MEM_TAG_ANIMATION);
+    memcpy(anim->frame_times, times, frame_count * sizeof(f32));
+    AnimationFindInterval(anim->frame_times, frame_count, &anim->frame_interval, &anim->inv_frame_interval);
+    sFree(times);
+    
+    for(u32 i = 0; i < anim->track_count; i++) {
+        AnimationTrack *track = &anim->tracks[i];
+        
+        u16 *frames = sCalloc(track->key_count, sizeof(u16));
+        for(u32 k = 0; k < track->key_count; k++) {
+            frames[k] = (u16)AnimationSearchKey(anim->frame_times, track->key_times[k], 0, frame_count - 1);
+        }
+        
+        u32 *kept = sCalloc(track->key_count, sizeof(u32));
+        const f32 max_error = track->type == ANIM_TYPE_QUATERNION ? ANIMATION_COMPRESS_QUAT_ERROR : ANIMATION_COMPRESS_VEC3_ERROR;
+        const u32 key_count = AnimationTrackReduceKeys(track, max_error, kept);
+        
+        u16 *key_frames = sCallocTagged(key_count, sizeof(u16), MEM_TAG_ANIMATION);
+        u16 *keys = sCallocTagged(key_count * 3, sizeof(u16), MEM_TAG_ANIMATION);
+        if(track->type == ANIM_TYPE_QUATERNION) {
+            for(u32 k = 0; k < key_count; k++) {
+                key_frames[k] = frames[kept[k]];
+                AnimationEncodeQuat(((Quat *)track->keys)[kept[k]], keys + k * 3);
+            }
+        } else {
+            ASSERT(track->type == ANIM_TYPE_VEC3);
+            const Vec3 *src = (Vec3 *)track->keys;
+            Vec3 min = src[kept[0]];
+            Vec3 max = src[kept[0]];
+            for(u32 k = 1; k < key_count; k++) {
+                const Vec3 v = src[kept[k]];
+                min = (Vec3){fminf(min.x, v.x), fminf(min.y, v.y), fminf(min.z, v.z)};
+                max = (Vec3){fmaxf(max.x, v.x), fmaxf(max.y, v.y), fmaxf(max.z, v.z)};
+            }
+            track->range_min = min;
+            track->range_scale = vec3_fmul(vec3_sub(max, min), 1.0f / 65535.0f);
+            for(u32 k = 0; k < key_count; k++) {
+                key_frames[k] = frames[kept[k]];
+                AnimationEncodeVec3(track, src[kept[k]], keys + k * 3);
+            }
+        }
+        sFree(kept);
+        sFree(frames);
+        
+        sFree(track->key_times);
+        sFree(track->keys);
+        track->key_times = NULL;
+        track->key_interval = 0.0f;
+        track->inv_key_interval = 0.0f;
+        track->key_count = key_count;
+        track->key_frames = key_frames;
+        track->keys = keys;
+    }
+    sLog("LOAD - Animation - Compressed keys from %llu to %llu bytes", uncompressed_bytes, AnimationKeyBytes(anim));
+}
+
+void AnimationSamplerInit(AnimationSampler *sampler, const Animation *animation) {
+    sampler->track_count = animation->track_count;
+    sampler->frame_cursor = 0;
+    sampler->cursors = sCallocTagged(animation->track_count, sizeof(u32), MEM_TAG_ANIMATION);
+}
+
+void AnimationSamplerDestroy(AnimationSampler *sampler) {
+    sFree(sampler->cursors);
+    sampler->cursors = NULL;
+    sampler->track_count = 0;
+}
+
+// Loops a playback time into [0, length). A clip of length 0 has a single key, its time stays at 0 where fmodf would
+// return NaN.
+f32 AnimationWrapTime(const f32 time, const f32 length) {
+    if(!(length > 0.0f)) {
+        return 0.0f;
+    }
+    f32 result = fmodf(time, length);
+    return result < 0.0f ? result + length : result;
+}
+
+// Rotations are interpolated in batches of this many tracks
+#define ANIMATION_SLERP_BATCH 64
+
 // Joints need to be in the same order as defined in the loaded Skin
-void AnimationEvaluate(const Animation *a, Transform *target, f32 time) {
+// sampler keeps the keys found between calls, it can be NULL for one off evaluations
+void AnimationEvaluate(const Animation *a, AnimationSampler *sampler, Pose *target, f32 time) {
+    ASSERT(sampler == NULL || sampler->track_count == a->track_count);
     
     // clamp time
     if (time > a->length)
@@ -75,58 +577,321 @@ void AnimationEvaluate(const Animation *a, Transform *target, f32 time) {
     if (time < 0)
         time = 0;
     
+    // Rotation keys are gathered here and slerped together
+    Quat slerp_from[ANIMATION_SLERP_BATCH];
+    Quat slerp_to[ANIMATION_SLERP_BATCH];
+    f32 slerp_t[ANIMATION_SLERP_BATCH];
+    u32 slerp_joints[ANIMATION_SLERP_BATCH];
+    u32 slerp_count = 0;
+    
+    // Compressed tracks share their times, the frame is found once for all of them
+    const f32 *frame_times = a->frame_times;
+    u32 frame = 0;
+    if(frame_times != NULL && time >= frame_times[0] && time < frame_times[a->frame_count - 1]) {
+        frame = AnimationFindKey(frame_times, a->frame_count, a->inv_frame_interval, time, sampler ? &sampler->frame_cursor : NULL);
+    }
+    
     for(u32 i = 0; i < a->track_count; i++) {
         AnimationTrack *track = &a->tracks[i];
         
         u32 key_1 = 0; u32 key_2 = 0;
-        if(time >= track->key_times[track->key_count - 1]) {
+        f32 norm_t = 0.0f;
+        if(track->key_frames != NULL) {
+            const u16 *key_frames = track->key_frames;
+            if(time >= frame_times[key_frames[track->key_count - 1]]) {
+                key_1 = key_2 = track->key_count - 1;
+            } else if(time >= frame_times[key_frames[0]]) {
+                key_1 = AnimationTrackFindFrameKey(track, frame, sampler ? &sampler->cursors[i] : NULL);
+                key_2 = key_1 + 1;
+                const f32 start = frame_times[key_frames[key_1]];
+                norm_t = (time - start) / (frame_times[key_frames[key_2]] - start);
+            }
+        } else if(time >= track->key_times[track->key_count - 1]) {
             key_1 = key_2 = track->key_count - 1;
-        }
-        else {
-            for(u32 i = 0; i < track->key_count; i ++) {
-                if(time >= track->key_times[i] && time < track->key_times[i + 1]) {
-                    key_1 = i;
-                    key_2 = i + 1;
-                    
-                    break;
-                }
+        } else if(time >= track->key_times[0]) {
+            key_1 = AnimationTrackFindKey(track, time, sampler ? &sampler->cursors[i] : NULL);
+            key_2 = key_1 + 1;
+            if(track->inv_key_interval > 0.0f) {
+                norm_t = (time - track->key_times[key_1]) * track->inv_key_interval;
+            } else {
+                norm_t = (time - track->key_times[key_1]) / (track->key_times[key_2] - track->key_times[key_1]);
             }
         }
         
-        f32 time_between_keys = track->key_times[key_2] - track->key_times[key_1];
-        f32 rel_t = time - track->key_times[key_1];
-        f32 norm_t = rel_t / time_between_keys;
-        
-        Transform *target_xform = target + track->target_node;
+        const u32 joint = track->target_node;
         
         switch(track->target) {
             case ANIM_TARGET_TRANSLATION : {
                 ASSERT(track->type == ANIM_TYPE_VEC3);
-                Vec3 *keys = (Vec3 *)track->keys;
                 if(key_1 == key_2) {
-                    target_xform->translation = keys[key_2];
+                    target->translations[joint] = AnimationTrackGetVec3(track, key_2);
                 } else {
-                    target_xform->translation = vec3_lerp(keys[key_1], keys[key_2], norm_t);
+                    target->translations[joint] = vec3_lerp(AnimationTrackGetVec3(track, key_1), AnimationTrackGetVec3(track, key_2), norm_t);
                 }
             } break;
             case ANIM_TARGET_ROTATION : {
                 ASSERT(track->type == ANIM_TYPE_QUATERNION);
-                Quat *keys = (Quat *)track->keys;
                 if(key_1 == key_2) {
-                    target_xform->rotation = keys[key_2];
+                    target->rotations[joint] = AnimationTrackGetQuat(track, key_2);
                 } else {
-                    target_xform->rotation = quat_slerp(keys[key_1], keys[key_2], norm_t);
+                    slerp_from[slerp_count] = AnimationTrackGetQuat(track, key_1);
+                    slerp_to[slerp_count] = AnimationTrackGetQuat(track, key_2);
+                    slerp_t[slerp_count] = norm_t;
+                    slerp_joints[slerp_count] = joint;
+                    if(++slerp_count == ANIMATION_SLERP_BATCH) {
+                        quat_slerp_batch_scatter(slerp_from, slerp_to, slerp_t, slerp_count, slerp_joints, target->rotations);
+                        slerp_count = 0;
+                    }
                 }
             } break;
             case ANIM_TARGET_SCALE : {
                 ASSERT(track->type == ANIM_TYPE_VEC3);
-                Vec3 *keys = (Vec3 *)track->keys;
                 if(key_1 == key_2) {
-                    target_xform->scale = keys[key_2];
+                    target->scales[joint] = AnimationTrackGetVec3(track, key_2);
                 } else {
-                    target_xform->scale  = vec3_lerp(keys[key_1], keys[key_2], norm_t);
+                    target->scales[joint] = vec3_lerp(AnimationTrackGetVec3(track, key_1), AnimationTrackGetVec3(track, key_2), norm_t);
                 }
             } break;
         }
     }
+    quat_slerp_batch_scatter(slerp_from, slerp_to, slerp_t, slerp_count, slerp_joints, target->rotations);
+}
+
+// --------
+// Blending
+// Poses are SoA, so the joints are blended 4 at a time with the wide math. The last group is padded with identity joints.
+
+// Local pose of joint_count joints, not initialized
+Pose PosePush(sArena *arena, const u32 joint_count) {
+    Pose result = {joint_count};
+    result.translations = sArenaPushAligned(arena, joint_count * sizeof(Vec3), 16);
+    result.rotations = sArenaPushAligned(arena, joint_count * sizeof(Quat), 16);
+    result.scales = sArenaPushAligned(arena, joint_count * sizeof(Vec3), 16);
+    return result;
+}
+
+void PoseSetRest(Pose *pose, const Transform *rest_pose) {
+    for(u32 i = 0; i < pose->joint_count; i++) {
+        pose->translations[i] = rest_pose[i].translation;
+        pose->rotations[i] = rest_pose[i].rotation;
+        pose->scales[i] = rest_pose[i].scale;
+    }
+}
+
+typedef struct PoseGroup {
+    Vec3x4 translations;
+    Quatx4 rotations;
+    Vec3x4 scales;
+} PoseGroup;
+
+// Joints [first, first + 4[, returns how many of them are in the pose
+internal u32 PoseLoadGroup(const Pose *pose, const u32 first, PoseGroup *group) {
+    const u32 lanes = pose->joint_count - first < 4 ? pose->joint_count - first : 4;
+    if(lanes == 4) {
+        group->translations = vec3x4_load(pose->translations + first);
+        group->rotations = quatx4_load(pose->rotations + first);
+        group->scales = vec3x4_load(pose->scales + first);
+    } else {
+        Vec3 t[4], s[4];
+        Quat r[4];
+        for(u32 i = 0; i < 4; i++) {
+            t[i] = i < lanes ? pose->translations[first + i] : (Vec3){0.0f, 0.0f, 0.0f};
+            r[i] = i < lanes ? pose->rotations[first + i] : quat_identity();
+            s[i] = i < lanes ? pose->scales[first + i] : (Vec3){1.0f, 1.0f, 1.0f};
+        }
+        group->translations = vec3x4_load(t);
+        group->rotations = quatx4_load(r);
+        group->scales = vec3x4_load(s);
+    }
+    return lanes;
+}
+
+internal void PoseStoreGroup(Pose *pose, const u32 first, const u32 lanes, const PoseGroup *group) {
+    if(lanes == 4) {
+        vec3x4_store(group->translations, pose->translations + first);
+        quatx4_store(group->rotations, pose->rotations + first);
+        vec3x4_store(group->scales, pose->scales + first);
+    } else {
+        Vec3 t[4], s[4];
+        Quat r[4];
+        vec3x4_store(group->translations, t);
+        quatx4_store(group->rotations, r);
+        vec3x4_store(group->scales, s);
+        for(u32 i = 0; i < lanes; i++) {
+            pose->translations[first + i] = t[i];
+            pose->rotations[first + i] = r[i];
+            pose->scales[first + i] = s[i];
+        }
+    }
+}
+
+internal f32x4 PoseGroupWeights(const f32 weight, const f32 *joint_weights, const u32 first, const u32 lanes) {
+    if(!joint_weights) {
+        return f32x4_set1(weight);
+    }
+    f32 w[4];
+    for(u32 i = 0; i < 4; i++) {
+        w[i] = i < lanes ? weight * joint_weights[first + i] : 0.0f;
+    }
+    return f32x4_load(w);
+}
+
+// Blends a toward b : lerp on the translations and scales, shortest path nlerp on the rotations.
+// The weight of b is weight * joint_weights[joint]. result can be a or b.
+void PoseBlend(const Pose *a, const Pose *b, const f32 weight, const f32 *joint_weights, Pose *result) {
+    ASSERT(a->joint_count == b->joint_count && a->joint_count == result->joint_count);
+    for(u32 first = 0; first < a->joint_count; first += 4) {
+        PoseGroup ga, gb;
+        const u32 lanes = PoseLoadGroup(a, first, &ga);
+        PoseLoadGroup(b, first, &gb);
+        const f32x4 w = PoseGroupWeights(weight, joint_weights, first, lanes);
+        ga.translations = vec3x4_lerp(ga.translations, gb.translations, w);
+        ga.rotations = quatx4_nlerp(ga.rotations, quatx4_align(ga.rotations, gb.rotations), w);
+        ga.scales = vec3x4_lerp(ga.scales, gb.scales, w);
+        PoseStoreGroup(result, first, lanes, &ga);
+    }
+}
+
+// Turns a pose into its difference with the rest pose, for PoseAdd
+void PoseMakeAdditive(Pose *pose, const Transform *rest_pose) {
+    for(u32 i = 0; i < pose->joint_count; i++) {
+        const Transform *rest = &rest_pose[i];
+        pose->translations[i] = vec3_sub(pose->translations[i], rest->translation);
+        pose->rotations[i] = quat_mul(quat_conjugate(rest->rotation), pose->rotations[i]);
+        pose->scales[i] = (Vec3){pose->scales[i].x / rest->scale.x, pose->scales[i].y / rest->scale.y, pose->scales[i].z / rest->scale.z};
+    }
+}
+
+// Adds a difference made by PoseMakeAdditive, scaled by weight * joint_weights[joint]
+void PoseAdd(Pose *base, const Pose *additive, const f32 weight, const f32 *joint_weights) {
+    ASSERT(base->joint_count == additive->joint_count);
+    const Quatx4 identity = quatx4_set1(quat_identity());
+    const Vec3x4 one = vec3x4_set1((Vec3){1.0f, 1.0f, 1.0f});
+    for(u32 first = 0; first < base->joint_count; first += 4) {
+        PoseGroup gb, ga;
+        const u32 lanes = PoseLoadGroup(base, first, &gb);
+        PoseLoadGroup(additive, first, &ga);
+        const f32x4 w = PoseGroupWeights(weight, joint_weights, first, lanes);
+        gb.translations = vec3x4_add(gb.translations, vec3x4_scale(ga.translations, w));
+        gb.rotations = quatx4_mul(gb.rotations, quatx4_nlerp(identity, quatx4_align(identity, ga.rotations), w));
+        gb.scales = vec3x4_mul(gb.scales, vec3x4_lerp(one, ga.scales, w));
+        PoseStoreGroup(base, first, lanes, &gb);
+    }
+}
+
+// Evaluates the layers in order into target. Layers under an override at full weight on every joint can't be seen
+// and layers with no weight don't change anything, neither are evaluated. The other layers are evaluated one at a time
+// into a pose from scratch, which is popped at the end. Joints without tracks are at rest_pose in those.
+void AnimationEvaluateLayers(const AnimationLayer *layers, const u32 layer_count, const Transform *rest_pose, sArena *scratch, Pose *target) {
+    ASSERT(layer_count > 0);
+    u32 base = 0;
+    for(u32 i = layer_count - 1; i > 0; i--) {
+        if(layers[i].mode == ANIMATION_BLEND_OVERRIDE && layers[i].weight >= 1.0f && !layers[i].joint_weights) {
+            base = i;
+            break;
+        }
+    }
+    AnimationEvaluate(layers[base].animation, layers[base].sampler, target, layers[base].time);
+    if(base + 1 == layer_count) {
+        return;
+    }
+    
+    u64 mark = sArenaGetMark(scratch);
+    Pose layer_pose = PosePush(scratch, target->joint_count);
+    for(u32 i = base + 1; i < layer_count; i++) {
+        const AnimationLayer *layer = &layers[i];
+        if(layer->weight <= 0.0f) {
+            continue;
+        }
+        PoseSetRest(&layer_pose, rest_pose);
+        AnimationEvaluate(layer->animation, layer->sampler, &layer_pose, layer->time);
+        if(layer->mode == ANIMATION_BLEND_OVERRIDE) {
+            PoseBlend(target, &layer_pose, layer->weight, layer->joint_weights, target);
+        } else {
+            PoseMakeAdditive(&layer_pose, rest_pose);
+            PoseAdd(target, &layer_pose, layer->weight, layer->joint_weights);
+        }
+    }
+    sArenaPopToMark(scratch, mark);
+}
+
+// Splits instances into contiguous jobs for RendererAnimateInstances, each instance in exactly one job.
+// job_count is clamped to [1, ANIMATION_MAX_JOBS] and to count so no job is empty, the sizes differ by 1 at most.
+// jobs holds ANIMATION_MAX_JOBS, returns the number of jobs filled. The scratch arenas are left to the caller.
+u32 AnimationSplitJobs(AnimationInstance *instances, const u32 count, u32 job_count, AnimationJob *jobs) {
+    job_count = MIN(job_count, ANIMATION_MAX_JOBS);
+    job_count = MIN(job_count, count);
+    if(job_count == 0) {
+        job_count = count > 0 ? 1 : 0;
+    }
+    u32 first = 0;
+    for(u32 j = 0; j < job_count; j++) {
+        // The first count % job_count jobs take one more
+        jobs[j].instances = instances + first;
+        jobs[j].count = count / job_count + (j < count % job_count ? 1 : 0);
+        first += jobs[j].count;
+    }
+    ASSERT(first == count);
+    return job_count;
+}
+
+// --------
+// Skinning
+
+// Global matrices of the joints of a pose, the roots are relative to root_xform
+// Parents are sorted before their children, so a single pass in joint order sees every parent already done
+void SkinCalcGlobalMats(const SkinnedMesh *skin, const Mat4 root_xform, Pose *pose) {
+    // Local matrices first, in one batch
+    trs_quat_to_mat4_batch(pose->translations, pose->rotations, pose->scales, skin->joint_count, pose->global_mats);
+    for(u32 i = 0; i < skin->joint_count; i++) {
+        const i32 parent = skin->joint_parents[i];
+        ASSERT(parent < (i32)i);
+        Mat4 local;
+        memcpy(local, pose->global_mats[i], sizeof(Mat4));
+        mat4_mul(parent < 0 ? root_xform : pose->global_mats[parent], local, pose->global_mats[i]);
+    }
+}
+
+// Global matrices relative to the mesh, then the joint matrices sent to the shaders.
+// The palette doesn't need the inverse of the entity's world matrix.
+void SkinUpdatePalette(const SkinnedMesh *skin, Pose *pose) {
+    Mat4 identity;
+    mat4_identity(identity);
+    SkinCalcGlobalMats(skin, identity, pose);
+    for(u32 i = 0; i < skin->joint_count; i++) {
+        mat4_mul(pose->global_mats[i], skin->inverse_bind_matrices[i], pose->palette[i]);
+    }
+}
+
+// --------
+// Baking
+
+// Samples the clip at frame_count evenly spaced times over its length and writes the joint matrices of each frame
+// as a row of texels, see BakedAnimation. texels holds frame_count * joint_count * 12 floats.
+void AnimationBakePalettes(const SkinnedMesh *skin, const Animation *animation, const u32 frame_count, sArena *scratch, f32 *texels) {
+    u64 scratch_mark = sArenaGetMark(scratch);
+    Pose pose = PosePush(scratch, skin->joint_count);
+    pose.global_mats = sArenaPushAligned(scratch, skin->joint_count * sizeof(Mat4), 16);
+    pose.palette = sArenaPushAligned(scratch, skin->joint_count * sizeof(Mat4), 16);
+    AnimationSampler sampler;
+    AnimationSamplerInit(&sampler, animation);
+    for(u32 f = 0; f < frame_count; f++) {
+        // Joints without tracks stay at rest
+        PoseSetRest(&pose, skin->joint_xforms);
+        AnimationEvaluate(animation, &sampler, &pose, animation->length * f / frame_count);
+        SkinUpdatePalette(skin, &pose);
+        f32 *texel = texels + f * skin->joint_count * 12;
+        for(u32 j = 0; j < skin->joint_count; j++) {
+            const f32 *m = pose.palette[j];
+            for(u32 row = 0; row < 3; row++) {
+                texel[0] = m[row];
+                texel[1] = m[4 + row];
+                texel[2] = m[8 + row];
+                texel[3] = m[12 + row];
+                texel += 4;
+            }
+        }
+    }
+    AnimationSamplerDestroy(&sampler);
+    sArenaPopToMark(scratch, scratch_mark);
 }
@@ -57,4 +57,8 @@ PFNGLDELETEPROGRAMPIPELINESPROC glDeleteProgramPipelines;
 PFNGLPROGRAMUNIFORMMATRIX4FVPROC glProgramUniformMatrix4fv;
 PFNGLPROGRAMUNIFORM1IPROC glProgramUniform1i;
 PFNGLPROGRAMUNIFORM3FPROC glProgramUniform3f;
+PFNGLPROGRAMUNIFORM1FPROC glProgramUniform1f;
+
+PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
 #endif
\ No newline at end of file
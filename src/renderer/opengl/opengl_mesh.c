@@ -1,9 +1,9 @@
 
 MeshHandle LoadMeshFromVertices(Renderer *renderer, const Vertex *vertices, const u32 vertex_count, const u32 *indices, const u32 index_count) {
     sLog("LOAD - Vertices - Vertices: %d, Indices: %d", vertex_count, index_count);
-    MeshHandle handle = sArrayAdd(&renderer->meshes);
+    MeshHandle handle = sPoolAdd(&renderer->meshes);
     
-    Mesh *mesh = sArrayGet(renderer->meshes, handle);
+    Mesh *mesh = sPoolGet(&renderer->meshes, handle);
     
     mesh->index_count = index_count;
     mesh->vertex_count = vertex_count;
@@ -35,7 +35,8 @@ MeshHandle LoadMeshFromVertices(Renderer *renderer, const Vertex *vertices, cons
     return handle;
 }
 
-internal void LoadVertexBuffers(Mesh *mesh, const GLTF *gltf) {
+internal void LoadVertexBuffers(Mesh *mesh, const GLTF *gltf, sArena *scratch) {
+    u64 scratch_mark = sArenaGetMark(scratch);
     
     // Vertex & Index Buffer
     glGenBuffers(1, &mesh->vertex_buffer);
@@ -56,10 +57,9 @@ internal void LoadVertexBuffers(Mesh *mesh, const GLTF *gltf) {
         GLTFAccessor *indices_acc = &gltf->accessors[prim->indices];
         u32 index_buffer_size = indices_acc->count * sizeof(u32);
         mesh->index_count = indices_acc->count;
-        u32 *index_data = sCalloc(indices_acc->count, sizeof(u32));
+        u32 *index_data = sArenaPushAligned(scratch, indices_acc->count * sizeof(u32), RENDERER_SCRATCH_ALIGNMENT);
         GLTFCopyAccessor(gltf, prim->indices, index_data, 0, sizeof(u32));
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_buffer_size, index_data, GL_STATIC_DRAW);
-        sFree(index_data);
         
         // Vertices
         // We're doing some offsets shenanigans, so we need to make sure that the offsets of Vertex are identical in SkinnedVertex
@@ -73,11 +73,11 @@ internal void LoadVertexBuffers(Mesh *mesh, const GLTF *gltf) {
         void *vertex_data;
         u32 vertex_size;
         if(prim->attributes_set & PRIMITIVE_SKINNED) {
-            vertex_data = sCalloc(mesh->vertex_count, sizeof(SkinnedVertex));
+            vertex_data = sArenaPushAligned(scratch, mesh->vertex_count * sizeof(SkinnedVertex), RENDERER_SCRATCH_ALIGNMENT);
             vertex_buffer_size = mesh->vertex_count * sizeof(SkinnedVertex);
             vertex_size = sizeof(SkinnedVertex);
         } else {
-            vertex_data = sCalloc(mesh->vertex_count, sizeof(Vertex));
+            vertex_data = sArenaPushAligned(scratch, mesh->vertex_count * sizeof(Vertex), RENDERER_SCRATCH_ALIGNMENT);
             vertex_buffer_size =  mesh->vertex_count * sizeof(Vertex);
             vertex_size = sizeof(Vertex);
         }
@@ -99,6 +99,16 @@ internal void LoadVertexBuffers(Mesh *mesh, const GLTF *gltf) {
         } 
         if(prim->attributes_set & PRIMITIVE_ATTRIBUTE_JOINTS_0) {
             GLTFCopyAccessor(gltf, prim->joints_0, vertex_data, offsetof(SkinnedVertex, joints), vertex_size);
+            // The skin joints are sorted at load, see GLTFSortSkinJoints
+            if(gltf->skin_count > 0) {
+                const u32 *joint_remap = gltf->skins[0].joint_remap;
+                for(u32 v = 0; v < mesh->vertex_count; v++) {
+                    u8 *joints = ((SkinnedVertex *)vertex_data)[v].joints;
+                    for(u32 j = 0; j < 4; j++) {
+                        joints[j] = (u8)joint_remap[joints[j]];
+                    }
+                }
+            }
             glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_FALSE, vertex_size, (void *)offsetof(SkinnedVertex, joints));
             glEnableVertexAttribArray(3);
         } 
@@ -112,7 +122,7 @@ internal void LoadVertexBuffers(Mesh *mesh, const GLTF *gltf) {
         // SkinnedVertex *a = (SkinnedVertex *)vertex_data;
         // glBufferData(GL_ARRAY_BUFFER, vertex_buffer_size, (void*)a, GL_STATIC_DRAW);
         
-        sFree(vertex_data);
+        sArenaPopToMark(scratch, scratch_mark);
     }
     
     char buf[64] = {0};
@@ -135,54 +145,54 @@ internal void LoadSkin(Renderer *renderer, SkinnedMesh *skin, GLTF *gltf) {
     GLTFSkin *src_skin = &gltf->skins[0];
     
     skin->joint_count = src_skin->joint_count;
-    skin->inverse_bind_matrices = sCalloc(skin->joint_count, sizeof(Mat4));
-    GLTFCopyAccessor(gltf, src_skin->inverse_bind_matrices, skin->inverse_bind_matrices, 0, sizeof(Mat4));
-    
-    skin->global_joint_mats = sCalloc(skin->joint_count, sizeof(Mat4));
+    skin->inverse_bind_matrices = sCallocTagged(skin->joint_count, sizeof(Mat4), MEM_TAG_ANIMATION);
+    skin->joint_parents = sCallocTagged(skin->joint_count, sizeof(i32), MEM_TAG_ANIMATION);
+    skin->joint_xforms  = sCallocTagged(skin->joint_count, sizeof(Transform), MEM_TAG_ANIMATION);
     
-    skin->joint_child_count = sCalloc(skin->joint_count, sizeof(u32));
-    skin->joint_children = sCalloc(skin->joint_count, sizeof(u32 *));
-    
-    skin->joint_parents = sCalloc(skin->joint_count, sizeof(u32));
-    skin->joint_xforms  = sCalloc(skin->joint_count, sizeof(Transform));
+    // The gltf matrices are in the file order of the joints, the skin uses the sorted order
+    u64 scratch_mark = sArenaGetMark(&renderer->backend->scratch);
+    Mat4 *inverse_bind_matrices = sArenaPushAligned(&renderer->backend->scratch, skin->joint_count * sizeof(Mat4), RENDERER_SCRATCH_ALIGNMENT);
+    GLTFCopyAccessor(gltf, src_skin->inverse_bind_matrices, inverse_bind_matrices, 0, sizeof(Mat4));
     
     for(u32 i = 0; i < skin->joint_count; ++i) {
-        GLTFNode *node = &gltf->nodes[src_skin->joints[i]];
+        skin->joint_parents[i] = -1;
+    }
+    for(u32 i = 0; i < skin->joint_count; ++i) {
+        const u32 file_joint = src_skin->joint_order[i];
+        GLTFNode *node = &gltf->nodes[src_skin->joints[file_joint]];
         
         skin->joint_xforms[i] = node->xform;
-        skin->joint_child_count[i] = node->child_count;
-        skin->joint_parents[i] = -1;
-        if(node->child_count > 0) {
-            skin->joint_children[i] = sCalloc(node->child_count, sizeof(u32));
-            for(u32 j = 0; j < skin->joint_child_count[i]; ++j) {
-                u32 child_id = GLTFGetBoneIDFromNode(gltf, node->children[j]);
-                skin->joint_children[i][j] = child_id;
-                skin->joint_parents[child_id] = i; 
-            }
+        memcpy(skin->inverse_bind_matrices[i], inverse_bind_matrices[file_joint], sizeof(Mat4));
+        for(u32 j = 0; j < node->child_count; ++j) {
+            u32 child_id = GLTFGetBoneIDFromNode(gltf, node->children[j]);
+            skin->joint_parents[child_id] = i;
         }
     }
+    sArenaPopToMark(&renderer->backend->scratch, scratch_mark);
 }
 
-void LoadFromGLTF(const char *path, Renderer *renderer, PlatformAPI *platform, MeshHandle *mesh, SkinnedMeshHandle *skin, Animation *animation) {
-    GLTF *gltf = LoadGLTF(path, platform);
+void LoadFromGLTF(const char *path, Renderer *renderer, PlatformAPI *platform, MeshHandle *mesh, SkinnedMeshHandle *skin, AnimationLibraryHandle *animations) {
+    // The GLTF is only needed while we upload the data, it is popped off the frame arena at the end
+    GLTF *gltf = LoadGLTF(path, platform, &platform->memory->frame);
     
     if(mesh != NULL) {
         sLog("LOAD - Mesh - %s", gltf->path);
-        *mesh = sArrayAdd(&renderer->meshes);
-        LoadVertexBuffers(sArrayGet(renderer->meshes, *mesh), gltf);
+        *mesh = sPoolAdd(&renderer->meshes);
+        LoadVertexBuffers(sPoolGet(&renderer->meshes, *mesh), gltf, &renderer->backend->scratch);
     }
     
     if(skin != NULL) {
-        *skin = sArrayAdd(&renderer->skins);
+        *skin = sPoolAdd(&renderer->skins);
         sLog("LOAD - Skin - %s - %d", gltf->path, *skin);
-        SkinnedMesh *skinned_mesh = sArrayGet(renderer->skins, *skin);
-        LoadVertexBuffers(&skinned_mesh->mesh, gltf);
+        SkinnedMesh *skinned_mesh = sPoolGet(&renderer->skins, *skin);
+        LoadVertexBuffers(&skinned_mesh->mesh, gltf, &renderer->backend->scratch);
         LoadSkin(renderer, skinned_mesh, gltf);
     }
     
-    if(animation != NULL) {
-        sLog("LOAD - Animation - %s", gltf->path);
-        LoadAnimation(animation, gltf);
+    if(animations != NULL) {
+        sLog("LOAD - Animations - %s", gltf->path);
+        *animations = sPoolAdd(&renderer->animation_libraries);
+        LoadAnimationLibrary(renderer, sPoolGet(&renderer->animation_libraries, *animations), gltf);
     }
     
     DestroyGLTF(gltf);
@@ -191,20 +201,86 @@ void LoadFromGLTF(const char *path, Renderer *renderer, PlatformAPI *platform, M
 void DestroyMesh(Mesh *mesh) {
     glDeleteBuffers(1, &mesh->index_buffer);
     glDeleteBuffers(1, &mesh->vertex_buffer);
+    glDeleteVertexArrays(1, &mesh->vertex_array);
 }
 
 void DestroySkin(Renderer *renderer, SkinnedMesh *skin) {
-    
-    for(u32 i = 0; i < skin->joint_count; i++) {
-        if(skin->joint_child_count[i] > 0) {
-            sFree(skin->joint_children[i]);
-        }
-    }
+    DestroyMesh(&skin->mesh);
     sFree(skin->joint_parents);
-    sFree(skin->joint_children);
-    sFree(skin->joint_child_count);
-    sFree(skin->global_joint_mats);
+    if(skin->poses.capacity > 0) {
+        sFree(skin->poses.translations);
+        sFree(skin->poses.rotations);
+        sFree(skin->poses.scales);
+        sFree(skin->poses.global_mats);
+        sFree(skin->poses.palettes);
+        sFree(skin->poses.lod_palettes);
+        sFree(skin->poses.free_list);
+    }
     sFree(skin->joint_xforms);
     sFree(skin->inverse_bind_matrices);
 }
 
+
+// The shader reads the palettes with texelFetch, so no filtering nor mipmaps
+internal void UploadBakedAnimation(BakedAnimation *baked, const f32 *texels) {
+    i32 max_size = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+    ASSERT_MSG(baked->joint_count * 3 <= (u32)max_size && baked->frame_count <= (u32)max_size, "Baked animation is too big for a texture");
+    
+    glGenTextures(1, &baked->texture);
+    glBindTexture(GL_TEXTURE_2D, baked->texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, baked->joint_count * 3, baked->frame_count, 0, GL_RGBA, GL_FLOAT, texels);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glObjectLabel(GL_TEXTURE, baked->texture, -1, "Baked animation");
+}
+
+internal void DestroyBakedAnimation(BakedAnimation *baked) {
+    glDeleteTextures(1, &baked->texture);
+}
+
+// The skin's vertex attributes, then one BakedCrowdInstance per instance at locations 5 to 9 of baked_skinned_mesh.vert
+internal void CreateBakedCrowdBuffers(BakedCrowd *crowd, const Mesh *mesh) {
+    glGenVertexArrays(1, &crowd->vertex_array);
+    glBindVertexArray(crowd->vertex_array);
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->index_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vertex_buffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void *)offsetof(SkinnedVertex, pos));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void *)offsetof(SkinnedVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void *)offsetof(SkinnedVertex, uv));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_FALSE, sizeof(SkinnedVertex), (void *)offsetof(SkinnedVertex, joints));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, sizeof(SkinnedVertex), (void *)offsetof(SkinnedVertex, weights));
+    glEnableVertexAttribArray(4);
+    
+    glGenBuffers(1, &crowd->instance_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, crowd->instance_buffer);
+    // A mat4 attribute takes 4 locations, one per column
+    for(u32 column = 0; column < 4; column++) {
+        glVertexAttribPointer(5 + column, 4, GL_FLOAT, GL_FALSE, sizeof(BakedCrowdInstance), (void *)(offsetof(BakedCrowdInstance, world) + column * 4 * sizeof(f32)));
+        glEnableVertexAttribArray(5 + column);
+        glVertexAttribDivisor(5 + column, 1);
+    }
+    glVertexAttribPointer(9, 1, GL_FLOAT, GL_FALSE, sizeof(BakedCrowdInstance), (void *)offsetof(BakedCrowdInstance, time_offset));
+    glEnableVertexAttribArray(9);
+    glVertexAttribDivisor(9, 1);
+    glBindVertexArray(0);
+    
+    glObjectLabel(GL_BUFFER, crowd->instance_buffer, -1, "Baked crowd instance buffer");
+    glObjectLabel(GL_VERTEX_ARRAY, crowd->vertex_array, -1, "Baked crowd array buffer");
+}
+
+internal void UploadBakedCrowdInstances(BakedCrowd *crowd, const BakedCrowdInstance *instances, const u32 count) {
+    glBindBuffer(GL_ARRAY_BUFFER, crowd->instance_buffer);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(BakedCrowdInstance), instances, GL_STATIC_DRAW);
+    crowd->instance_count = count;
+}
+
+internal void DestroyBakedCrowdBuffers(BakedCrowd *crowd) {
+    glDeleteBuffers(1, &crowd->instance_buffer);
+    glDeleteVertexArrays(1, &crowd->vertex_array);
+}
@@ -67,7 +67,7 @@ internal u32 CreateSeparableProgram(PlatformAPI *platform, const char *path, GLe
     i32 size = 0;
     u32 result = 0;
     platform->ReadWholeFile(path, &size, 0);
-    char *const code = sCalloc(size, sizeof(char));
+    char *const code = sCallocTagged(size, sizeof(char), MEM_TAG_RENDER);
     platform->ReadWholeFile(path, &size, code);
     result = glCreateShaderProgramv(type, 1, (const char* const*)&code);
     ASSERT(result);
@@ -92,7 +92,7 @@ internal u32 CreateProgram(PlatformAPI *platform, const char *name) {
     
     i32 file_size = 0;
     platform->ReadWholeFile(buffer, &file_size, NULL);
-    char *vtx_code = sCalloc(file_size, sizeof(char));
+    char *vtx_code = sCallocTagged(file_size, sizeof(char), MEM_TAG_RENDER);
     platform->ReadWholeFile(buffer, &file_size, vtx_code);
     
     ASSERT(vtx_code != NULL); // Vertex shaders are mandatory
@@ -102,7 +102,7 @@ internal u32 CreateProgram(PlatformAPI *platform, const char *name) {
     
     snprintf(buffer, 128, "resources/shaders/gl/%s.frag", name);
     platform->ReadWholeFile(buffer, &file_size, NULL);
-    char *frag_code = sCalloc(file_size, sizeof(char));
+    char *frag_code = sCallocTagged(file_size, sizeof(char), MEM_TAG_RENDER);
     platform->ReadWholeFile(buffer, &file_size, frag_code);
     
     u32 frag_shader = 0;
@@ -269,6 +269,11 @@ internal void BeginVolumetricRenderPass(Renderer *renderer, VolumetricRenderPass
 // Renderer
 
 void BackendRendererInit(OpenGLRenderer *renderer, PlatformAPI *platform_api, PlatformWindow *window) {
+    if(!renderer->scratch.base) {
+        renderer->scratch = sArenaCarve(&platform_api->memory->permanent, RENDERER_SCRATCH_SIZE);
+    }
+    u64 scratch_mark = sArenaGetMark(&renderer->scratch);
+    
     PlatformCreateorUpdateOpenGLContext(renderer, window);
     GLLoadFunctions();
     
@@ -285,6 +290,11 @@ void BackendRendererInit(OpenGLRenderer *renderer, PlatformAPI *platform_api, Pl
     renderer->skinned_mesh_vtx_shader = CreateSeparableProgram(platform_api,"resources/shaders/gl/skinned_mesh.vert", GL_VERTEX_SHADER);
     glObjectLabel(GL_PROGRAM, renderer->skinned_mesh_vtx_shader, -1, "Skinned Mesh Vertex Shader");
     
+    renderer->baked_mesh_vtx_shader = CreateSeparableProgram(platform_api,"resources/shaders/gl/baked_skinned_mesh.vert", GL_VERTEX_SHADER);
+    glObjectLabel(GL_PROGRAM, renderer->baked_mesh_vtx_shader, -1, "Baked Skinned Mesh Vertex Shader");
+    // Texture units 0 and 1 are the shadow map and the diffuse
+    glProgramUniform1i(renderer->baked_mesh_vtx_shader, glGetUniformLocation(renderer->baked_mesh_vtx_shader, "baked_palettes"), 2);
+    
     renderer->color_fragment_shader = CreateSeparableProgram(platform_api, "resources/shaders/gl/color.frag", GL_FRAGMENT_SHADER);
     glObjectLabel(GL_PROGRAM, renderer->color_fragment_shader, -1, "Color Fragment Shader");
     
@@ -315,23 +325,21 @@ void BackendRendererInit(OpenGLRenderer *renderer, PlatformAPI *platform_api, Pl
     
     { // UI
         // Load font
-        unsigned char *ttf_buffer = sCalloc(1 << 20, sizeof(unsigned char));
+        unsigned char *ttf_buffer = sArenaPushAligned(&renderer->scratch, 1 << 20, RENDERER_SCRATCH_ALIGNMENT);
         FILE *f = fopen("resources/font/LiberationMono-Regular.ttf", "rb");
         ASSERT(f);
         fread(ttf_buffer, 1, 1 << 20, f);
         fclose(f);
         
-        unsigned char *temp_bmp = sCalloc(512 * 512, sizeof(unsigned char));
-        renderer->char_data = sCalloc(96, sizeof(stbtt_bakedchar));
+        unsigned char *temp_bmp = sArenaPushAligned(&renderer->scratch, 512 * 512, RENDERER_SCRATCH_ALIGNMENT);
+        renderer->char_data = sCallocTagged(96, sizeof(stbtt_bakedchar), MEM_TAG_RENDER);
         
         stbtt_BakeFontBitmap(ttf_buffer, 0, 20.0f, temp_bmp, 512, 512, 32, 96, renderer->char_data);
         
-        sFree(ttf_buffer);
         glGenTextures(1, &renderer->glyphs_texture);
         glBindTexture(GL_TEXTURE_2D, renderer->glyphs_texture);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, 512, 512, 0, GL_RED, GL_UNSIGNED_BYTE, temp_bmp);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        sFree(temp_bmp);
         
         // Init glyph array
         glGenVertexArrays(1, &renderer->ui_vertex_array);
@@ -352,16 +360,16 @@ void BackendRendererInit(OpenGLRenderer *renderer, PlatformAPI *platform_api, Pl
         // Load white texture
         glGenTextures(1, &renderer->white_texture);
         glBindTexture(GL_TEXTURE_2D, renderer->white_texture);
-        u8 *white = sCalloc(4 * 4 * 3, sizeof(u8));
+        u8 *white = sArenaPushAligned(&renderer->scratch, 4 * 4 * 3, RENDERER_SCRATCH_ALIGNMENT);
         memset(white, 255, 4 * 4 * 3 * sizeof(u8));
         
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 4, 4, 0, GL_RGB, GL_UNSIGNED_BYTE, white);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        sFree(white);
     }
     
     renderer->line_program = CreateProgram(platform_api, "debug");
+    sArenaPopToMark(&renderer->scratch, scratch_mark);
 }
 
 void BackendRendererDestroy(OpenGLRenderer *renderer) {
@@ -378,6 +386,7 @@ void BackendRendererDestroy(OpenGLRenderer *renderer) {
     // Shaders
     glDeleteProgram(renderer->static_mesh_vtx_shader);
     glDeleteProgram(renderer->skinned_mesh_vtx_shader);
+    glDeleteProgram(renderer->baked_mesh_vtx_shader);
     glDeleteProgram(renderer->color_fragment_shader);
     
     // Screen quad
@@ -398,6 +407,23 @@ internal void DrawMesh(const u32 pipeline, const u32 vtx_shader, const u32 frag_
     glDrawElements(GL_TRIANGLES, mesh->index_count, GL_UNSIGNED_INT, 0);
 }
 
+// Every instance in one call, the vertex shader animates them from the baked palettes
+internal void DrawBakedCrowd(OpenGLRenderer *renderer, const u32 pipeline, const BakedCrowd *crowd, const BakedAnimation *animation, const Mesh *mesh, const f32 time, const Vec3 color) {
+    const u32 vtx_shader = renderer->baked_mesh_vtx_shader;
+    glUseProgramStages(pipeline, GL_VERTEX_SHADER_BIT, vtx_shader);
+    glProgramUniform3f(renderer->color_fragment_shader, glGetUniformLocation(renderer->color_fragment_shader, "diffuse_color"), color.x, color.y, color.z);
+    
+    glProgramUniform1f(vtx_shader, glGetUniformLocation(vtx_shader, "time"), time);
+    glProgramUniform1f(vtx_shader, glGetUniformLocation(vtx_shader, "frame_rate"), animation->frame_rate);
+    glProgramUniform1i(vtx_shader, glGetUniformLocation(vtx_shader, "frame_count"), animation->frame_count);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, animation->texture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, renderer->white_texture);
+    
+    glBindVertexArray(crowd->vertex_array);
+    glDrawElementsInstanced(GL_TRIANGLES, mesh->index_count, GL_UNSIGNED_INT, 0, crowd->instance_count);
+}
 
 internal void DrawScene(Renderer *renderer, PushBuffer *pushb, const u32 pipeline) {
     glActiveTexture(GL_TEXTURE1);
@@ -411,11 +437,14 @@ internal void DrawScene(Renderer *renderer, PushBuffer *pushb, const u32 pipelin
             case PushBufferEntryType_Mesh: {
                 PushBufferEntryMesh *entry = (PushBufferEntryMesh *)(pushb->buf + address);
                 
-                Mat4 mat;
-                transform_to_mat4(entry->transform, &mat);
+                const f32 *mat = renderer->world_matrices[entry->matrix];
                 glBindTexture(GL_TEXTURE_2D, renderer->backend->white_texture);
                 
-                Mesh *mesh = sArrayGet(renderer->meshes, entry->mesh);
+                Mesh *mesh = sPoolGet(&renderer->meshes, entry->mesh);
+                if(!mesh) { // Destroyed after being pushed
+                    address += sizeof(PushBufferEntryMesh);
+                    break;
+                }
                 
                 DrawMesh(pipeline, renderer->backend->static_mesh_vtx_shader, renderer->backend->color_fragment_shader, mesh, mat, entry->diffuse_color);
                 
@@ -424,46 +453,36 @@ internal void DrawScene(Renderer *renderer, PushBuffer *pushb, const u32 pipelin
             case PushBufferEntryType_SkinnedMesh: {
                 PushBufferEntrySkinnedMesh *entry = (PushBufferEntrySkinnedMesh *)(pushb->buf + address);
                 
-                Mat4 mesh_transform;
-                transform_to_mat4(entry->transform, &mesh_transform);
-                
-                // Skin calc
-                SkinnedMesh *skin = sArrayGet(renderer->skins, entry->skin);
+                const f32 *mesh_transform = renderer->world_matrices[entry->matrix];
                 
-                // Calculate bone xforms
-                Mat4 *joint_mats = sCalloc(skin->joint_count, sizeof(Mat4));
-                
-                Mat4 mesh_inverse;
-                mat4_inverse(mesh_transform, mesh_inverse);
-                
-                u32 root = 0;
-                for(u32 i = 0; i < skin->joint_count; i++){
-                    if(skin->joint_parents[i] == -1) {
-                        root = i;
-                        break;
-                    }
-                }
-                
-                Mat4 tmp;
-                Transform *root_xform = &entry->skeleton[root];
-                transform_to_mat4(root_xform, &tmp);
-                mat4_mul(mesh_transform, tmp, skin->global_joint_mats[root]);
-                SkinCalcChildXform(root, skin, entry->skeleton);
-                
-                for(u32 i = 0; i < skin->joint_count; i++) {
-                    mat4_mul(skin->global_joint_mats[i], skin->inverse_bind_matrices[i], tmp); // Inverse Bind Matrix
-                    mat4_mul(mesh_inverse, tmp, joint_mats[i]);
+                SkinnedMesh *skin = sPoolGet(&renderer->skins, entry->skin);
+                if(!skin) {
+                    address += sizeof(PushBufferEntrySkinnedMesh);
+                    break;
                 }
                 
-                glProgramUniformMatrix4fv(renderer->backend->skinned_mesh_vtx_shader, glGetUniformLocation(renderer->backend->skinned_mesh_vtx_shader, "joint_matrices"), skin->joint_count, GL_FALSE, (f32*)joint_mats);
+                // Joint matrices are computed once per frame by the animation update, see RendererAnimateInstances
+                Pose pose = SkinGetPose(skin, entry->pose);
+                glProgramUniformMatrix4fv(renderer->backend->skinned_mesh_vtx_shader, glGetUniformLocation(renderer->backend->skinned_mesh_vtx_shader, "joint_matrices"), skin->joint_count, GL_FALSE, (const f32 *)pose.palette);
                 
                 // Mesh
                 glBindTexture(GL_TEXTURE_2D, renderer->backend->white_texture);
                 DrawMesh(pipeline, renderer->backend->skinned_mesh_vtx_shader, renderer->backend->color_fragment_shader, &skin->mesh, mesh_transform, entry->diffuse_color);
-                sFree(joint_mats);
                 
                 address += sizeof(PushBufferEntrySkinnedMesh);
             } break;
+            case PushBufferEntryType_BakedCrowd: {
+                PushBufferEntryBakedCrowd *entry = (PushBufferEntryBakedCrowd *)(pushb->buf + address);
+                
+                BakedCrowd *crowd = sPoolGet(&renderer->baked_crowds, entry->crowd);
+                BakedAnimation *animation = crowd ? sPoolGet(&renderer->baked_animations, crowd->animation) : NULL;
+                SkinnedMesh *skin = crowd ? sPoolGet(&renderer->skins, crowd->skin) : NULL;
+                if(animation && skin && crowd->instance_count > 0) {
+                    DrawBakedCrowd(renderer->backend, pipeline, crowd, animation, &skin->mesh, entry->time, entry->diffuse_color);
+                }
+                
+                address += sizeof(PushBufferEntryBakedCrowd);
+            } break;
             default : {
                 ASSERT(0);
             }
@@ -548,7 +567,6 @@ internal void DrawUI(Renderer *frontend, PushBuffer *push_buffer) {
                     }
                     txt++;
                 }
-                sFree(entry->text);
                 address += sizeof(PushBufferEntryText);
                 continue;
             } break;
@@ -648,14 +666,18 @@ DLL_EXPORT void RendererDrawFrame(Renderer *frontend) {
     mat4_mul(frontend->camera_proj, frontend->camera_view, frontend->camera_vp);
     glProgramUniformMatrix4fv(backend->static_mesh_vtx_shader, glGetUniformLocation(backend->static_mesh_vtx_shader, "light_matrix"), 1, GL_FALSE, frontend->light_matrix);
     glProgramUniformMatrix4fv(backend->skinned_mesh_vtx_shader, glGetUniformLocation(backend->skinned_mesh_vtx_shader, "light_matrix"), 1, GL_FALSE, frontend->light_matrix);
+    glProgramUniformMatrix4fv(backend->baked_mesh_vtx_shader, glGetUniformLocation(backend->baked_mesh_vtx_shader, "light_matrix"), 1, GL_FALSE, frontend->light_matrix);
     glProgramUniform3f(backend->color_fragment_shader, glGetUniformLocation(backend->color_fragment_shader, "light_dir"), frontend->light_dir.x, frontend->light_dir.y, frontend->light_dir.z); 
     
+    RendererBuildWorldMatrices(frontend);
+    
     // ------------------
     // Shadow map
     
     BeginShadowmapRenderPass(&backend->shadowmap_pass);
     glProgramUniformMatrix4fv(backend->static_mesh_vtx_shader, glGetUniformLocation(backend->static_mesh_vtx_shader, "vp"), 1, GL_FALSE, frontend->light_matrix);
     glProgramUniformMatrix4fv(backend->skinned_mesh_vtx_shader, glGetUniformLocation(backend->skinned_mesh_vtx_shader, "vp"), 1, GL_FALSE, frontend->light_matrix);
+    glProgramUniformMatrix4fv(backend->baked_mesh_vtx_shader, glGetUniformLocation(backend->baked_mesh_vtx_shader, "vp"), 1, GL_FALSE, frontend->light_matrix);
     DrawScene(frontend, &frontend->scene_pushbuffer, backend->shadowmap_pass.pipeline);
     
     // ------------------
@@ -664,6 +686,7 @@ DLL_EXPORT void RendererDrawFrame(Renderer *frontend) {
     BeginColorRenderPass(backend, &backend->color_pass);
     glProgramUniformMatrix4fv(backend->static_mesh_vtx_shader, glGetUniformLocation(backend->static_mesh_vtx_shader, "vp"), 1, GL_FALSE, frontend->camera_vp);
     glProgramUniformMatrix4fv(backend->skinned_mesh_vtx_shader, glGetUniformLocation(backend->skinned_mesh_vtx_shader, "vp"), 1, GL_FALSE, frontend->camera_vp);
+    glProgramUniformMatrix4fv(backend->baked_mesh_vtx_shader, glGetUniformLocation(backend->baked_mesh_vtx_shader, "vp"), 1, GL_FALSE, frontend->camera_vp);
     DrawScene(frontend, &frontend->scene_pushbuffer, backend->color_pass.pipeline);
     
     // ---------------
@@ -682,6 +705,10 @@ DLL_EXPORT void RendererDrawFrame(Renderer *frontend) {
     frontend->scene_pushbuffer.size = 0; // @Optimization : Maybe we don't need to reset it each frame? do some tests
     frontend->ui_pushbuffer.size = 0;
     frontend->debug_pushbuffer.size = 0;
+    sPerfSetCounter("Renderer scratch peak (bytes)", backend->scratch.peak);
+    sPerfSetCounter("Frame arena (bytes)", frontend->frame_arena->used);
+    sArenaReset(&backend->scratch);
+    sArenaReset(frontend->frame_arena);
 }
 
 DLL_EXPORT void RendererUpdateWindow(Renderer *renderer, PlatformAPI *platform_api, const u32 width, const u32 height) {
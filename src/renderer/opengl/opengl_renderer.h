@@ -25,7 +25,14 @@ typedef struct VolumetricRenderPass {
     u32 program;
 } VolumetricRenderPass;
 
+#define RENDERER_SCRATCH_SIZE Megabytes(4)
+#define RENDERER_SCRATCH_ALIGNMENT 64
+
 typedef struct RendererBackend {
+    // Transient allocations. Take a mark, push with RENDERER_SCRATCH_ALIGNMENT and pop back when done.
+    // Carved once from the permanent arena, kept through reloads. Reset at the end of each frame.
+    sArena scratch;
+    
     ShadowmapRenderPass shadowmap_pass;
     ColorRenderPass color_pass;
     VolumetricRenderPass vol_pass;
@@ -49,6 +56,7 @@ typedef struct RendererBackend {
     
     u32 static_mesh_vtx_shader;
     u32 skinned_mesh_vtx_shader;
+    u32 baked_mesh_vtx_shader; // Instanced baked crowds, see BakedAnimation
     
     u32 color_fragment_shader;
 } RendererBackend;
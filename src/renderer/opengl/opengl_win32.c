@@ -61,6 +61,10 @@ void GLLoadFunctions() {
     LOAD_GL_FUNC(PFNGLPROGRAMUNIFORMMATRIX4FVPROC, glProgramUniformMatrix4fv);
     LOAD_GL_FUNC(PFNGLPROGRAMUNIFORM1IPROC, glProgramUniform1i);
     LOAD_GL_FUNC(PFNGLPROGRAMUNIFORM3FPROC, glProgramUniform3f);
+    LOAD_GL_FUNC(PFNGLPROGRAMUNIFORM1FPROC, glProgramUniform1f);
+    
+    LOAD_GL_FUNC(PFNGLVERTEXATTRIBDIVISORPROC, glVertexAttribDivisor);
+    LOAD_GL_FUNC(PFNGLDRAWELEMENTSINSTANCEDPROC, glDrawElementsInstanced);
     
 }
 
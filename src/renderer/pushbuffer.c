@@ -25,12 +25,12 @@ void UIPushQuad(PushBuffer *push_buffer, const u32 x, const u32 y, const u32 w,
     entry->colour = color;
 }
 
-// TODO(Guigui): Maybe remove the memallocs ??
 void UIPushText(PushBuffer *push_buffer, const char *text, const u32 x, const u32 y, const Vec4 color) {
+    char *saved = sArenaPushString(push_buffer->arena, text, strlen(text));
+    if(!saved)
+        return;
     PushBufferEntryText *entry = PushBufferGetEntry(push_buffer, PushBufferEntryText);
     entry->type = PushBufferEntryType_Text;
-    char *saved = sCalloc(128, sizeof(char));
-    StringCopyLength(saved, text, 128);
     entry->text = saved;
     entry->x = x;
     entry->y = y;
@@ -38,13 +38,24 @@ void UIPushText(PushBuffer *push_buffer, const char *text, const u32 x, const u3
 }
 
 void UIPushFmt(PushBuffer *push_buffer, const u32 x, const u32 y, const Vec4 color, const char *fmt, ...) {
-    PushBufferEntryText *entry = PushBufferGetEntry(push_buffer, PushBufferEntryText);
-    entry->type = PushBufferEntryType_Text;
-    entry->text = sCalloc(128, sizeof(char));
     va_list ap;
     va_start(ap, fmt);
-    vsnprintf(entry->text, 128, fmt, ap);
+    va_list ap_length;
+    va_copy(ap_length, ap);
+    i32 length = vsnprintf(NULL, 0, fmt, ap_length);
+    va_end(ap_length);
+    
+    char *text = length >= 0 ? sArenaPushAligned(push_buffer->arena, length + 1, 1) : NULL;
+    if(!text) {
+        va_end(ap);
+        return;
+    }
+    vsnprintf(text, length + 1, fmt, ap);
     va_end(ap);
+    
+    PushBufferEntryText *entry = PushBufferGetEntry(push_buffer, PushBufferEntryText);
+    entry->type = PushBufferEntryType_Text;
+    entry->text = text;
     entry->x = x;
     entry->y = y;
     entry->colour = color;
@@ -70,12 +81,21 @@ void PushMesh(PushBuffer *push_buffer, const MeshHandle mesh, Transform *transfo
     entry->diffuse_color = diffuse_color;
 }
 
-void PushSkinnedMesh(PushBuffer *push_buffer, SkinnedMeshHandle skin, Transform *root, Transform *skeleton, Vec3 diffuse_color) {
+void PushSkinnedMesh(PushBuffer *push_buffer, SkinnedMeshHandle skin, Transform *root, const u32 pose, Vec3 diffuse_color) {
     PushBufferEntrySkinnedMesh *entry = PushBufferGetEntry(push_buffer, PushBufferEntrySkinnedMesh);
     entry->type = PushBufferEntryType_SkinnedMesh;
     entry->skin = skin;
     entry->transform = root;
-    entry->skeleton = skeleton;
+    entry->pose = pose;
+    entry->diffuse_color = diffuse_color;
+}
+
+/// Adds a whole baked crowd to the scene draw calls, animated at time
+void PushBakedCrowd(PushBuffer *push_buffer, const BakedCrowdHandle crowd, const f32 time, Vec3 diffuse_color) {
+    PushBufferEntryBakedCrowd *entry = PushBufferGetEntry(push_buffer, PushBufferEntryBakedCrowd);
+    entry->type = PushBufferEntryType_BakedCrowd;
+    entry->crowd = crowd;
+    entry->time = time;
     entry->diffuse_color = diffuse_color;
 }
 
@@ -2,6 +2,7 @@
 
 typedef u32 MeshHandle;
 typedef u32 SkinnedMeshHandle;
+typedef u32 BakedCrowdHandle;
 
 // -----------
 // Push Buffer
@@ -10,6 +11,7 @@ typedef struct PushBuffer {
     u32 size;
     u32 max_size;
     void *buf;
+    sArena *arena; // Text entries copy their strings here. Reset with the push buffer each frame
 } PushBuffer;
 
 typedef enum PushBufferEntryType {
@@ -17,6 +19,7 @@ typedef enum PushBufferEntryType {
     PushBufferEntryType_Text,
     PushBufferEntryType_Mesh,
     PushBufferEntryType_SkinnedMesh,
+    PushBufferEntryType_BakedCrowd,
     PushBufferEntryType_Texture,
     PushBufferEntryType_AxisGizmo,
 } PushBufferEntryType;
@@ -29,7 +32,7 @@ typedef struct PushBufferEntryUIQuad {
 
 typedef struct PushBufferEntryText {
     PushBufferEntryType type;
-    char *text;
+    char *text; // Lives in the push buffer's arena
     u32 x, y;
     Vec4 colour;
 } PushBufferEntryText;
@@ -38,6 +41,7 @@ typedef struct PushBufferEntryMesh {
     PushBufferEntryType type;
     MeshHandle mesh;
     Transform* transform;
+    u32 matrix; // Index in Renderer.world_matrices, set by RendererBuildWorldMatrices
     Vec3 diffuse_color;
 } PushBufferEntryMesh;
 
@@ -45,10 +49,19 @@ typedef struct PushBufferEntrySkinnedMesh {
     PushBufferEntryType type;
     SkinnedMeshHandle skin;
     Transform* transform;
-    Transform* skeleton;
+    u32 matrix; // Index in Renderer.world_matrices, set by RendererBuildWorldMatrices
+    u32 pose; // Instance index in the skin's poses
     Vec3 diffuse_color;
 } PushBufferEntrySkinnedMesh;
 
+// Every instance of a baked crowd, in one draw. The instances have their own world matrices, see BakedCrowdInstance
+typedef struct PushBufferEntryBakedCrowd {
+    PushBufferEntryType type;
+    BakedCrowdHandle crowd;
+    f32 time; // Seconds, each instance adds its time offset
+    Vec3 diffuse_color;
+} PushBufferEntryBakedCrowd;
+
 typedef struct PushBufferEntryAxisGizmo {
     PushBufferEntryType type;
     Vec3 line[4]; // 0 = bone origin, 1 = X axis, 2 = Y axis, 3 = Z axis
@@ -61,7 +74,8 @@ typedef struct PushBufferEntryTexture {
 } PushBufferEntryTexture;
 
 void PushMesh(PushBuffer *push_buffer, const MeshHandle mesh, Transform *transform, Vec3 diffuse_color);
-void PushSkinnedMesh(PushBuffer *push_buffer, const SkinnedMeshHandle skinned_mesh, Transform *root, Transform *skeleton_root, Vec3 diffuse_color);
+void PushSkinnedMesh(PushBuffer *push_buffer, const SkinnedMeshHandle skinned_mesh, Transform *root, const u32 pose, Vec3 diffuse_color);
+void PushBakedCrowd(PushBuffer *push_buffer, const BakedCrowdHandle crowd, const f32 time, Vec3 diffuse_color);
 void UIPushQuad(PushBuffer *push_buffer, const u32 x, const u32 y, const u32 w, const u32 h, const Vec4 color);
 void UIPushText(PushBuffer *push_buffer, const char *text, const u32 x, const u32 y, const Vec4 color);
 void UIPushFmt(PushBuffer *push_buffer, const u32 x, const u32 y, const Vec4 color, const char *fmt, ...);
@@ -7,17 +7,150 @@ AnimationHandle : ArrayGetElementAt(renderer->animations, value),\
 SkinHandle: ArrayGetElementAt(renderer->skins, value), \
 default: assert(0))
 
-void SkinCalcChildXform(u32 joint, SkinnedMesh *skin, Transform *skeleton) {
-    for(u32 i = 0; i < skin->joint_child_count[joint]; i++) {
-        u32 child = skin->joint_children[joint][i];
-        Mat4 tmp;
-        Transform *xform = &skeleton[child];
-        transform_to_mat4(xform, &tmp);
-        mat4_mul(skin->global_joint_mats[joint], tmp, skin->global_joint_mats[child]);
-        SkinCalcChildXform(child, skin, skeleton);
+// Linear blend of the from and to palettes into the drawn palette
+void SkinBlendPalette(Pose *pose, const f32 blend) {
+    const f32 *from = (const f32 *)pose->palette_from;
+    const f32 *to = (const f32 *)pose->palette_to;
+    f32 *result = (f32 *)pose->palette;
+    const u32 count = pose->joint_count * 16;
+    for(u32 i = 0; i < count; i++) {
+        result[i] = from[i] + blend * (to[i] - from[i]);
     }
 }
 
+// Returns the index of a new instance, initialized to the bind pose
+u32 SkinAllocPose(SkinnedMesh *skin) {
+    SkinPoses *poses = &skin->poses;
+    u32 index;
+    if(poses->free_count > 0) {
+        index = poses->free_list[--poses->free_count];
+    } else {
+        if(poses->high_water == poses->capacity) {
+            u32 new_capacity = poses->capacity ? poses->capacity * 2 : 4;
+            u32 joint_slots = new_capacity * skin->joint_count;
+            poses->translations = sReallocTagged(poses->translations, joint_slots * sizeof(Vec3), MEM_TAG_ANIMATION);
+            poses->rotations = sReallocTagged(poses->rotations, joint_slots * sizeof(Quat), MEM_TAG_ANIMATION);
+            poses->scales = sReallocTagged(poses->scales, joint_slots * sizeof(Vec3), MEM_TAG_ANIMATION);
+            poses->global_mats = sReallocTagged(poses->global_mats, joint_slots * sizeof(Mat4), MEM_TAG_ANIMATION);
+            poses->palettes = sReallocTagged(poses->palettes, joint_slots * sizeof(Mat4), MEM_TAG_ANIMATION);
+            poses->lod_palettes = sReallocTagged(poses->lod_palettes, 2 * joint_slots * sizeof(Mat4), MEM_TAG_ANIMATION);
+            poses->free_list = sReallocTagged(poses->free_list, new_capacity * sizeof(u32), MEM_TAG_ANIMATION);
+            poses->capacity = new_capacity;
+        }
+        index = poses->high_water++;
+    }
+    poses->count++;
+    
+    u32 first = index * skin->joint_count;
+    for(u32 i = 0; i < skin->joint_count; i++) {
+        poses->translations[first + i] = skin->joint_xforms[i].translation;
+        poses->rotations[first + i] = skin->joint_xforms[i].rotation;
+        poses->scales[first + i] = skin->joint_xforms[i].scale;
+    }
+    // Instances that aren't animated are drawn with this palette
+    Pose pose = SkinGetPose(skin, index);
+    SkinUpdatePalette(skin, &pose);
+    return index;
+}
+
+void SkinFreePose(SkinnedMesh *skin, u32 pose) {
+    ASSERT(pose < skin->poses.high_water);
+    skin->poses.free_list[skin->poses.free_count++] = pose;
+    skin->poses.count--;
+}
+
+Pose SkinGetPose(const SkinnedMesh *skin, u32 pose) {
+    ASSERT(pose < skin->poses.high_water);
+    u32 first = pose * skin->joint_count;
+    Pose result;
+    result.joint_count = skin->joint_count;
+    result.translations = skin->poses.translations + first;
+    result.rotations = skin->poses.rotations + first;
+    result.scales = skin->poses.scales + first;
+    result.global_mats = skin->poses.global_mats + first;
+    result.palette = skin->poses.palettes + first;
+    result.palette_from = skin->poses.lod_palettes + 2 * first;
+    result.palette_to = result.palette_from + skin->joint_count;
+    return result;
+}
+
+void RendererFreePose(Renderer *renderer, SkinnedMeshHandle skin, u32 pose) {
+    SkinnedMesh *ptr = sPoolGet(&renderer->skins, skin);
+    if(ptr) { // The skin may already be destroyed along with its poses
+        SkinFreePose(ptr, pose);
+    }
+}
+
+// PlatformWorkCallback_t, data is an AnimationJob
+internal void AnimationJobRun(void *data) {
+    AnimationJob *job = (AnimationJob *)data;
+    for(u32 i = 0; i < job->count; i++) {
+        AnimationInstance *instance = &job->instances[i];
+        Pose pose = SkinGetPose(instance->skin, instance->pose);
+        const u64 palette_size = pose.joint_count * sizeof(Mat4);
+        switch(instance->update) {
+            case ANIMATION_UPDATE_FULL: {
+                AnimationEvaluateLayers(instance->layers, instance->layer_count, instance->skin->joint_xforms, &job->scratch, &pose);
+                SkinUpdatePalette(instance->skin, &pose);
+            } break;
+            case ANIMATION_UPDATE_RESET: {
+                AnimationEvaluateLayers(instance->layers, instance->layer_count, instance->skin->joint_xforms, &job->scratch, &pose);
+                SkinUpdatePalette(instance->skin, &pose);
+                memcpy(pose.palette_from, pose.palette, palette_size);
+                memcpy(pose.palette_to, pose.palette, palette_size);
+            } break;
+            case ANIMATION_UPDATE_KEY: {
+                memcpy(pose.palette_from, pose.palette, palette_size);
+                AnimationEvaluateLayers(instance->layers, instance->layer_count, instance->skin->joint_xforms, &job->scratch, &pose);
+                SkinUpdatePalette(instance->skin, &pose);
+                memcpy(pose.palette_to, pose.palette, palette_size);
+                SkinBlendPalette(&pose, instance->blend);
+            } break;
+            case ANIMATION_UPDATE_BLEND: {
+                SkinBlendPalette(&pose, instance->blend);
+            } break;
+        }
+    }
+}
+
+// Evaluates the instances, then their global matrices and palettes, in up to job_count jobs run by the platform's workers,
+// see AnimationSplitJobs.
+// Each instance writes only to its own pose and samplers, so an instance must appear once and the poses can't be
+// allocated or freed until this returns.
+// Each job gets a scratch pose for the layers from arena, which must live until this returns.
+void RendererAnimateInstances(PlatformAPI *platform, sArena *arena, AnimationInstance *instances, const u32 count, const u32 job_count) {
+    if(count == 0) {
+        return;
+    }
+    u32 max_layered_joints = 0;
+    for(u32 i = 0; i < count; i++) {
+        if(instances[i].layer_count > 1 && instances[i].skin->joint_count > max_layered_joints) {
+            max_layered_joints = instances[i].skin->joint_count;
+        }
+    }
+    // 3 arrays aligned on 16, see PosePush. Rounded to 16 so the scratches of the jobs follow each other.
+    const u64 scratch_size = max_layered_joints > 0 ? (max_layered_joints * (2 * sizeof(Vec3) + sizeof(Quat)) + 3 * 16 + 15) & ~15ull : 0;
+
+    AnimationJob jobs[ANIMATION_MAX_JOBS];
+    u32 used_jobs = AnimationSplitJobs(instances, count, job_count, jobs);
+    // Without room for a scratch per job the instances share one job, without room for one they aren't updated
+    const u64 scratch_room = sArenaGetRemaining(arena, 16);
+    if(used_jobs * scratch_size > scratch_room) {
+        if(scratch_size > scratch_room) {
+            sError("Animation : no room in the frame arena for the layers, %u instances not updated", count);
+            return;
+        }
+        sWarn("Animation : no room in the frame arena for %u layer scratches, running 1 job", used_jobs);
+        used_jobs = AnimationSplitJobs(instances, count, 1, jobs);
+    }
+    u8 *scratch = scratch_size > 0 ? sArenaPushAligned(arena, used_jobs * scratch_size, 16) : NULL;
+    for(u32 j = 0; j < used_jobs; j++) {
+        jobs[j].scratch = scratch ? sArenaCreateFromMemory(scratch + j * scratch_size, scratch_size) : (sArena){0};
+        platform->AddWork(&AnimationJobRun, &jobs[j]);
+    }
+    platform->CompleteAllWork();
+}
+
 void RendererSetSunDirection(Renderer *renderer, const Vec3 direction) {
     Mat4 ortho;
     mat4_ortho_zoom_gl(1.0f, 17.0f, -100.0f, 100.0f, ortho);
@@ -34,7 +167,7 @@ void RendererSetSunDirection(Renderer *renderer, const Vec3 direction) {
 void RendererSetCamera(Renderer *renderer, const Mat4 view, const Vec3 pos) {
     renderer->camera_pos = pos;
     memcpy(renderer->camera_view, view, 16 * sizeof(f32));
-    mat4_inverse(view, renderer->camera_view_inverse);
+    mat4_inverse_affine(view, renderer->camera_view_inverse);
 }
 
 DLL_EXPORT u32 GetRendererSize() {
@@ -47,32 +180,78 @@ void UpdateCameraProj(Renderer *renderer) {
     mat4_inverse(renderer->camera_proj, renderer->camera_proj_inverse);
 }
 
+// Gathers the transforms of the scene entries and converts them all at once.
+// Transforms are copied when the frame is drawn, so entries still see the changes made after they were pushed.
+void RendererBuildWorldMatrices(Renderer *renderer) {
+    PushBuffer *pushb = &renderer->scene_pushbuffer;
+    u32 smallest_entry = MIN(sizeof(PushBufferEntryMesh), sizeof(PushBufferEntrySkinnedMesh));
+    u32 max_count = pushb->size / smallest_entry;
+    Transform *xforms = sArenaPushAligned(renderer->frame_arena, max_count * sizeof(Transform), 64);
+    
+    u32 count = 0;
+    for(u32 address = 0; address < pushb->size;) {
+        PushBufferEntryType *type = (PushBufferEntryType *)(pushb->buf + address);
+        switch(*type) {
+            case PushBufferEntryType_Mesh: {
+                PushBufferEntryMesh *entry = (PushBufferEntryMesh *)(pushb->buf + address);
+                entry->matrix = count;
+                xforms[count++] = *entry->transform;
+                address += sizeof(PushBufferEntryMesh);
+            } break;
+            case PushBufferEntryType_SkinnedMesh: {
+                PushBufferEntrySkinnedMesh *entry = (PushBufferEntrySkinnedMesh *)(pushb->buf + address);
+                entry->matrix = count;
+                xforms[count++] = *entry->transform;
+                address += sizeof(PushBufferEntrySkinnedMesh);
+            } break;
+            case PushBufferEntryType_BakedCrowd: {
+                // The instances have their matrices on the GPU
+                address += sizeof(PushBufferEntryBakedCrowd);
+            } break;
+            default : {
+                ASSERT(0);
+            }
+        };
+    }
+    
+    renderer->world_matrices = sArenaPushAligned(renderer->frame_arena, count * sizeof(Mat4), 64);
+    renderer->world_matrix_count = count;
+    transforms_to_mat4_batch(xforms, count, renderer->world_matrices);
+}
+
 DLL_EXPORT void RendererInit(Renderer *renderer, PlatformAPI *platform_api, PlatformWindow *window) {
     renderer->window = window;
     
     // Arrays
-    renderer->meshes     = sArrayCreate(8, sizeof(Mesh));
-    renderer->skins      = sArrayCreate(1, sizeof(SkinnedMesh));
-    renderer->animations = sArrayCreate(1, sizeof(Animation));
+    renderer->meshes     = sPoolCreate(8, sizeof(Mesh));
+    renderer->skins      = sPoolCreate(1, sizeof(SkinnedMesh));
+    renderer->animations = sPoolCreate(4, sizeof(Animation));
+    renderer->animation_libraries = sPoolCreate(1, sizeof(AnimationLibrary));
+    renderer->baked_animations = sPoolCreate(1, sizeof(BakedAnimation));
+    renderer->baked_crowds = sPoolCreate(1, sizeof(BakedCrowd));
     
     // Init push buffers
+    sArena *permanent = &platform_api->memory->permanent;
+    renderer->frame_arena = &platform_api->memory->frame;
+    
     renderer->ui_pushbuffer.size = 0;
+    renderer->ui_pushbuffer.arena = renderer->frame_arena;
     renderer->ui_pushbuffer.max_size = sizeof(PushBufferEntryText) * 256;
-    renderer->ui_pushbuffer.buf = sCalloc(renderer->ui_pushbuffer.max_size, 1);
+    renderer->ui_pushbuffer.buf = sCallocTagged(renderer->ui_pushbuffer.max_size, 1, MEM_TAG_RENDER);
     
     // Scene
     renderer->scene_pushbuffer.size = 0;
     renderer->scene_pushbuffer.max_size = sizeof(PushBufferEntryMesh) * 70;
-    renderer->scene_pushbuffer.buf = sCalloc(renderer->scene_pushbuffer.max_size, 1);
+    renderer->scene_pushbuffer.buf = sCallocTagged(renderer->scene_pushbuffer.max_size, 1, MEM_TAG_RENDER);
     
     // Debug 
     renderer->debug_pushbuffer.size = 0;
     renderer->debug_pushbuffer.max_size = sizeof(PushBufferEntryAxisGizmo) * 100;
-    renderer->debug_pushbuffer.buf = sCalloc(renderer->debug_pushbuffer.max_size, 1);
+    renderer->debug_pushbuffer.buf = sCallocTagged(renderer->debug_pushbuffer.max_size, 1, MEM_TAG_RENDER);
     
     UpdateCameraProj(renderer);
     
-    renderer->backend = sCalloc(1, sizeof(RendererBackend));
+    renderer->backend = sArenaPushArray(permanent, 1, RendererBackend);
     BackendRendererInit(renderer->backend, platform_api, window);
 }
 
@@ -85,30 +264,193 @@ DLL_EXPORT void RendererInitBackend(Renderer *renderer, PlatformAPI *platform_ap
 
 DLL_EXPORT void RendererDestroy(Renderer *renderer) {
     
+    // The backend lives in the permanent arena
     BackendRendererDestroy(renderer->backend);
-    sFree(renderer->backend);
     
     sFree(renderer->ui_pushbuffer.buf);
     sFree(renderer->scene_pushbuffer.buf);
     sFree(renderer->debug_pushbuffer.buf);
     
     // Meshes
-    for(u32 i = 0; i < renderer->meshes.count; i++) {
-        DestroyMesh((Mesh *)sArrayGet(renderer->meshes, i));
+    for(u32 i = 0; i < renderer->meshes.high_water; i++) {
+        Mesh *mesh = sPoolGetAt(&renderer->meshes, i);
+        if(mesh) {
+            DestroyMesh(mesh);
+        }
+    }
+    sPoolDestroy(&renderer->meshes);
+    
+    // Baked crowds, before the skins they draw
+    for(u32 i = 0; i < renderer->baked_crowds.high_water; i++) {
+        BakedCrowd *crowd = sPoolGetAt(&renderer->baked_crowds, i);
+        if(crowd) {
+            DestroyBakedCrowdBuffers(crowd);
+        }
+    }
+    sPoolDestroy(&renderer->baked_crowds);
+    for(u32 i = 0; i < renderer->baked_animations.high_water; i++) {
+        BakedAnimation *baked = sPoolGetAt(&renderer->baked_animations, i);
+        if(baked) {
+            DestroyBakedAnimation(baked);
+        }
     }
-    sArrayDestroy(renderer->meshes);
+    sPoolDestroy(&renderer->baked_animations);
     
     // Skins
-    for(u32 i = 0; i < renderer->skins.count; i++) {
-        DestroySkin(renderer, (SkinnedMesh *)sArrayGet(renderer->skins, i));
+    for(u32 i = 0; i < renderer->skins.high_water; i++) {
+        SkinnedMesh *skin = sPoolGetAt(&renderer->skins, i);
+        if(skin) {
+            DestroySkin(renderer, skin);
+        }
     }
-    sArrayDestroy(renderer->skins);
+    sPoolDestroy(&renderer->skins);
     
-    // Animations
-    for(u32 i = 0; i < renderer->animations.count; i++) {
-        DestroyAnimation((Animation *)sArrayGet(renderer->animations, i));
+    // Animations, the clips' data is in the libraries' storage
+    for(u32 i = 0; i < renderer->animation_libraries.high_water; i++) {
+        AnimationLibrary *library = sPoolGetAt(&renderer->animation_libraries, i);
+        if(library) {
+            sFree(library->storage.base);
+        }
+    }
+    sPoolDestroy(&renderer->animation_libraries);
+    sPoolDestroy(&renderer->animations);
+}
+
+void RendererDestroyMesh(Renderer *renderer, MeshHandle mesh) {
+    Mesh *ptr = sPoolGet(&renderer->meshes, mesh);
+    if(ptr) {
+        DestroyMesh(ptr);
+        sPoolRemove(&renderer->meshes, mesh);
+    }
+}
+
+void RendererDestroySkin(Renderer *renderer, SkinnedMeshHandle skin) {
+    SkinnedMesh *ptr = sPoolGet(&renderer->skins, skin);
+    if(ptr) {
+        DestroySkin(renderer, ptr);
+        sPoolRemove(&renderer->skins, skin);
+    }
+}
+
+void RendererDestroyAnimationLibrary(Renderer *renderer, AnimationLibraryHandle library) {
+    AnimationLibrary *ptr = sPoolGet(&renderer->animation_libraries, library);
+    if(ptr) {
+        for(u32 i = 0; i < ptr->clip_count; i++) {
+            sPoolRemove(&renderer->animations, ptr->clips[i]);
+        }
+        sFree(ptr->storage.base);
+        sPoolRemove(&renderer->animation_libraries, library);
+    }
+}
+
+// Loads every clip, then moves them all to one block sized for them
+void LoadAnimationLibrary(Renderer *renderer, AnimationLibrary *library, const GLTF *gltf) {
+    library->clip_count = gltf->animation_count;
+    u64 storage_size = library->clip_count * (sizeof(AnimationHandle) + sizeof(sStringID)) + 2 * ANIMATION_STORAGE_ALIGNMENT;
+    AnimationHandle *clips = sCalloc(library->clip_count, sizeof(AnimationHandle));
+    for(u32 i = 0; i < library->clip_count; i++) {
+        clips[i] = sPoolAdd(&renderer->animations);
+        Animation *clip = sPoolGet(&renderer->animations, clips[i]);
+        LoadAnimation(clip, gltf, i);
+        if(ANIMATION_RESAMPLE_RATE > 0.0f) {
+            AnimationResample(clip, ANIMATION_RESAMPLE_RATE);
+        }
+        if(ANIMATION_COMPRESS) {
+            AnimationCompress(clip);
+        }
+        storage_size += AnimationStorageSize(clip);
+    }
+    
+    library->storage = sArenaCreateFromMemory(sCallocTagged(storage_size, 1, MEM_TAG_ANIMATION), storage_size);
+    library->clips = sArenaPushAligned(&library->storage, library->clip_count * sizeof(AnimationHandle), ANIMATION_STORAGE_ALIGNMENT);
+    library->names = sArenaPushAligned(&library->storage, library->clip_count * sizeof(sStringID), ANIMATION_STORAGE_ALIGNMENT);
+    for(u32 i = 0; i < library->clip_count; i++) {
+        library->clips[i] = clips[i];
+        library->names[i] = gltf->animations[i].name;
+        AnimationMoveToStorage(sPoolGet(&renderer->animations, clips[i]), &library->storage);
+    }
+    sFree(clips);
+    sLog("LOAD - Animations - %u clips, %llu bytes", library->clip_count, library->storage.used);
+}
+
+AnimationHandle AnimationLibraryGetClip(const AnimationLibrary *library, const u32 id) {
+    ASSERT(id < library->clip_count);
+    return library->clips[id];
+}
+
+// Returns 0 if no clip has this name
+AnimationHandle AnimationLibraryFindClip(const AnimationLibrary *library, const char *name) {
+    sStringID id = sInternFind(name);
+    for(u32 i = 0; id != STRING_ID_NONE && i < library->clip_count; i++) {
+        if(library->names[i] == id) {
+            return library->clips[i];
+        }
+    }
+    return 0;
+}
+
+// --------
+// Baked animation
+
+// Bakes the clip played by the skin at about rate frames per second
+BakedAnimationHandle RendererBakeAnimation(Renderer *renderer, SkinnedMeshHandle skin, AnimationHandle animation, const f32 rate) {
+    const SkinnedMesh *skin_ptr = sPoolGet(&renderer->skins, skin);
+    const Animation *clip = sPoolGet(&renderer->animations, animation);
+    ASSERT(skin_ptr && clip);
+    BakedAnimationHandle handle = sPoolAdd(&renderer->baked_animations);
+    BakedAnimation *baked = sPoolGet(&renderer->baked_animations, handle);
+    baked->joint_count = skin_ptr->joint_count;
+    baked->frame_count = (u32)ceilf(clip->length * rate);
+    if(baked->frame_count == 0) {
+        baked->frame_count = 1;
+    }
+    baked->frame_rate = clip->length > 0.0f ? baked->frame_count / clip->length : 0.0f;
+    
+    // The texels grow with the clip's length and the joint count, past what the scratch arena holds for long clips.
+    // Only the pose of the frame being baked comes from scratch.
+    f32 *texels = sMallocTagged((u64)baked->frame_count * baked->joint_count * 12 * sizeof(f32), MEM_TAG_ANIMATION);
+    AnimationBakePalettes(skin_ptr, clip, baked->frame_count, &renderer->backend->scratch, texels);
+    UploadBakedAnimation(baked, texels);
+    sFree(texels);
+    sLog("LOAD - Baked animation - %u frames of %u joints", baked->frame_count, baked->joint_count);
+    return handle;
+}
+
+void RendererDestroyBakedAnimation(Renderer *renderer, BakedAnimationHandle animation) {
+    BakedAnimation *ptr = sPoolGet(&renderer->baked_animations, animation);
+    if(ptr) {
+        DestroyBakedAnimation(ptr);
+        sPoolRemove(&renderer->baked_animations, animation);
+    }
+}
+
+// The crowd uses the skin's vertex buffers, destroy it before the skin
+BakedCrowdHandle RendererCreateBakedCrowd(Renderer *renderer, SkinnedMeshHandle skin, BakedAnimationHandle animation, const BakedCrowdInstance *instances, const u32 count) {
+    const SkinnedMesh *skin_ptr = sPoolGet(&renderer->skins, skin);
+    ASSERT(skin_ptr);
+    BakedCrowdHandle handle = sPoolAdd(&renderer->baked_crowds);
+    BakedCrowd *crowd = sPoolGet(&renderer->baked_crowds, handle);
+    crowd->skin = skin;
+    crowd->animation = animation;
+    CreateBakedCrowdBuffers(crowd, &skin_ptr->mesh);
+    UploadBakedCrowdInstances(crowd, instances, count);
+    return handle;
+}
+
+// Replaces every instance of the crowd
+void RendererUpdateBakedCrowd(Renderer *renderer, BakedCrowdHandle crowd, const BakedCrowdInstance *instances, const u32 count) {
+    BakedCrowd *ptr = sPoolGet(&renderer->baked_crowds, crowd);
+    if(ptr) {
+        UploadBakedCrowdInstances(ptr, instances, count);
+    }
+}
+
+void RendererDestroyBakedCrowd(Renderer *renderer, BakedCrowdHandle crowd) {
+    BakedCrowd *ptr = sPoolGet(&renderer->baked_crowds, crowd);
+    if(ptr) {
+        DestroyBakedCrowdBuffers(ptr);
+        sPoolRemove(&renderer->baked_crowds, crowd);
     }
-    sArrayDestroy(renderer->animations);
 }
 
 MeshHandle LoadQuad(Renderer *renderer) {
@@ -213,8 +555,8 @@ EntityID InstantiateSkin(Renderer *renderer, World *world, SkinnedMeshHandle ski
     EntityID result = WorldCreateAndGetEntity(world, &entity);
 
     entity->skinned_mesh = skinned_mesh;
-    SkinnedMesh *skin = sArrayGet(renderer->skins, skinned_mesh);
-    entity->skeleton = sCalloc(skin->joint_count, sizeof(Transform));
+    SkinnedMesh *skin = sPoolGet(&renderer->skins, skinned_mesh);
+    entity->pose = SkinAllocPose(skin);
     entity->render_type = RenderingType_SkinnedMesh;
     return result;
 }
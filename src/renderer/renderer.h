@@ -29,6 +29,38 @@ typedef struct Mesh {
 
 typedef u32 MeshHandle;
 
+// View on the joints of one skin instance, see SkinGetPose
+// global_mats are relative to the skinned mesh, palette is what the shaders get. Both are set by SkinUpdatePalette
+// Throttled instances draw a blend of palette_from and palette_to, see ANIMATION_UPDATE_KEY
+typedef struct Pose {
+    u32 joint_count;
+    Vec3 *translations;
+    Quat *rotations;
+    Vec3 *scales;
+    Mat4 *global_mats;
+    Mat4 *palette;
+    Mat4 *palette_from;
+    Mat4 *palette_to;
+} Pose;
+
+// Poses of every instance of a skin, packed SoA and instance-major :
+// the joints of instance i are at [i * joint_count, (i + 1) * joint_count) in each array.
+// Instances are referenced by index, the arrays move when they grow so don't keep pointers to them.
+typedef struct SkinPoses {
+    u32 capacity;   // Instances that fit in the arrays
+    u32 high_water; // Instances used at least once
+    u32 count;      // Live instances
+    u32 *free_list; // Stack of freed instance indices
+    u32 free_count;
+    
+    Vec3 *translations;
+    Quat *rotations;
+    Vec3 *scales;
+    Mat4 *global_mats;
+    Mat4 *palettes;
+    Mat4 *lod_palettes; // From and to palettes of each instance, 2 * joint_count per instance
+} SkinPoses;
+
 typedef struct SkinnedMesh {
     Mesh mesh;
 
@@ -39,12 +71,10 @@ typedef struct SkinnedMesh {
     // C'est sur ce nouveau skelette qu'il faudra influer et non sur celui-ci.
     // Il est read only.
     Transform *joint_xforms;
-    Mat4 *global_joint_mats;
+    SkinPoses poses;
     
+    // Joints are sorted so that a parent comes before its children, -1 for the roots
     i32 *joint_parents;
-    
-    u32 *joint_child_count;
-    u32 **joint_children;
     Mat4 *inverse_bind_matrices;
 } SkinnedMesh;
 
@@ -70,6 +100,17 @@ typedef struct AnimationTrack {
     u32 key_count;
     f32 *key_times;
     void *keys;
+    // Keys evenly spaced by key_interval starting at key_times[0], the key is found with a multiply
+    // Both are 0 when the spacing is irregular
+    f32 key_interval;
+    f32 inv_key_interval;
+    
+    // Compressed tracks, see AnimationCompress. key_times is NULL and the keys are 3 u16 each.
+    // The time of key k is Animation.frame_times[key_frames[k]]
+    u16 *key_frames;
+    // Vec3 keys decode to range_min + key * range_scale
+    Vec3 range_min;
+    Vec3 range_scale;
     
     u32 target_node;
     AnimationTarget target;
@@ -80,10 +121,125 @@ typedef struct Animation {
     f32 length;
     u32 track_count;
     AnimationTrack *tracks;
+    
+    // Time track shared by the compressed tracks, NULL when uncompressed
+    u32 frame_count;
+    f32 *frame_times;
+    f32 frame_interval;
+    f32 inv_frame_interval;
 } Animation;
 
 typedef u32 AnimationHandle;
 
+// Every clip of a glTF, imported in one pass. The tracks and keys of all the clips are packed in storage.
+// Clips are in Renderer.animations like the others, entities share them by handle.
+typedef struct AnimationLibrary {
+    u32 clip_count;
+    AnimationHandle *clips;
+    sStringID *names; // Clip names from the file, STRING_ID_NONE for the unnamed ones
+    sArena storage;   // Owns its block
+} AnimationLibrary;
+
+typedef u32 AnimationLibraryHandle;
+
+// Per instance lookup state, remembers the last key found for each track of an animation
+// Playback moves forward by a key or two per frame, so the search starts from there
+typedef struct AnimationSampler {
+    u32 track_count;
+    u32 *cursors;
+    u32 frame_cursor;
+} AnimationSampler;
+
+// How a layer is combined with the layers under it, see AnimationEvaluateLayers
+typedef enum AnimationBlendMode {
+    ANIMATION_BLEND_OVERRIDE, // Blended toward the layer by its weight, for crossfades
+    ANIMATION_BLEND_ADDITIVE, // The layer's difference with the rest pose is added, scaled by its weight
+} AnimationBlendMode;
+
+// One clip of a layered evaluation. The first layer is the base, its weight is ignored.
+typedef struct AnimationLayer {
+    const Animation *animation;
+    AnimationSampler *sampler;
+    f32 time;
+    f32 weight;
+    AnimationBlendMode mode;
+    const f32 *joint_weights; // Multiplies weight for each joint, NULL for every joint at 1
+} AnimationLayer;
+
+// What the animation update does for an instance
+typedef enum AnimationUpdate {
+    ANIMATION_UPDATE_FULL,  // Evaluate at time
+    ANIMATION_UPDATE_RESET, // Evaluate at time, and start blending from there
+    // The instance is updated every few frames. The palette drawn until the next key becomes palette_from,
+    // the pose is evaluated at time, which is ahead, into palette_to and the drawn palette blends between the two.
+    // Skinning is linear in the joint matrices, so this is the same as blending the skinned vertices.
+    ANIMATION_UPDATE_KEY,
+    ANIMATION_UPDATE_BLEND, // Only blend the palettes by blend
+} AnimationUpdate;
+
+// One animated skin instance, see RendererAnimateInstances
+typedef struct AnimationInstance {
+    AnimationLayer *layers;
+    u32 layer_count;
+    const SkinnedMesh *skin;
+    u32 pose;
+    AnimationUpdate update;
+    f32 blend; // Weight of palette_to, KEY and BLEND only
+} AnimationInstance;
+
+// Contiguous range of instances updated by one worker. Instances don't share any mutable state.
+typedef struct AnimationJob {
+    AnimationInstance *instances;
+    u32 count;
+    sArena scratch; // Pose buffers of the layered instances
+} AnimationJob;
+
+// Instances per job when the caller doesn't choose the job count
+#define ANIMATION_JOB_SIZE 64
+#define ANIMATION_MAX_JOBS 64
+
+// Keys per second of the resampled animations, 0 keeps the keys from the file
+#define ANIMATION_RESAMPLE_RATE 0.0f
+// Compress the animations when they are loaded, see AnimationCompress
+#define ANIMATION_COMPRESS true
+
+// --------
+// Baked animation
+// A clip sampled at a fixed rate into joint matrices once, at load, for crowds drawn without any CPU skinning.
+// The texture has one row per frame and 3 RGBA32F texels per joint : the first 3 rows of its joint matrix,
+// the last one is always (0, 0, 0, 1). The shader blends the two frames around the time and loops.
+typedef struct BakedAnimation {
+    u32 texture;
+    u32 joint_count;
+    u32 frame_count;
+    f32 frame_rate; // Frames per second, the bake rate rounded so that the clip is a whole number of frames
+} BakedAnimation;
+
+typedef u32 BakedAnimationHandle;
+
+// Frames per second of the baked animations
+#define BAKED_ANIMATION_RATE 30.0f
+// Most instances in one baked crowd, the instances are built in the frame arena
+#define BAKED_CROWD_MAX_INSTANCES 65536
+
+// One character of a baked crowd, in the instance buffer
+typedef struct BakedCrowdInstance {
+    Mat4 world;
+    f32 time_offset; // Seconds added to the time of the crowd, spreads the instances over the clip
+} BakedCrowdInstance;
+
+// Instances of a skin playing a baked animation, drawn in one instanced call.
+// The instances stay on the GPU, the CPU only touches them in RendererUpdateBakedCrowd.
+typedef struct BakedCrowd {
+    SkinnedMeshHandle skin;
+    BakedAnimationHandle animation;
+    u32 vertex_array; // The skin's vertex and index buffers, plus the instance buffer
+    u32 instance_buffer;
+    u32 instance_count;
+} BakedCrowd;
+
+typedef u32 BakedCrowdHandle;
+
 // --------
 // Renderer
 typedef struct Renderer {
@@ -96,10 +252,19 @@ typedef struct Renderer {
     PushBuffer scene_pushbuffer;
     PushBuffer ui_pushbuffer;
     PushBuffer debug_pushbuffer;
+    sArena *frame_arena; // Platform's frame arena. Reset at the end of each frame, along with the push buffers
     
-    sArray meshes;
-    sArray skins;
-    sArray animations;
+    // World matrix of each scene entry, built once per frame and shared by the shadow and color passes
+    Mat4 *world_matrices;
+    u32 world_matrix_count;
+    
+    // Resources are accessed through generational handles, a stale handle gets NULL from sPoolGet
+    sPool meshes;
+    sPool skins;
+    sPool animations; // Clips, owned by the libraries
+    sPool animation_libraries;
+    sPool baked_animations;
+    sPool baked_crowds;
     //sArray transforms;
     
     // Uniform data
@@ -113,17 +278,53 @@ typedef struct Renderer {
     Vec3 light_dir;
 } Renderer;
 
-void SkinCalcChildXform(u32 joint_id, SkinnedMesh *skin, Transform *skeleton);
+void SkinCalcGlobalMats(const SkinnedMesh *skin, const Mat4 root_xform, Pose *pose);
+void SkinUpdatePalette(const SkinnedMesh *skin, Pose *pose);
+void SkinBlendPalette(Pose *pose, const f32 blend);
+u32 SkinAllocPose(SkinnedMesh *skin);
+void SkinFreePose(SkinnedMesh *skin, u32 pose);
+Pose SkinGetPose(const SkinnedMesh *skin, u32 pose);
+void RendererFreePose(Renderer *renderer, SkinnedMeshHandle skin, u32 pose);
 void UpdateCameraProj(Renderer *renderer);
+void RendererBuildWorldMatrices(Renderer *renderer);
+void RendererAnimateInstances(PlatformAPI *platform, sArena *arena, AnimationInstance *instances, const u32 count, const u32 job_count);
 
 MeshHandle LoadMeshFromVertices(Renderer *renderer, const Vertex *vertices, const u32 vertex_count, const u32 *indices, const u32 index_count);
-void LoadFromGLTF(const char *path, Renderer *renderer, PlatformAPI *platform, MeshHandle *mesh, SkinnedMeshHandle *skin, Animation *animation);
+void LoadFromGLTF(const char *path, Renderer *renderer, PlatformAPI *platform, MeshHandle *mesh, SkinnedMeshHandle *skin, AnimationLibraryHandle *animations);
 MeshHandle LoadQuad(Renderer *renderer);
 MeshHandle LoadCube(Renderer *renderer);
 
-void LoadAnimation(Animation *animation, const GLTF *gltf);
+void RendererDestroyMesh(Renderer *renderer, MeshHandle mesh);
+void RendererDestroySkin(Renderer *renderer, SkinnedMeshHandle skin);
+void RendererDestroyAnimationLibrary(Renderer *renderer, AnimationLibraryHandle library);
+
+void LoadAnimationLibrary(Renderer *renderer, AnimationLibrary *library, const GLTF *gltf);
+AnimationHandle AnimationLibraryGetClip(const AnimationLibrary *library, const u32 id);
+AnimationHandle AnimationLibraryFindClip(const AnimationLibrary *library, const char *name);
+void LoadAnimation(Animation *animation, const GLTF *gltf, const u32 index);
+u64 AnimationStorageSize(const Animation *anim);
+void AnimationMoveToStorage(Animation *anim, sArena *storage);
 void DestroyAnimation(Animation *anim);
-void AnimationEvaluate(const Animation *animation, Transform *target, f32 time);
+void AnimationResample(Animation *animation, const f32 rate);
+void AnimationCompress(Animation *animation);
+void AnimationSamplerInit(AnimationSampler *sampler, const Animation *animation);
+void AnimationSamplerDestroy(AnimationSampler *sampler);
+f32 AnimationWrapTime(const f32 time, const f32 length);
+void AnimationEvaluate(const Animation *animation, AnimationSampler *sampler, Pose *target, f32 time);
+void AnimationEvaluateLayers(const AnimationLayer *layers, const u32 layer_count, const Transform *rest_pose, sArena *scratch, Pose *target);
+u32 AnimationSplitJobs(AnimationInstance *instances, const u32 count, u32 job_count, AnimationJob *jobs);
+void AnimationBakePalettes(const SkinnedMesh *skin, const Animation *animation, const u32 frame_count, sArena *scratch, f32 *texels);
+Pose PosePush(sArena *arena, const u32 joint_count);
+void PoseSetRest(Pose *pose, const Transform *rest_pose);
+void PoseBlend(const Pose *a, const Pose *b, const f32 weight, const f32 *joint_weights, Pose *result);
+void PoseMakeAdditive(Pose *pose, const Transform *rest_pose);
+void PoseAdd(Pose *base, const Pose *additive, const f32 weight, const f32 *joint_weights);
+
+BakedAnimationHandle RendererBakeAnimation(Renderer *renderer, SkinnedMeshHandle skin, AnimationHandle animation, const f32 rate);
+void RendererDestroyBakedAnimation(Renderer *renderer, BakedAnimationHandle animation);
+BakedCrowdHandle RendererCreateBakedCrowd(Renderer *renderer, SkinnedMeshHandle skin, BakedAnimationHandle animation, const BakedCrowdInstance *instances, const u32 count);
+void RendererUpdateBakedCrowd(Renderer *renderer, BakedCrowdHandle crowd, const BakedCrowdInstance *instances, const u32 count);
+void RendererDestroyBakedCrowd(Renderer *renderer, BakedCrowdHandle crowd);
 
 void RendererSetCamera(Renderer *renderer, const Mat4 view, const Vec3 pos);
 void RendererSetSunDirection(Renderer *renderer, const Vec3 direction);
@@ -1,8 +1,14 @@
 
-#include <sl3dge-utils/sl3dge.h>
+#include "utils/sl3dge.h"
 
 #include <stdio.h>
-#include "collision.h"
+#include "collision.c"
+#include "platform/platform.h"
+#include "utils/sGltf.c"
+#include "renderer/pushbuffer.h"
+#include "renderer/pushbuffer.c"
+#include "renderer/renderer.h"
+#include "renderer/animation.c"
 
 void TestHuffman() {
     // @Test This test code isn't valid anymore
@@ -71,16 +77,1826 @@ void TestMat() {
     sLog("MAT");
 
     Vec3 scale = (Vec3){2.3f, 5.6f, 0.4f};
-    Mat4 mat = mat4_identity();
-    mat4_scaleby(&mat, scale);
+    Mat4 mat;
+    mat4_identity(mat);
+    mat4_scaleby(mat, scale);
 
-    Vec3 result = mat4_get_scale(&mat);
+    Vec3 result = mat4_get_scale(mat);
     TEST_EQUALS(scale.x, result.x, "%.2f");
     TEST_EQUALS(scale.y, result.y, "%.2f");
     TEST_EQUALS(scale.y, result.y, "%.2f");
     sLog("");
 }
 
+internal f32 RandomRange(f32 min, f32 max) {
+    return min + (max - min) * ((f32)rand() / (f32)RAND_MAX);
+}
+
+internal void RandomMat4(f32 *mat) {
+    for(u32 i = 0; i < 16; i++) {
+        mat[i] = RandomRange(-10.0f, 10.0f);
+    }
+}
+
+internal bool NearlyEqual(const f32 a, const f32 b) {
+    // Relative, FMA rounds differently than separate mul and add
+    return fabsf(a - b) <= 1e-5f * fmaxf(1.0f, fmaxf(fabsf(a), fabsf(b)));
+}
+
+void TestMatSIMD() {
+    sLog("MAT SIMD (%s)", SMATH_SIMD_NAME);
+    
+    srand(1234);
+    bool mul_ok = true;
+    bool vec4_ok = true;
+    bool vec3_ok = true;
+    for(u32 n = 0; n < 1000; n++) {
+        Mat4 a, b, expected, result;
+        RandomMat4(a);
+        RandomMat4(b);
+        mat4_mul_scalar(a, b, expected);
+        mat4_mul(a, b, result);
+        for(u32 i = 0; i < 16; i++) {
+            mul_ok &= NearlyEqual(result[i], expected[i]);
+        }
+        
+        Vec4 v4 = {RandomRange(-10.0f, 10.0f), RandomRange(-10.0f, 10.0f), RandomRange(-10.0f, 10.0f), RandomRange(-10.0f, 10.0f)};
+        Vec4 r4 = mat4_mul_vec4(a, v4);
+        Vec4 e4 = mat4_mul_vec4_scalar(a, v4);
+        vec4_ok &= NearlyEqual(r4.x, e4.x) && NearlyEqual(r4.y, e4.y) && NearlyEqual(r4.z, e4.z) && NearlyEqual(r4.w, e4.w);
+        
+        Vec3 v3 = {v4.x, v4.y, v4.z};
+        Vec3 r3 = mat4_mul_vec3(a, v3);
+        Vec3 e3 = mat4_mul_vec3_scalar(a, v3);
+        vec3_ok &= NearlyEqual(r3.x, e3.x) && NearlyEqual(r3.y, e3.y) && NearlyEqual(r3.z, e3.z);
+    }
+    TEST_BOOL(mul_ok);
+    TEST_BOOL(vec4_ok);
+    TEST_BOOL(vec3_ok);
+    sLog("");
+}
+
+internal void RandomTransform(Transform *xform) {
+    xform->translation = (Vec3){RandomRange(-100.0f, 100.0f), RandomRange(-100.0f, 100.0f), RandomRange(-100.0f, 100.0f)};
+    xform->rotation = quat_normalize(quat(RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f)));
+    xform->scale = (Vec3){RandomRange(0.1f, 3.0f), RandomRange(0.1f, 3.0f), RandomRange(0.1f, 3.0f)};
+}
+
+void TestTRSBatch() {
+    sLog("TRS BATCH (%s)", SMATH_SIMD_NAME);
+    
+    // 19 covers a group of 8, a group of 4 and a scalar tail
+    const u32 count = 19;
+    Transform xforms[19];
+    Vec3 t[19], s[19];
+    Quat r[19];
+    for(u32 i = 0; i < count; i++) {
+        RandomTransform(&xforms[i]);
+        t[i] = xforms[i].translation;
+        r[i] = xforms[i].rotation;
+        s[i] = xforms[i].scale;
+    }
+    
+    Mat4 expected[19], from_xforms[19], from_trs[19];
+    for(u32 i = 0; i < count; i++) {
+        transform_to_mat4(&xforms[i], &expected[i]);
+    }
+    transforms_to_mat4_batch(xforms, count, from_xforms);
+    trs_quat_to_mat4_batch(t, r, s, count, from_trs);
+    
+    bool xforms_ok = true;
+    bool trs_ok = true;
+    for(u32 i = 0; i < count; i++) {
+        for(u32 e = 0; e < 16; e++) {
+            xforms_ok &= NearlyEqual(from_xforms[i][e], expected[i][e]);
+            trs_ok &= NearlyEqual(from_trs[i][e], expected[i][e]);
+        }
+    }
+    TEST_BOOL(xforms_ok);
+    TEST_BOOL(trs_ok);
+    sLog("");
+}
+
+internal bool NearlyEqualMat4(const f32 *a, const f32 *b, const f32 tolerance) {
+    for(u32 i = 0; i < 16; i++) {
+        if(fabsf(a[i] - b[i]) > tolerance * fmaxf(1.0f, fmaxf(fabsf(a[i]), fabsf(b[i])))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestAffineInverse() {
+    sLog("AFFINE INVERSE");
+    
+    srand(4321);
+    bool affine_ok = true;
+    bool transform_ok = true;
+    bool uniform_ok = true;
+    bool identity_ok = true;
+    Mat4 identity;
+    mat4_identity(identity);
+    for(u32 n = 0; n < 1000; n++) {
+        Transform xform;
+        RandomTransform(&xform);
+        Mat4 m, expected, result;
+        transform_to_mat4(&xform, &m);
+        mat4_inverse(m, expected);
+        
+        mat4_inverse_affine(m, result);
+        affine_ok &= NearlyEqualMat4(result, expected, 1e-3f);
+        Mat4 product;
+        mat4_mul(m, result, product);
+        identity_ok &= NearlyEqualMat4(product, identity, 1e-3f);
+        
+        transform_inverse_to_mat4(&xform, result);
+        transform_ok &= NearlyEqualMat4(result, expected, 1e-3f);
+        
+        // transform_inverse is only exact with a uniform scale
+        xform.scale.y = xform.scale.x;
+        xform.scale.z = xform.scale.x;
+        transform_to_mat4(&xform, &m);
+        mat4_inverse(m, expected);
+        Transform inverse;
+        transform_inverse(&xform, &inverse);
+        transform_to_mat4(&inverse, &result);
+        uniform_ok &= NearlyEqualMat4(result, expected, 1e-3f);
+    }
+    TEST_BOOL(affine_ok);
+    TEST_BOOL(identity_ok);
+    TEST_BOOL(transform_ok);
+    TEST_BOOL(uniform_ok);
+    sLog("");
+}
+
+internal Vec3 RandomVec3(f32 min, f32 max) {
+    return (Vec3){RandomRange(min, max), RandomRange(min, max), RandomRange(min, max)};
+}
+
+internal Quat RandomQuat() {
+    return quat_normalize(quat(RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f), RandomRange(-1.0f, 1.0f)));
+}
+
+internal bool NearlyEqualVec3(const Vec3 a, const Vec3 b) {
+    return NearlyEqual(a.x, b.x) && NearlyEqual(a.y, b.y) && NearlyEqual(a.z, b.z);
+}
+
+internal bool NearlyEqualQuat(const Quat a, const Quat b, const f32 tolerance) {
+    return fabsf(a.x - b.x) <= tolerance && fabsf(a.y - b.y) <= tolerance && fabsf(a.z - b.z) <= tolerance && fabsf(a.w - b.w) <= tolerance;
+}
+
+void TestMathWide4() {
+    sLog("MATH WIDE x4 (%s)", SMATH_SIMD_NAME);
+    
+    srand(44);
+    bool load_ok = true;
+    bool arithmetic_ok = true;
+    bool dot_ok = true;
+    bool cross_ok = true;
+    bool normalize_ok = true;
+    bool lerp_ok = true;
+    bool select_ok = true;
+    bool rotate_ok = true;
+    bool quat_ok = true;
+    bool nlerp_ok = true;
+    bool slerp_ok = true;
+    for(u32 n = 0; n < 250; n++) {
+        Vec3 a[4], b[4];
+        Quat qa[4], qb[4];
+        f32 s[4], t[4];
+        u32 indices[4];
+        for(u32 i = 0; i < 4; i++) {
+            a[i] = RandomVec3(-10.0f, 10.0f);
+            b[i] = RandomVec3(-10.0f, 10.0f);
+            qa[i] = RandomQuat();
+            qb[i] = RandomQuat();
+            s[i] = RandomRange(-2.0f, 2.0f);
+            t[i] = RandomRange(0.0f, 1.0f);
+            indices[i] = 4 - 1 - i;
+        }
+        
+        Vec3x4 wa = vec3x4_load(a);
+        Vec3x4 wb = vec3x4_gather(b, indices);
+        Quatx4 wqa = quatx4_load(qa);
+        Quatx4 wqb = quatx4_gather(qb, indices);
+        f32x4 ws = f32x4_load(s);
+        f32x4 wt = f32x4_load(t);
+        f32x4 mask = f32x4_cmplt(wt, f32x4_set1(0.5f));
+        
+        Vec3 add[4], sub[4], mul[4], scale[4], cross[4], normalize[4], lerp[4], select[4], rotate[4], gathered[4];
+        Quat quat_normalized[4], quat_selected[4], nlerp[4], slerp[4], quat_gathered[4];
+        alignas(32) f32 dot[4], length[4], quat_dot[4];
+        vec3x4_store(wb, gathered);
+        quatx4_store(wqb, quat_gathered);
+        vec3x4_store(vec3x4_add(wa, wb), add);
+        vec3x4_store(vec3x4_sub(wa, wb), sub);
+        vec3x4_store(vec3x4_mul(wa, wb), mul);
+        vec3x4_store(vec3x4_scale(wa, ws), scale);
+        f32x4_store(vec3x4_dot(wa, wb), dot);
+        vec3x4_store(vec3x4_cross(wa, wb), cross);
+        f32x4_store(vec3x4_length(wa), length);
+        vec3x4_store(vec3x4_normalize(wa), normalize);
+        vec3x4_store(vec3x4_lerp(wa, wb, wt), lerp);
+        vec3x4_store(vec3x4_select(mask, wa, wb), select);
+        vec3x4_store(vec3x4_rotate(wa, wqa), rotate);
+        f32x4_store(quatx4_dot(wqa, wqb), quat_dot);
+        quatx4_store(quatx4_normalize(quatx4_set1(quat(1.0f, 2.0f, 3.0f, 4.0f))), quat_normalized);
+        quatx4_store(quatx4_select(mask, wqa, wqb), quat_selected);
+        quatx4_store(quatx4_nlerp(wqa, wqb, wt), nlerp);
+        quatx4_store(quatx4_slerp(wqa, wqb, wt), slerp);
+        
+        for(u32 i = 0; i < 4; i++) {
+            Vec3 bi = b[indices[i]];
+            Quat qbi = qb[indices[i]];
+            load_ok &= NearlyEqualVec3(gathered[i], bi) && NearlyEqualQuat(quat_gathered[i], qbi, 0.0f);
+            arithmetic_ok &= NearlyEqualVec3(add[i], vec3_add(a[i], bi)) && NearlyEqualVec3(sub[i], vec3_sub(a[i], bi)) &&
+                NearlyEqualVec3(mul[i], vec3_mul(a[i], bi)) && NearlyEqualVec3(scale[i], vec3_fmul(a[i], s[i]));
+            dot_ok &= NearlyEqual(dot[i], vec3_dot(a[i], bi));
+            cross_ok &= NearlyEqualVec3(cross[i], vec3_cross(a[i], bi));
+            normalize_ok &= NearlyEqual(length[i], vec3_length(a[i])) && NearlyEqualVec3(normalize[i], vec3_normalize(a[i]));
+            lerp_ok &= NearlyEqualVec3(lerp[i], vec3_lerp(a[i], bi, t[i]));
+            select_ok &= NearlyEqualVec3(select[i], t[i] < 0.5f ? a[i] : bi) && NearlyEqualQuat(quat_selected[i], t[i] < 0.5f ? qa[i] : qbi, 0.0f);
+            rotate_ok &= NearlyEqualVec3(rotate[i], vec3_rotate(a[i], qa[i]));
+            quat_ok &= NearlyEqual(quat_dot[i], qa[i].x * qbi.x + qa[i].y * qbi.y + qa[i].z * qbi.z + qa[i].w * qbi.w) &&
+                NearlyEqualQuat(quat_normalized[i], quat_normalize(quat(1.0f, 2.0f, 3.0f, 4.0f)), 1e-6f);
+            nlerp_ok &= NearlyEqualQuat(nlerp[i], quat_nlerp(qa[i], qbi, t[i]), 1e-5f);
+            slerp_ok &= NearlyEqualQuat(slerp[i], quat_slerp(qa[i], qbi, t[i]), 1e-4f);
+        }
+    }
+    TEST_BOOL(load_ok);
+    TEST_BOOL(arithmetic_ok);
+    TEST_BOOL(dot_ok);
+    TEST_BOOL(cross_ok);
+    TEST_BOOL(normalize_ok);
+    TEST_BOOL(lerp_ok);
+    TEST_BOOL(select_ok);
+    TEST_BOOL(rotate_ok);
+    TEST_BOOL(quat_ok);
+    TEST_BOOL(nlerp_ok);
+    TEST_BOOL(slerp_ok);
+    sLog("");
+}
+
+void TestMathWide8() {
+    sLog("MATH WIDE x8 (%s)", SMATH_SIMD_NAME);
+    
+    srand(88);
+    bool load_ok = true;
+    bool arithmetic_ok = true;
+    bool dot_ok = true;
+    bool cross_ok = true;
+    bool normalize_ok = true;
+    bool lerp_ok = true;
+    bool select_ok = true;
+    bool rotate_ok = true;
+    bool quat_ok = true;
+    bool nlerp_ok = true;
+    bool slerp_ok = true;
+    for(u32 n = 0; n < 250; n++) {
+        Vec3 a[8], b[8];
+        Quat qa[8], qb[8];
+        f32 s[8], t[8];
+        u32 indices[8];
+        for(u32 i = 0; i < 8; i++) {
+            a[i] = RandomVec3(-10.0f, 10.0f);
+            b[i] = RandomVec3(-10.0f, 10.0f);
+            qa[i] = RandomQuat();
+            qb[i] = RandomQuat();
+            s[i] = RandomRange(-2.0f, 2.0f);
+            t[i] = RandomRange(0.0f, 1.0f);
+            indices[i] = 8 - 1 - i;
+        }
+        
+        Vec3x8 wa = vec3x8_load(a);
+        Vec3x8 wb = vec3x8_gather(b, indices);
+        Quatx8 wqa = quatx8_load(qa);
+        Quatx8 wqb = quatx8_gather(qb, indices);
+        f32x8 ws = f32x8_load(s);
+        f32x8 wt = f32x8_load(t);
+        f32x8 mask = f32x8_cmplt(wt, f32x8_set1(0.5f));
+        
+        Vec3 add[8], sub[8], mul[8], scale[8], cross[8], normalize[8], lerp[8], select[8], rotate[8], gathered[8];
+        Quat quat_normalized[8], quat_selected[8], nlerp[8], slerp[8], quat_gathered[8];
+        alignas(32) f32 dot[8], length[8], quat_dot[8];
+        vec3x8_store(wb, gathered);
+        quatx8_store(wqb, quat_gathered);
+        vec3x8_store(vec3x8_add(wa, wb), add);
+        vec3x8_store(vec3x8_sub(wa, wb), sub);
+        vec3x8_store(vec3x8_mul(wa, wb), mul);
+        vec3x8_store(vec3x8_scale(wa, ws), scale);
+        f32x8_store(vec3x8_dot(wa, wb), dot);
+        vec3x8_store(vec3x8_cross(wa, wb), cross);
+        f32x8_store(vec3x8_length(wa), length);
+        vec3x8_store(vec3x8_normalize(wa), normalize);
+        vec3x8_store(vec3x8_lerp(wa, wb, wt), lerp);
+        vec3x8_store(vec3x8_select(mask, wa, wb), select);
+        vec3x8_store(vec3x8_rotate(wa, wqa), rotate);
+        f32x8_store(quatx8_dot(wqa, wqb), quat_dot);
+        quatx8_store(quatx8_normalize(quatx8_set1(quat(1.0f, 2.0f, 3.0f, 4.0f))), quat_normalized);
+        quatx8_store(quatx8_select(mask, wqa, wqb), quat_selected);
+        quatx8_store(quatx8_nlerp(wqa, wqb, wt), nlerp);
+        quatx8_store(quatx8_slerp(wqa, wqb, wt), slerp);
+        
+        for(u32 i = 0; i < 8; i++) {
+            Vec3 bi = b[indices[i]];
+            Quat qbi = qb[indices[i]];
+            load_ok &= NearlyEqualVec3(gathered[i], bi) && NearlyEqualQuat(quat_gathered[i], qbi, 0.0f);
+            arithmetic_ok &= NearlyEqualVec3(add[i], vec3_add(a[i], bi)) && NearlyEqualVec3(sub[i], vec3_sub(a[i], bi)) &&
+                NearlyEqualVec3(mul[i], vec3_mul(a[i], bi)) && NearlyEqualVec3(scale[i], vec3_fmul(a[i], s[i]));
+            dot_ok &= NearlyEqual(dot[i], vec3_dot(a[i], bi));
+            cross_ok &= NearlyEqualVec3(cross[i], vec3_cross(a[i], bi));
+            normalize_ok &= NearlyEqual(length[i], vec3_length(a[i])) && NearlyEqualVec3(normalize[i], vec3_normalize(a[i]));
+            lerp_ok &= NearlyEqualVec3(lerp[i], vec3_lerp(a[i], bi, t[i]));
+            select_ok &= NearlyEqualVec3(select[i], t[i] < 0.5f ? a[i] : bi) && NearlyEqualQuat(quat_selected[i], t[i] < 0.5f ? qa[i] : qbi, 0.0f);
+            rotate_ok &= NearlyEqualVec3(rotate[i], vec3_rotate(a[i], qa[i]));
+            quat_ok &= NearlyEqual(quat_dot[i], qa[i].x * qbi.x + qa[i].y * qbi.y + qa[i].z * qbi.z + qa[i].w * qbi.w) &&
+                NearlyEqualQuat(quat_normalized[i], quat_normalize(quat(1.0f, 2.0f, 3.0f, 4.0f)), 1e-6f);
+            nlerp_ok &= NearlyEqualQuat(nlerp[i], quat_nlerp(qa[i], qbi, t[i]), 1e-5f);
+            slerp_ok &= NearlyEqualQuat(slerp[i], quat_slerp(qa[i], qbi, t[i]), 1e-4f);
+        }
+    }
+    TEST_BOOL(load_ok);
+    TEST_BOOL(arithmetic_ok);
+    TEST_BOOL(dot_ok);
+    TEST_BOOL(cross_ok);
+    TEST_BOOL(normalize_ok);
+    TEST_BOOL(lerp_ok);
+    TEST_BOOL(select_ok);
+    TEST_BOOL(rotate_ok);
+    TEST_BOOL(quat_ok);
+    TEST_BOOL(nlerp_ok);
+    TEST_BOOL(slerp_ok);
+    sLog("");
+}
+
+void TestMat4Wide() {
+    sLog("MAT4 WIDE (%s)", SMATH_SIMD_NAME);
+    
+    srand(808);
+    bool load_ok = true;
+    bool trs_ok = true;
+    bool mul_ok = true;
+    bool vec3_ok = true;
+    for(u32 n = 0; n < 250; n++) {
+        Mat4 a[4], b[4], stored[4];
+        Transform xforms[4];
+        Vec3 t[4], s[4], points[4];
+        Quat r[4];
+        for(u32 i = 0; i < 4; i++) {
+            RandomMat4(a[i]);
+            RandomMat4(b[i]);
+            RandomTransform(&xforms[i]);
+            t[i] = xforms[i].translation;
+            r[i] = xforms[i].rotation;
+            s[i] = xforms[i].scale;
+            points[i] = RandomVec3(-10.0f, 10.0f);
+        }
+        
+        Mat4x4 wa, wb, wr;
+        mat4x4_load(a, &wa);
+        mat4x4_load(b, &wb);
+        mat4x4_store(&wa, stored);
+        
+        mat4x4_from_trs(vec3x4_load(t), quatx4_load(r), vec3x4_load(s), &wr);
+        Mat4 from_trs[4];
+        mat4x4_store(&wr, from_trs);
+        
+        mat4x4_mul(&wa, &wb, &wr);
+        Mat4 products[4];
+        mat4x4_store(&wr, products);
+        
+        Vec3 transformed[4];
+        vec3x4_store(mat4x4_mul_vec3(&wa, vec3x4_load(points)), transformed);
+        
+        for(u32 i = 0; i < 4; i++) {
+            load_ok &= memcmp(stored[i], a[i], sizeof(Mat4)) == 0;
+            Mat4 expected;
+            trs_quat_to_mat4(&t[i], &r[i], &s[i], expected);
+            trs_ok &= NearlyEqualMat4(from_trs[i], expected, 1e-5f);
+            mat4_mul_scalar(a[i], b[i], expected);
+            mul_ok &= NearlyEqualMat4(products[i], expected, 1e-5f);
+            vec3_ok &= NearlyEqualVec3(transformed[i], mat4_mul_vec3_scalar(a[i], points[i]));
+        }
+    }
+    TEST_BOOL(load_ok);
+    TEST_BOOL(trs_ok);
+    TEST_BOOL(mul_ok);
+    TEST_BOOL(vec3_ok);
+    sLog("");
+}
+
+// quat_slerp in double, without the shortcut quat_slerp takes for almost equal quaternions
+internal Quat SlerpReference(const Quat a, const Quat b, const f32 t) {
+    f64 dot = (f64)a.x * b.x + (f64)a.y * b.y + (f64)a.z * b.z + (f64)a.w * b.w;
+    f64 sign = dot < 0.0 ? -1.0 : 1.0;
+    f64 theta = acos(fmin(fabs(dot), 1.0));
+    f64 k0 = 1.0 - t;
+    f64 k1 = t;
+    if(theta > 1e-9) {
+        k0 = sin((1.0 - t) * theta) / sin(theta);
+        k1 = sin(t * theta) / sin(theta);
+    }
+    k1 *= sign;
+    f64 x = k0 * a.x + k1 * b.x;
+    f64 y = k0 * a.y + k1 * b.y;
+    f64 z = k0 * a.z + k1 * b.z;
+    f64 w = k0 * a.w + k1 * b.w;
+    f64 length = sqrt(x * x + y * y + z * z + w * w);
+    return quat(x / length, y / length, z / length, w / length);
+}
+
+void TestSlerpBatch() {
+    sLog("SLERP BATCH (%s)", SMATH_SIMD_NAME);
+    
+    srand(2024);
+    // 19 covers a group of 8, a group of 4 and a padded tail
+    const u32 count = 19;
+    Quat a[19], b[19], slerp[19], nlerp[19], scattered[19];
+    f32 t[19];
+    u32 targets[19];
+    bool slerp_ok = true;
+    bool nlerp_ok = true;
+    bool scatter_ok = true;
+    f32 max_error = 0.0f;
+    for(u32 n = 0; n < 2000; n++) {
+        for(u32 i = 0; i < count; i++) {
+            a[i] = RandomQuat();
+            // Every other pair is close, for the nlerp fast path
+            if(i & 1) {
+                b[i] = RandomQuat();
+            } else {
+                b[i] = quat_normalize(quat(a[i].x + RandomRange(-0.05f, 0.05f), a[i].y + RandomRange(-0.05f, 0.05f), a[i].z + RandomRange(-0.05f, 0.05f), a[i].w));
+            }
+            t[i] = RandomRange(0.0f, 1.0f);
+            targets[i] = (i * 7) % count;
+        }
+        quat_slerp_batch(a, b, t, count, slerp);
+        quat_nlerp_batch(a, b, t, count, nlerp);
+        quat_slerp_batch_scatter(a, b, t, count, targets, scattered);
+        
+        for(u32 i = 0; i < count; i++) {
+            Quat expected = SlerpReference(a[i], b[i], t[i]);
+            f32 error = fmaxf(fmaxf(fabsf(slerp[i].x - expected.x), fabsf(slerp[i].y - expected.y)), fmaxf(fabsf(slerp[i].z - expected.z), fabsf(slerp[i].w - expected.w)));
+            max_error = fmaxf(max_error, error);
+            slerp_ok &= error <= 2e-5f;
+            
+            Quat shortest = b[i];
+            if(a[i].x * b[i].x + a[i].y * b[i].y + a[i].z * b[i].z + a[i].w * b[i].w < 0.0f) {
+                shortest = quat(-b[i].x, -b[i].y, -b[i].z, -b[i].w);
+            }
+            nlerp_ok &= NearlyEqualQuat(nlerp[i], quat_nlerp(a[i], shortest, t[i]), 1e-5f);
+            scatter_ok &= NearlyEqualQuat(scattered[targets[i]], slerp[i], 0.0f);
+        }
+    }
+    sLog("Max slerp error %g", max_error);
+    TEST_BOOL(slerp_ok);
+    TEST_BOOL(nlerp_ok);
+    TEST_BOOL(scatter_ok);
+    sLog("");
+}
+
+void BenchSlerpBatch() {
+    sLog("BENCH SLERP BATCH");
+    
+    // 256 rounds of 4096 is 1M slerps, the totals in ms read as ns/op
+    const u32 count = 4096;
+    const u32 rounds = 256;
+    Quat *a = sCalloc(count, sizeof(Quat));
+    Quat *b = sCalloc(count, sizeof(Quat));
+    Quat *results = sCalloc(count, sizeof(Quat));
+    f32 *t = sCalloc(count, sizeof(f32));
+    for(u32 i = 0; i < count; i++) {
+        a[i] = RandomQuat();
+        b[i] = RandomQuat();
+        t[i] = RandomRange(0.0f, 1.0f);
+    }
+    
+    f32 sink = 0.0f;
+    sBeginTimer("quat_slerp x1M (ns/op)");
+    for(u32 round = 0; round < rounds; round++) {
+        for(u32 i = 0; i < count; i++) {
+            results[i] = quat_slerp(a[i], b[i], t[i]);
+        }
+        sink += results[round].x;
+    }
+    sEndTimer("quat_slerp x1M (ns/op)");
+    
+    sBeginTimer("quat_slerp_batch x1M (ns/op)");
+    for(u32 round = 0; round < rounds; round++) {
+        quat_slerp_batch(a, b, t, count, results);
+        sink += results[round].x;
+    }
+    sEndTimer("quat_slerp_batch x1M (ns/op)");
+    
+    sBeginTimer("quat_nlerp_batch x1M (ns/op)");
+    for(u32 round = 0; round < rounds; round++) {
+        quat_nlerp_batch(a, b, t, count, results);
+        sink += results[round].x;
+    }
+    sEndTimer("quat_nlerp_batch x1M (ns/op)");
+    
+    sLog("Checksum %f", sink);
+    sFree(a);
+    sFree(b);
+    sFree(results);
+    sFree(t);
+    sLog("");
+}
+
+internal f64 UlpError(const f32 result, const f64 expected) {
+    f32 magnitude = fabsf((f32)expected);
+    return fabs((f64)result - expected) / (nextafterf(magnitude, INFINITY) - magnitude);
+}
+
+// Each input goes through the scalar, x4 and x8 versions. scalar uses the input i, wide4 the inputs from o.
+#define FAST_MATH_RUN_(scalar, wide4, wide8, results)                                              \
+    for(u32 i = 0; i < 8; i++) {                                                                   \
+        results[0][i] = scalar;                                                                    \
+    }                                                                                              \
+    for(u32 o = 0; o < 8; o += 4) {                                                                \
+        f32x4_store(wide4, results[1] + o);                                                        \
+    }                                                                                              \
+    f32x8_store(wide8, results[2]);
+
+void TestFastMath() {
+    sLog("FAST MATH (%s)", SMATH_SIMD_NAME);
+    
+    alignas(32) f32 x[8], y[8];
+    alignas(32) f32 results[3][8];
+    
+    f64 sin_ulp = 0.0, sin_abs = 0.0, cos_ulp = 0.0, cos_abs = 0.0;
+    for(u32 n = 0; n < 200000; n++) {
+        for(u32 i = 0; i < 8; i++) {
+            x[i] = -8192.0f + (n * 8 + i) * (16384.0f / 1600000.0f);
+        }
+        FAST_MATH_RUN_(fast_sin(x[i]), fast_sin_x4(f32x4_load(x + o)), fast_sin_x8(f32x8_load(x)), results);
+        for(u32 v = 0; v < 3; v++) {
+            for(u32 i = 0; i < 8; i++) {
+                f64 expected = sin((f64)x[i]);
+                sin_abs = fmax(sin_abs, fabs(results[v][i] - expected));
+                if(fabsf(x[i]) <= PI / 4.0f || fabs(expected) >= 0.5) {
+                    sin_ulp = fmax(sin_ulp, UlpError(results[v][i], expected));
+                }
+            }
+        }
+        FAST_MATH_RUN_(fast_cos(x[i]), fast_cos_x4(f32x4_load(x + o)), fast_cos_x8(f32x8_load(x)), results);
+        for(u32 v = 0; v < 3; v++) {
+            for(u32 i = 0; i < 8; i++) {
+                f64 expected = cos((f64)x[i]);
+                cos_abs = fmax(cos_abs, fabs(results[v][i] - expected));
+                if(fabsf(x[i]) <= PI / 4.0f || fabs(expected) >= 0.5) {
+                    cos_ulp = fmax(cos_ulp, UlpError(results[v][i], expected));
+                }
+            }
+        }
+    }
+    // The sweep steps over [-pi/4, pi/4] too fast, go through it again
+    for(u32 n = 0; n < 100000; n++) {
+        for(u32 i = 0; i < 8; i++) {
+            x[i] = -PI / 4.0f + (n * 8 + i) * (PI / 2.0f / 800000.0f);
+        }
+        FAST_MATH_RUN_(fast_sin(x[i]), fast_sin_x4(f32x4_load(x + o)), fast_sin_x8(f32x8_load(x)), results);
+        for(u32 v = 0; v < 3; v++) {
+            for(u32 i = 0; i < 8; i++) {
+                sin_ulp = fmax(sin_ulp, UlpError(results[v][i], sin((f64)x[i])));
+            }
+        }
+        FAST_MATH_RUN_(fast_cos(x[i]), fast_cos_x4(f32x4_load(x + o)), fast_cos_x8(f32x8_load(x)), results);
+        for(u32 v = 0; v < 3; v++) {
+            for(u32 i = 0; i < 8; i++) {
+                cos_ulp = fmax(cos_ulp, UlpError(results[v][i], cos((f64)x[i])));
+            }
+        }
+    }
+    
+    f64 atan2_ulp = 0.0;
+    srand(99);
+    for(u32 n = 0; n < 100000; n++) {
+        // Magnitudes from 1e-5 to 1e5, every quadrant
+        for(u32 i = 0; i < 8; i++) {
+            y[i] = RandomRange(-1.0f, 1.0f) * powf(10.0f, (f32)(rand() % 11 - 5));
+            x[i] = RandomRange(-1.0f, 1.0f) * powf(10.0f, (f32)(rand() % 11 - 5));
+        }
+        FAST_MATH_RUN_(fast_atan2(y[i], x[i]), fast_atan2_x4(f32x4_load(y + o), f32x4_load(x + o)), fast_atan2_x8(f32x8_load(y), f32x8_load(x)), results);
+        for(u32 v = 0; v < 3; v++) {
+            for(u32 i = 0; i < 8; i++) {
+                atan2_ulp = fmax(atan2_ulp, UlpError(results[v][i], atan2((f64)y[i], (f64)x[i])));
+            }
+        }
+    }
+    
+    f64 acos_ulp = 0.0;
+    for(u32 n = 0; n < 250000; n++) {
+        for(u32 i = 0; i < 8; i++) {
+            x[i] = fminf(-1.0f + (n * 8 + i) * (2.0f / 1999999.0f), 1.0f);
+        }
+        FAST_MATH_RUN_(fast_acos(x[i]), fast_acos_x4(f32x4_load(x + o)), fast_acos_x8(f32x8_load(x)), results);
+        for(u32 v = 0; v < 3; v++) {
+            for(u32 i = 0; i < 8; i++) {
+                acos_ulp = fmax(acos_ulp, UlpError(results[v][i], acos((f64)x[i])));
+            }
+        }
+    }
+    
+    f64 rsqrt_ulp = 0.0;
+    for(u32 n = 0; n < 100000; n++) {
+        // From 2^-100 to 2^100
+        for(u32 i = 0; i < 8; i++) {
+            x[i] = ldexpf(RandomRange(1.0f, 2.0f), rand() % 200 - 100);
+        }
+        FAST_MATH_RUN_(fast_rsqrt(x[i]), fast_rsqrt_x4(f32x4_load(x + o)), fast_rsqrt_x8(f32x8_load(x)), results);
+        for(u32 v = 0; v < 3; v++) {
+            for(u32 i = 0; i < 8; i++) {
+                rsqrt_ulp = fmax(rsqrt_ulp, UlpError(results[v][i], 1.0 / sqrt((f64)x[i])));
+            }
+        }
+    }
+    
+    sLog("sin   %.2f ULP, %g absolute", sin_ulp, sin_abs);
+    sLog("cos   %.2f ULP, %g absolute", cos_ulp, cos_abs);
+    sLog("atan2 %.2f ULP", atan2_ulp);
+    sLog("acos  %.2f ULP", acos_ulp);
+    sLog("rsqrt %.2f ULP", rsqrt_ulp);
+    // The bounds documented in sFastMath.h
+    TEST_BOOL(sin_ulp <= 2.0 && sin_abs <= 1e-7);
+    TEST_BOOL(cos_ulp <= 2.0 && cos_abs <= 1e-7);
+    TEST_BOOL(atan2_ulp <= 4.0);
+    TEST_BOOL(acos_ulp <= 2.0);
+#if defined(SMATH_SSE2)
+    TEST_BOOL(rsqrt_ulp <= 4.0);
+#else
+    TEST_BOOL(rsqrt_ulp <= 2.0);
+#endif
+
+    // Zero and denormal vectors don't go through rsqrt
+    Vec3 zero = fast_vec3_normalize((Vec3){0.0f, 0.0f, 0.0f});
+    TEST_BOOL(zero.x == 0.0f && zero.y == 0.0f && zero.z == 0.0f);
+    Vec3 tiny = fast_vec3_normalize((Vec3){1e-30f, 0.0f, 0.0f});
+    TEST_BOOL(tiny.x == 0.0f && tiny.y == 0.0f && tiny.z == 0.0f);
+    Vec3 unit_x = fast_vec3_normalize((Vec3){3.0f, 0.0f, 0.0f});
+    TEST_BOOL(fabsf(unit_x.x - 1.0f) < 1e-6f && unit_x.y == 0.0f && unit_x.z == 0.0f);
+
+    // fast_quat_lookat against quat_lookat, then looking straight back where quat_lookat has no answer
+    const Vec3 up = {0.0f, 1.0f, 0.0f};
+    f32 lookat_error = 0.0f;
+    for(u32 n = 0; n < 10000; n++) {
+        Vec3 pos = {RandomRange(-10.0f, 10.0f), RandomRange(-10.0f, 10.0f), RandomRange(-10.0f, 10.0f)};
+        Vec3 dest = {RandomRange(-10.0f, 10.0f), RandomRange(-10.0f, 10.0f), RandomRange(-10.0f, 10.0f)};
+        Vec3 look = vec3_normalize(vec3_sub(dest, pos));
+        if(look.z < -0.99f) { // quat_lookat loses precision there too
+            continue;
+        }
+        Quat expected = quat_lookat(pos, dest, up);
+        Quat fast = fast_quat_lookat(pos, dest, up);
+        lookat_error = fmaxf(lookat_error, fabsf(fast.x - expected.x) + fabsf(fast.y - expected.y) + fabsf(fast.z - expected.z) + fabsf(fast.w - expected.w));
+    }
+    sLog("lookat %g absolute", lookat_error);
+    TEST_BOOL(lookat_error < 1e-5f);
+    Quat back = fast_quat_lookat((Vec3){0.0f, 0.0f, 0.0f}, (Vec3){0.0f, 0.0f, -2.0f}, up);
+    TEST_BOOL(back.x == 0.0f && back.y == 1.0f && back.z == 0.0f && back.w == 0.0f);
+    back = fast_quat_lookat((Vec3){0.0f, 0.0f, 0.0f}, (Vec3){1e-4f, 0.0f, -1.0f}, up);
+    TEST_BOOL(back.x == 0.0f && back.y == 1.0f && back.z == 0.0f && back.w == 0.0f);
+    Quat same = fast_quat_lookat((Vec3){1.0f, 2.0f, 3.0f}, (Vec3){1.0f, 2.0f, 3.0f}, up);
+    TEST_BOOL(same.x == 0.0f && same.y == 0.0f && same.z == 0.0f && fabsf(same.w - 1.0f) < 1e-6f);
+    sLog("");
+}
+
+void BenchFastMath() {
+    sLog("BENCH FAST MATH (%s)", SMATH_SIMD_NAME);
+    
+    // 256 rounds of 4096 is 1M values, the totals in ms read as ns/op
+    const u32 count = 4096;
+    const u32 rounds = 256;
+    f32 *inputs = sCalloc(count, sizeof(f32));
+    f32 *unit = sCalloc(count, sizeof(f32));
+    f32 *results = sCalloc(count, sizeof(f32));
+    for(u32 i = 0; i < count; i++) {
+        inputs[i] = RandomRange(-100.0f, 100.0f);
+        unit[i] = RandomRange(-1.0f, 1.0f);
+    }
+    
+    f32 sink = 0.0f;
+#define BENCH_FAST_MATH_(name, libm, fast, wide8)                                                  \
+    sBeginTimer(name " libm x1M (ns/op)");                                                         \
+    for(u32 round = 0; round < rounds; round++) {                                                  \
+        for(u32 i = 0; i < count; i++) {                                                           \
+            results[i] = libm;                                                                     \
+        }                                                                                          \
+        sink += results[round];                                                                    \
+    }                                                                                              \
+    sEndTimer(name " libm x1M (ns/op)");                                                           \
+    sBeginTimer(name " fast x1M (ns/op)");                                                         \
+    for(u32 round = 0; round < rounds; round++) {                                                  \
+        for(u32 i = 0; i < count; i++) {                                                           \
+            results[i] = fast;                                                                     \
+        }                                                                                          \
+        sink += results[round];                                                                    \
+    }                                                                                              \
+    sEndTimer(name " fast x1M (ns/op)");                                                           \
+    sBeginTimer(name " fast x8 x1M (ns/op)");                                                      \
+    for(u32 round = 0; round < rounds; round++) {                                                  \
+        for(u32 i = 0; i < count; i += 8) {                                                        \
+            f32x8_store(wide8, results + i);                                                       \
+        }                                                                                          \
+        sink += results[round];                                                                    \
+    }                                                                                              \
+    sEndTimer(name " fast x8 x1M (ns/op)");
+    
+    BENCH_FAST_MATH_("sin", sinf(inputs[i]), fast_sin(inputs[i]), fast_sin_x8(f32x8_load(inputs + i)));
+    BENCH_FAST_MATH_("atan2", atan2f(unit[i], inputs[i]), fast_atan2(unit[i], inputs[i]), fast_atan2_x8(f32x8_load(unit + i), f32x8_load(inputs + i)));
+    BENCH_FAST_MATH_("acos", acosf(unit[i]), fast_acos(unit[i]), fast_acos_x8(f32x8_load(unit + i)));
+    BENCH_FAST_MATH_("rsqrt", 1.0f / sqrtf(fabsf(inputs[i])), fast_rsqrt(fabsf(inputs[i])), fast_rsqrt_x8(f32x8_abs(f32x8_load(inputs + i))));
+#undef BENCH_FAST_MATH_
+    
+    sLog("Checksum %f", sink);
+    sFree(inputs);
+    sFree(unit);
+    sFree(results);
+    sLog("");
+}
+
+// One translation, rotation and scale track per joint, keys at rate per second.
+// jitter moves the inner keys by up to that fraction of the interval, 0 keeps them evenly spaced.
+internal void CreateTestAnimation(Animation *anim, const u32 joint_count, const f32 length, const f32 rate, const f32 jitter) {
+    const u32 key_count = (u32)(length * rate) + 1;
+    anim->length = length;
+    anim->frame_count = 0;
+    anim->frame_times = NULL;
+    anim->track_count = joint_count * 3;
+    anim->tracks = sCalloc(anim->track_count, sizeof(AnimationTrack));
+    for(u32 i = 0; i < anim->track_count; i++) {
+        AnimationTrack *track = &anim->tracks[i];
+        track->target_node = i / 3;
+        track->target = (AnimationTarget)(i % 3);
+        track->type = track->target == ANIM_TARGET_ROTATION ? ANIM_TYPE_QUATERNION : ANIM_TYPE_VEC3;
+        track->key_count = key_count;
+        track->key_times = sCalloc(key_count, sizeof(f32));
+        for(u32 k = 0; k < key_count; k++) {
+            f32 offset = (k == 0 || k == key_count - 1) ? 0.0f : RandomRange(-jitter, jitter);
+            track->key_times[k] = (k + offset) / rate;
+        }
+        if(track->type == ANIM_TYPE_QUATERNION) {
+            Quat *keys = sCalloc(key_count, sizeof(Quat));
+            for(u32 k = 0; k < key_count; k++) {
+                keys[k] = RandomQuat();
+            }
+            track->keys = keys;
+        } else {
+            Vec3 *keys = sCalloc(key_count, sizeof(Vec3));
+            for(u32 k = 0; k < key_count; k++) {
+                keys[k] = RandomVec3(-1.0f, 1.0f);
+            }
+            track->keys = keys;
+        }
+        AnimationTrackFindInterval(track);
+    }
+}
+
+internal Pose CreateTestPose(const u32 joint_count) {
+    Pose pose = {joint_count};
+    pose.translations = sCalloc(joint_count, sizeof(Vec3));
+    pose.rotations = sCalloc(joint_count, sizeof(Quat));
+    pose.scales = sCalloc(joint_count, sizeof(Vec3));
+    return pose;
+}
+
+internal void DestroyTestPose(Pose *pose) {
+    sFree(pose->translations);
+    sFree(pose->rotations);
+    sFree(pose->scales);
+}
+
+// q and -q are the same rotation, slerping from a different key can give either
+internal bool NearlyEqualPose(const Pose *a, const Pose *b, const f32 tolerance) {
+    for(u32 i = 0; i < a->joint_count; i++) {
+        Vec3 dt = vec3_sub(a->translations[i], b->translations[i]);
+        Vec3 ds = vec3_sub(a->scales[i], b->scales[i]);
+        if(fmaxf(fabsf(dt.x), fmaxf(fabsf(dt.y), fabsf(dt.z))) > tolerance || fmaxf(fabsf(ds.x), fmaxf(fabsf(ds.y), fabsf(ds.z))) > tolerance ||
+           !(NearlyEqualQuat(a->rotations[i], b->rotations[i], tolerance) || NearlyEqualQuat(a->rotations[i], quat(-b->rotations[i].x, -b->rotations[i].y, -b->rotations[i].z, -b->rotations[i].w), tolerance))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestAnimationSampler() {
+    sLog("ANIMATION SAMPLER");
+    const u32 joint_count = 8;
+    
+    // Same seed for the animation that gets resampled
+    srand(17);
+    Animation irregular;
+    CreateTestAnimation(&irregular, joint_count, 10.0f, 30.0f, 0.3f);
+    TEST_BOOL(irregular.tracks[0].inv_key_interval == 0.0f);
+    Animation uniform;
+    CreateTestAnimation(&uniform, joint_count, 10.0f, 30.0f, 0.0f);
+    TEST_BOOL(uniform.tracks[0].inv_key_interval > 0.0f);
+    
+    // Forward playback with loops, seeks backwards and big jumps forward
+    AnimationSampler sampler;
+    AnimationSamplerInit(&sampler, &irregular);
+    Pose searched = CreateTestPose(joint_count);
+    Pose cached = CreateTestPose(joint_count);
+    f32 time = 0.0f;
+    bool keys_ok = true;
+    bool poses_ok = true;
+    for(u32 frame = 0; frame < 2000; frame++) {
+        if(frame % 97 == 0) {
+            time = RandomRange(0.0f, irregular.length);
+        } else {
+            time = AnimationWrapTime(time + 1.0f / 60.0f, irregular.length);
+        }
+        AnimationEvaluate(&irregular, NULL, &searched, time);
+        AnimationEvaluate(&irregular, &sampler, &cached, time);
+        poses_ok &= memcmp(searched.translations, cached.translations, joint_count * sizeof(Vec3)) == 0;
+        poses_ok &= memcmp(searched.rotations, cached.rotations, joint_count * sizeof(Quat)) == 0;
+        poses_ok &= memcmp(searched.scales, cached.scales, joint_count * sizeof(Vec3)) == 0;
+        
+        const AnimationTrack *track = &irregular.tracks[frame % irregular.track_count];
+        if(time >= track->key_times[0] && time < track->key_times[track->key_count - 1]) {
+            u32 key = AnimationTrackFindKey(track, time, NULL);
+            keys_ok &= track->key_times[key] <= time && time < track->key_times[key + 1];
+        }
+    }
+    TEST_BOOL(keys_ok);
+    TEST_BOOL(poses_ok);
+    
+    // The multiply lookup of evenly spaced keys matches the search, up to the rounding of the key times
+    Pose uniform_pose = CreateTestPose(joint_count);
+    bool uniform_ok = true;
+    for(u32 i = 0; i < 1000; i++) {
+        time = RandomRange(0.0f, uniform.length);
+        AnimationEvaluate(&uniform, NULL, &uniform_pose, time);
+        for(u32 t = 0; t < uniform.track_count; t++) {
+            uniform.tracks[t].inv_key_interval = 0.0f;
+        }
+        AnimationEvaluate(&uniform, NULL, &searched, time);
+        for(u32 t = 0; t < uniform.track_count; t++) {
+            AnimationTrackFindInterval(&uniform.tracks[t]);
+        }
+        uniform_ok &= NearlyEqualPose(&uniform_pose, &searched, 1e-4f);
+    }
+    TEST_BOOL(uniform_ok);
+    
+    // Resampled keys go through the source animation, and the ends don't move
+    srand(17);
+    Animation resampled;
+    CreateTestAnimation(&resampled, joint_count, 10.0f, 30.0f, 0.3f);
+    AnimationResample(&resampled, 60.0f);
+    TEST_BOOL(resampled.tracks[0].key_count == 601);
+    TEST_BOOL(resampled.tracks[0].inv_key_interval > 0.0f);
+    TEST_BOOL(resampled.tracks[0].key_times[600] == 10.0f);
+    bool resampled_ok = true;
+    for(u32 k = 0; k < resampled.tracks[0].key_count; k += 7) {
+        time = resampled.tracks[0].key_times[k];
+        AnimationEvaluate(&irregular, NULL, &searched, time);
+        AnimationEvaluate(&resampled, NULL, &uniform_pose, time);
+        resampled_ok &= NearlyEqualPose(&searched, &uniform_pose, 1e-4f);
+    }
+    TEST_BOOL(resampled_ok);
+    
+    // Playback times loop into [0, length), a clip of length 0 stays at 0
+    TEST_BOOL(AnimationWrapTime(12.5f, 10.0f) == 2.5f);
+    TEST_BOOL(AnimationWrapTime(10.0f, 10.0f) == 0.0f);
+    TEST_BOOL(AnimationWrapTime(-2.5f, 10.0f) == 7.5f);
+    TEST_BOOL(AnimationWrapTime(3.0f, 0.0f) == 0.0f);
+    
+    DestroyTestPose(&searched);
+    DestroyTestPose(&cached);
+    DestroyTestPose(&uniform_pose);
+    AnimationSamplerDestroy(&sampler);
+    DestroyAnimation(&irregular);
+    DestroyAnimation(&uniform);
+    DestroyAnimation(&resampled);
+    sLog("");
+}
+
+void TestAnimationCompression() {
+    sLog("ANIMATION COMPRESSION");
+    const u32 joint_count = 8;
+    
+    // Evenly spaced keys like the exporters write, then keys at irregular times
+    const f32 jitters[] = {0.0f, 0.3f};
+    for(u32 j = 0; j < ARRAY_SIZE(jitters); j++) {
+        Animation clips[2];
+        for(u32 c = 0; c < 2; c++) {
+            srand(23);
+            CreateTestAnimation(&clips[c], joint_count, 10.0f, 30.0f, jitters[j]);
+            // Joint 0 moves in a straight line, rotates at a constant speed and keeps its scale
+            AnimationTrack *tracks = clips[c].tracks;
+            for(u32 k = 0; k < tracks[0].key_count; k++) {
+                f32 t = tracks[0].key_times[k];
+                ((Vec3 *)tracks[0].keys)[k] = (Vec3){t, 2.0f * t, -t};
+                ((Quat *)tracks[1].keys)[k] = quat_from_axis((Vec3){0.0f, 1.0f, 0.0f}, tracks[1].key_times[k] * 0.2f);
+                ((Vec3 *)tracks[2].keys)[k] = (Vec3){1.0f, 1.0f, 1.0f};
+            }
+        }
+        Animation *source = &clips[0];
+        Animation *compressed = &clips[1];
+        const u64 source_bytes = AnimationKeyBytes(source);
+        AnimationCompress(compressed);
+        TEST_BOOL(compressed->tracks[0].key_count == 2);
+        TEST_BOOL(compressed->tracks[1].key_count == 2);
+        TEST_BOOL(compressed->tracks[2].key_count == 1);
+        TEST_BOOL(compressed->tracks[3].key_count == source->tracks[3].key_count);
+        TEST_BOOL((compressed->inv_frame_interval > 0.0f) == (jitters[j] == 0.0f));
+        if(jitters[j] == 0.0f) {
+            TEST_BOOL(AnimationKeyBytes(compressed) * 2 < source_bytes);
+        }
+        
+        // Forward playback with jumps, the sampler finds the same keys as the search
+        AnimationSampler sampler;
+        AnimationSamplerInit(&sampler, compressed);
+        Pose expected = CreateTestPose(joint_count);
+        Pose searched = CreateTestPose(joint_count);
+        Pose cached = CreateTestPose(joint_count);
+        bool poses_ok = true;
+        bool cached_ok = true;
+        f32 time = 0.0f;
+        for(u32 frame = 0; frame < 2000; frame++) {
+            if(frame % 97 == 0) {
+                time = RandomRange(0.0f, source->length);
+            } else {
+                time = AnimationWrapTime(time + 1.0f / 60.0f, source->length);
+            }
+            AnimationEvaluate(source, NULL, &expected, time);
+            AnimationEvaluate(compressed, NULL, &searched, time);
+            AnimationEvaluate(compressed, &sampler, &cached, time);
+            poses_ok &= NearlyEqualPose(&expected, &searched, 5e-4f);
+            cached_ok &= memcmp(searched.rotations, cached.rotations, joint_count * sizeof(Quat)) == 0;
+            cached_ok &= memcmp(searched.translations, cached.translations, joint_count * sizeof(Vec3)) == 0;
+        }
+        TEST_BOOL(poses_ok);
+        TEST_BOOL(cached_ok);
+        
+        DestroyTestPose(&expected);
+        DestroyTestPose(&searched);
+        DestroyTestPose(&cached);
+        AnimationSamplerDestroy(&sampler);
+        DestroyAnimation(source);
+        DestroyAnimation(compressed);
+    }
+    sLog("");
+}
+
+void TestAnimationStorage() {
+    sLog("ANIMATION STORAGE");
+    const u32 joint_count = 8;
+    
+    // Two clips of one file, one of them compressed, moved to the same block
+    Animation heap[2];
+    Animation stored[2];
+    for(u32 c = 0; c < 2; c++) {
+        srand(31 + c);
+        CreateTestAnimation(&heap[c], joint_count, 5.0f, 30.0f, 0.3f);
+        srand(31 + c);
+        CreateTestAnimation(&stored[c], joint_count, 5.0f, 30.0f, 0.3f);
+    }
+    AnimationCompress(&heap[1]);
+    AnimationCompress(&stored[1]);
+    
+    u64 storage_size = AnimationStorageSize(&stored[0]) + AnimationStorageSize(&stored[1]);
+    sArena storage = sArenaCreate(storage_size);
+    AnimationMoveToStorage(&stored[0], &storage);
+    AnimationMoveToStorage(&stored[1], &storage);
+    TEST_BOOL(storage.used <= storage_size);
+    bool inside = true;
+    for(u32 c = 0; c < 2; c++) {
+        for(u32 i = 0; i < stored[c].track_count; i++) {
+            inside &= (u8 *)stored[c].tracks[i].keys >= storage.base && (u8 *)stored[c].tracks[i].keys < storage.base + storage.used;
+        }
+    }
+    TEST_BOOL(inside);
+    
+    Pose expected = CreateTestPose(joint_count);
+    Pose result = CreateTestPose(joint_count);
+    bool poses_ok = true;
+    for(u32 c = 0; c < 2; c++) {
+        for(u32 frame = 0; frame < 300; frame++) {
+            f32 time = AnimationWrapTime(frame / 60.0f, heap[c].length);
+            AnimationEvaluate(&heap[c], NULL, &expected, time);
+            AnimationEvaluate(&stored[c], NULL, &result, time);
+            poses_ok &= NearlyEqualPose(&expected, &result, 0.0f);
+        }
+    }
+    TEST_BOOL(poses_ok);
+    
+    DestroyTestPose(&expected);
+    DestroyTestPose(&result);
+    DestroyAnimation(&heap[0]);
+    DestroyAnimation(&heap[1]);
+    sArenaDestroy(&storage);
+    sLog("");
+}
+
+void TestPoseBlend() {
+    sLog("POSE BLEND");
+    // Not a multiple of 4, the last group is partial
+    const u32 joint_count = 7;
+    const f32 time = 1.3f;
+    Animation clips[2];
+    srand(41);
+    CreateTestAnimation(&clips[0], joint_count, 2.0f, 30.0f, 0.0f);
+    CreateTestAnimation(&clips[1], joint_count, 2.0f, 30.0f, 0.0f);
+    Transform rest_pose[7];
+    for(u32 i = 0; i < joint_count; i++) {
+        rest_pose[i] = (Transform){RandomVec3(-1.0f, 1.0f), RandomQuat(), RandomVec3(0.5f, 2.0f)};
+    }
+    
+    Pose a = CreateTestPose(joint_count);
+    Pose b = CreateTestPose(joint_count);
+    Pose expected = CreateTestPose(joint_count);
+    Pose result = CreateTestPose(joint_count);
+    AnimationEvaluate(&clips[0], NULL, &a, time);
+    AnimationEvaluate(&clips[1], NULL, &b, time);
+    
+    PoseBlend(&a, &b, 0.0f, NULL, &result);
+    TEST_BOOL(NearlyEqualPose(&result, &a, 1e-5f));
+    PoseBlend(&a, &b, 1.0f, NULL, &result);
+    TEST_BOOL(NearlyEqualPose(&result, &b, 1e-5f));
+    
+    // A mask of ones is no mask, a mask of zeros keeps a
+    f32 ones[7] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+    f32 zeros[7] = {0};
+    PoseBlend(&a, &b, 0.4f, NULL, &expected);
+    PoseBlend(&a, &b, 0.4f, ones, &result);
+    TEST_BOOL(NearlyEqualPose(&result, &expected, 1e-6f));
+    PoseBlend(&a, &b, 0.4f, zeros, &result);
+    TEST_BOOL(NearlyEqualPose(&result, &a, 1e-6f));
+    
+    // A difference with the rest pose added at full weight onto the rest pose gives the pose back
+    Pose additive = CreateTestPose(joint_count);
+    AnimationEvaluate(&clips[1], NULL, &additive, time);
+    PoseMakeAdditive(&additive, rest_pose);
+    PoseSetRest(&result, rest_pose);
+    PoseAdd(&result, &additive, 1.0f, NULL);
+    TEST_BOOL(NearlyEqualPose(&result, &b, 1e-4f));
+    PoseSetRest(&expected, rest_pose);
+    PoseSetRest(&result, rest_pose);
+    PoseAdd(&result, &additive, 0.0f, NULL);
+    TEST_BOOL(NearlyEqualPose(&result, &expected, 1e-6f));
+    
+    // Layers : the weight 0 additive is skipped, the crossfade matches PoseBlend and the scratch pose is popped
+    sArena scratch = sArenaCreate(Kilobytes(4));
+    AnimationLayer layers[3] = {
+        {&clips[0], NULL, time, 1.0f, ANIMATION_BLEND_OVERRIDE, NULL},
+        {&clips[1], NULL, time, 0.3f, ANIMATION_BLEND_OVERRIDE, NULL},
+        {&clips[1], NULL, time, 0.0f, ANIMATION_BLEND_ADDITIVE, NULL},
+    };
+    PoseBlend(&a, &b, 0.3f, NULL, &expected);
+    AnimationEvaluateLayers(layers, 3, rest_pose, &scratch, &result);
+    TEST_BOOL(NearlyEqualPose(&result, &expected, 1e-6f));
+    TEST_BOOL(scratch.used == 0);
+    
+    // A full override hides the layers under it, nothing is blended
+    layers[1].weight = 1.0f;
+    AnimationEvaluateLayers(layers, 2, rest_pose, &scratch, &result);
+    TEST_BOOL(NearlyEqualPose(&result, &b, 0.0f));
+    
+    sArenaDestroy(&scratch);
+    DestroyTestPose(&a);
+    DestroyTestPose(&b);
+    DestroyTestPose(&expected);
+    DestroyTestPose(&result);
+    DestroyTestPose(&additive);
+    DestroyAnimation(&clips[0]);
+    DestroyAnimation(&clips[1]);
+    sLog("");
+}
+
+void BenchAnimationSampler() {
+    sLog("BENCH ANIMATION SAMPLER");
+    
+    // 500 instances of a 10s clip at 30 keys per second, played for 2s at 60 fps
+    const u32 instance_count = 500;
+    const u32 joint_count = 20;
+    const u32 frames = 120;
+    const f32 delta_time = 1.0f / 60.0f;
+    Animation irregular;
+    CreateTestAnimation(&irregular, joint_count, 10.0f, 30.0f, 0.3f);
+    Animation resampled;
+    CreateTestAnimation(&resampled, joint_count, 10.0f, 30.0f, 0.3f);
+    AnimationResample(&resampled, 30.0f);
+    Animation compressed;
+    CreateTestAnimation(&compressed, joint_count, 10.0f, 30.0f, 0.0f);
+    AnimationCompress(&compressed);
+    
+    Pose pose = CreateTestPose(joint_count);
+    f32 *start_times = sCalloc(instance_count, sizeof(f32));
+    AnimationSampler *samplers = sCalloc(instance_count, sizeof(AnimationSampler));
+    for(u32 i = 0; i < instance_count; i++) {
+        start_times[i] = RandomRange(0.0f, irregular.length);
+        AnimationSamplerInit(&samplers[i], &irregular);
+    }
+    
+    sBeginTimer("AnimationEvaluate binary search x500 x120");
+    for(u32 frame = 0; frame < frames; frame++) {
+        for(u32 i = 0; i < instance_count; i++) {
+            AnimationEvaluate(&irregular, NULL, &pose, AnimationWrapTime(start_times[i] + frame * delta_time, irregular.length));
+        }
+    }
+    sEndTimer("AnimationEvaluate binary search x500 x120");
+    f32 sink = pose.translations[0].x;
+    
+    sBeginTimer("AnimationEvaluate sampler x500 x120");
+    for(u32 frame = 0; frame < frames; frame++) {
+        for(u32 i = 0; i < instance_count; i++) {
+            AnimationEvaluate(&irregular, &samplers[i], &pose, AnimationWrapTime(start_times[i] + frame * delta_time, irregular.length));
+        }
+    }
+    sEndTimer("AnimationEvaluate sampler x500 x120");
+    sink += pose.translations[0].x;
+    
+    sBeginTimer("AnimationEvaluate resampled x500 x120");
+    for(u32 frame = 0; frame < frames; frame++) {
+        for(u32 i = 0; i < instance_count; i++) {
+            AnimationEvaluate(&resampled, NULL, &pose, AnimationWrapTime(start_times[i] + frame * delta_time, resampled.length));
+        }
+    }
+    sEndTimer("AnimationEvaluate resampled x500 x120");
+    sink += pose.translations[0].x;
+    
+    sBeginTimer("AnimationEvaluate compressed x500 x120");
+    for(u32 frame = 0; frame < frames; frame++) {
+        for(u32 i = 0; i < instance_count; i++) {
+            AnimationEvaluate(&compressed, &samplers[i], &pose, AnimationWrapTime(start_times[i] + frame * delta_time, compressed.length));
+        }
+    }
+    sEndTimer("AnimationEvaluate compressed x500 x120");
+    sink += pose.translations[0].x;
+    sLog("Key bytes : %llu resampled, %llu compressed", AnimationKeyBytes(&resampled), AnimationKeyBytes(&compressed));
+    
+    sLog("Checksum %f", sink);
+    for(u32 i = 0; i < instance_count; i++) {
+        AnimationSamplerDestroy(&samplers[i]);
+    }
+    sFree(samplers);
+    sFree(start_times);
+    DestroyTestPose(&pose);
+    DestroyAnimation(&irregular);
+    DestroyAnimation(&resampled);
+    DestroyAnimation(&compressed);
+    sLog("");
+}
+
+void BenchAffineInverse() {
+    sLog("BENCH AFFINE INVERSE");
+    
+    // 256 rounds of 4096 is 1M inverses, the totals in ms read as ns/op
+    const u32 count = 4096;
+    const u32 rounds = 256;
+    Transform *xforms = sCalloc(count, sizeof(Transform));
+    Mat4 *mats = sCalloc(count, sizeof(Mat4));
+    Mat4 *results = sCalloc(count, sizeof(Mat4));
+    for(u32 i = 0; i < count; i++) {
+        RandomTransform(&xforms[i]);
+        transform_to_mat4(&xforms[i], &mats[i]);
+    }
+    
+    f32 sink = 0.0f;
+    sBeginTimer("mat4_inverse x1M (ns/op)");
+    for(u32 round = 0; round < rounds; round++) {
+        for(u32 i = 0; i < count; i++) {
+            mat4_inverse(mats[i], results[i]);
+        }
+        sink += results[round][0];
+    }
+    sEndTimer("mat4_inverse x1M (ns/op)");
+    
+    sBeginTimer("mat4_inverse_affine x1M (ns/op)");
+    for(u32 round = 0; round < rounds; round++) {
+        for(u32 i = 0; i < count; i++) {
+            mat4_inverse_affine(mats[i], results[i]);
+        }
+        sink += results[round][0];
+    }
+    sEndTimer("mat4_inverse_affine x1M (ns/op)");
+    
+    sBeginTimer("transform_inverse_to_mat4 x1M (ns/op)");
+    for(u32 round = 0; round < rounds; round++) {
+        for(u32 i = 0; i < count; i++) {
+            transform_inverse_to_mat4(&xforms[i], results[i]);
+        }
+        sink += results[round][0];
+    }
+    sEndTimer("transform_inverse_to_mat4 x1M (ns/op)");
+    
+    sLog("Checksum %f", sink);
+    sFree(xforms);
+    sFree(mats);
+    sFree(results);
+    sLog("");
+}
+
+void BenchTRSBatch() {
+    sLog("BENCH TRS BATCH (%s)", SMATH_SIMD_NAME);
+    
+    // Sized like a frame's worth of entries, so it stays in cache : 256 rounds of 4096 is 1M conversions
+    const u32 count = 4096;
+    const u32 rounds = 256;
+    Transform *xforms = sCalloc(count, sizeof(Transform));
+    Mat4 *mats = sCalloc(count, sizeof(Mat4));
+    for(u32 i = 0; i < count; i++) {
+        RandomTransform(&xforms[i]);
+    }
+    
+    f32 sink = 0.0f;
+    sBeginTimer("transform_to_mat4 x1M (ns/op)");
+    for(u32 round = 0; round < rounds; round++) {
+        for(u32 i = 0; i < count; i++) {
+            transform_to_mat4(&xforms[i], &mats[i]);
+        }
+        sink += mats[round][0];
+    }
+    sEndTimer("transform_to_mat4 x1M (ns/op)");
+    
+    sBeginTimer("transforms_to_mat4_batch x1M (ns/op)");
+    for(u32 round = 0; round < rounds; round++) {
+        transforms_to_mat4_batch(xforms, count, mats);
+        sink += mats[round][0];
+    }
+    sEndTimer("transforms_to_mat4_batch x1M (ns/op)");
+    
+    sLog("Checksum %f", sink);
+    sFree(xforms);
+    sFree(mats);
+    sLog("");
+}
+
+// Each timer runs 1M operations, so the total in ms reads as ns/op
+void BenchMatSIMD() {
+    sLog("BENCH MAT SIMD (%s)", SMATH_SIMD_NAME);
+    
+    const u32 mat_count = 1024;
+    const u32 rounds = 1024;
+    Mat4 *mats = sCalloc(mat_count, sizeof(Mat4));
+    Mat4 *results = sCalloc(mat_count, sizeof(Mat4));
+    for(u32 i = 0; i < mat_count; i++) {
+        RandomMat4(mats[i]);
+    }
+    
+    f32 sink = 0.0f;
+    sBeginTimer("mat4_mul_scalar (ns/op)");
+    for(u32 r = 0; r < rounds; r++) {
+        for(u32 i = 0; i < mat_count; i++) {
+            mat4_mul_scalar(mats[i], mats[(i + r) & (mat_count - 1)], results[i]);
+        }
+        sink += results[r & (mat_count - 1)][0];
+    }
+    sEndTimer("mat4_mul_scalar (ns/op)");
+    
+    sBeginTimer("mat4_mul (ns/op)");
+    for(u32 r = 0; r < rounds; r++) {
+        for(u32 i = 0; i < mat_count; i++) {
+            mat4_mul(mats[i], mats[(i + r) & (mat_count - 1)], results[i]);
+        }
+        sink += results[r & (mat_count - 1)][0];
+    }
+    sEndTimer("mat4_mul (ns/op)");
+    
+    Vec4 v4 = {1.0f, 2.0f, 3.0f, 1.0f};
+    sBeginTimer("mat4_mul_vec4_scalar (ns/op)");
+    for(u32 r = 0; r < rounds; r++) {
+        for(u32 i = 0; i < mat_count; i++) {
+            Vec4 v = mat4_mul_vec4_scalar(mats[i], v4);
+            sink += v.x;
+        }
+    }
+    sEndTimer("mat4_mul_vec4_scalar (ns/op)");
+    
+    sBeginTimer("mat4_mul_vec4 (ns/op)");
+    for(u32 r = 0; r < rounds; r++) {
+        for(u32 i = 0; i < mat_count; i++) {
+            Vec4 v = mat4_mul_vec4(mats[i], v4);
+            sink += v.x;
+        }
+    }
+    sEndTimer("mat4_mul_vec4 (ns/op)");
+    
+    Vec3 v3 = {1.0f, 2.0f, 3.0f};
+    sBeginTimer("mat4_mul_vec3_scalar (ns/op)");
+    for(u32 r = 0; r < rounds; r++) {
+        for(u32 i = 0; i < mat_count; i++) {
+            Vec3 v = mat4_mul_vec3_scalar(mats[i], v3);
+            sink += v.x;
+        }
+    }
+    sEndTimer("mat4_mul_vec3_scalar (ns/op)");
+    
+    sBeginTimer("mat4_mul_vec3 (ns/op)");
+    for(u32 r = 0; r < rounds; r++) {
+        for(u32 i = 0; i < mat_count; i++) {
+            Vec3 v = mat4_mul_vec3(mats[i], v3);
+            sink += v.x;
+        }
+    }
+    sEndTimer("mat4_mul_vec3 (ns/op)");
+    
+    sLog("Checksum %f", sink);
+    sFree(mats);
+    sFree(results);
+    sLog("");
+}
+
+void TestAnimationJobSplit() {
+    sLog("ANIMATION JOB SPLIT");
+    const u32 max_count = 1000;
+    AnimationInstance *instances = sCalloc(max_count, sizeof(AnimationInstance));
+    u32 *evaluated = sCalloc(max_count, sizeof(u32));
+    const u32 counts[] = {0, 1, 7, 64, 100, 999, 1000};
+    // 0 and counts above ANIMATION_MAX_JOBS are clamped
+    const u32 job_counts[] = {0, 1, 3, 8, 63, 64, 65, 2000};
+    
+    bool once_ok = true;
+    bool sizes_ok = true;
+    bool job_count_ok = true;
+    for(u32 c = 0; c < ARRAY_SIZE(counts); c++) {
+        for(u32 j = 0; j < ARRAY_SIZE(job_counts); j++) {
+            const u32 count = counts[c];
+            const u32 job_count = job_counts[j];
+            AnimationJob jobs[ANIMATION_MAX_JOBS];
+            const u32 used = AnimationSplitJobs(instances, count, job_count, jobs);
+            
+            u32 expected = MIN(job_count, ANIMATION_MAX_JOBS);
+            expected = MIN(expected, count);
+            if(expected == 0 && count > 0) {
+                expected = 1;
+            }
+            job_count_ok &= used == expected;
+            
+            memset(evaluated, 0, max_count * sizeof(u32));
+            for(u32 k = 0; k < used; k++) {
+                sizes_ok &= jobs[k].count > 0;
+                sizes_ok &= jobs[k].count - jobs[used - 1].count <= 1;
+                for(u32 i = 0; i < jobs[k].count; i++) {
+                    evaluated[jobs[k].instances + i - instances]++;
+                }
+            }
+            for(u32 i = 0; i < max_count; i++) {
+                once_ok &= evaluated[i] == (i < count ? 1 : 0);
+            }
+        }
+    }
+    TEST_BOOL(job_count_ok);
+    TEST_BOOL(once_ok);
+    TEST_BOOL(sizes_ok);
+    
+    sFree(instances);
+    sFree(evaluated);
+    sLog("");
+}
+
+// Row frame of the baked texels holds the first 3 rows of each joint matrix of palette
+internal bool BakedRowMatches(const f32 *texels, const u32 frame, const Mat4 *palette, const u32 joint_count, const f32 tolerance) {
+    const f32 *row = texels + frame * joint_count * 12;
+    for(u32 j = 0; j < joint_count; j++) {
+        for(u32 r = 0; r < 3; r++) {
+            for(u32 c = 0; c < 4; c++) {
+                if(fabsf(row[j * 12 + r * 4 + c] - palette[j][c * 4 + r]) > tolerance) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void TestAnimationBake() {
+    sLog("ANIMATION BAKE");
+    const u32 joint_count = 4;
+    const u32 frame_count = 16;
+    sArena scratch = sArenaCreate(Kilobytes(16));
+    
+    // A chain with a branch, rest at identity and bind matrices that move the joints
+    i32 parents[] = {-1, 0, 1, 1};
+    Transform rest[4];
+    Mat4 inverse_binds[4];
+    for(u32 j = 0; j < joint_count; j++) {
+        rest[j] = (Transform){.translation = {0.0f, 0.0f, 0.0f}, .rotation = quat_identity(), .scale = {1.0f, 1.0f, 1.0f}};
+        mat4_identity(inverse_binds[j]);
+        inverse_binds[j][13] = -(f32)j;
+    }
+    SkinnedMesh skin = {.joint_count = joint_count, .joint_xforms = rest, .joint_parents = parents, .inverse_bind_matrices = inverse_binds};
+    
+    // A looping clip, the last keys are the first ones
+    srand(23);
+    Animation animation;
+    CreateTestAnimation(&animation, joint_count, 2.0f, 10.0f, 0.0f);
+    for(u32 t = 0; t < animation.track_count; t++) {
+        AnimationTrack *track = &animation.tracks[t];
+        if(track->type == ANIM_TYPE_QUATERNION) {
+            ((Quat *)track->keys)[track->key_count - 1] = ((Quat *)track->keys)[0];
+        } else {
+            ((Vec3 *)track->keys)[track->key_count - 1] = ((Vec3 *)track->keys)[0];
+        }
+    }
+    
+    f32 *texels = sCalloc(frame_count * joint_count * 12, sizeof(f32));
+    AnimationBakePalettes(&skin, &animation, frame_count, &scratch, texels);
+    
+    Pose pose = PosePush(&scratch, joint_count);
+    pose.global_mats = sArenaPushAligned(&scratch, joint_count * sizeof(Mat4), 16);
+    pose.palette = sArenaPushAligned(&scratch, joint_count * sizeof(Mat4), 16);
+    
+    // Each row is the palette of SkinUpdatePalette at the time of its frame
+    bool rows_ok = true;
+    for(u32 f = 0; f < frame_count; f++) {
+        PoseSetRest(&pose, rest);
+        AnimationEvaluate(&animation, NULL, &pose, animation.length * f / frame_count);
+        SkinUpdatePalette(&skin, &pose);
+        rows_ok &= BakedRowMatches(texels, f, pose.palette, joint_count, 1e-5f);
+    }
+    TEST_BOOL(rows_ok);
+    
+    // The shader blends the last frame into frame 0, so the end of the clip must be frame 0 and not a row of its own
+    PoseSetRest(&pose, rest);
+    AnimationEvaluate(&animation, NULL, &pose, animation.length);
+    SkinUpdatePalette(&skin, &pose);
+    TEST_BOOL(BakedRowMatches(texels, 0, pose.palette, joint_count, 1e-5f));
+    TEST_BOOL(!BakedRowMatches(texels, frame_count - 1, pose.palette, joint_count, 1e-5f));
+    
+    sFree(texels);
+    DestroyAnimation(&animation);
+    sArenaDestroy(&scratch);
+    sLog("");
+}
+
+void TestSkinJointOrder() {
+    sLog("SKIN JOINT ORDER");
+    sArena arena = sArenaCreate(Kilobytes(4));
+    
+    // Node 0 is the armature, node 6 a mesh under a joint. The joints are listed out of order.
+    u32 children_0[] = {3};
+    u32 children_1[] = {5};
+    u32 children_2[] = {6};
+    u32 children_3[] = {1, 4};
+    u32 children_4[] = {2};
+    GLTFNode nodes[7] = {0};
+    nodes[0] = (GLTFNode){.child_count = 1, .children = children_0};
+    nodes[1] = (GLTFNode){.child_count = 1, .children = children_1};
+    nodes[2] = (GLTFNode){.child_count = 1, .children = children_2};
+    nodes[3] = (GLTFNode){.child_count = 2, .children = children_3};
+    nodes[4] = (GLTFNode){.child_count = 1, .children = children_4};
+    u32 joints[] = {5, 1, 3, 2, 4};
+    GLTFSkin skin = {.joint_count = ARRAY_SIZE(joints), .joints = joints};
+    GLTF gltf = {.node_count = ARRAY_SIZE(nodes), .nodes = nodes, .skin_count = 1, .skins = &skin};
+    
+    GLTFSortSkinJoints(&gltf, &skin, &arena);
+    // Depth first from node 3 : 3, 1, 5, 4, 2
+    u32 expected[] = {2, 1, 0, 4, 3};
+    bool order_ok = true;
+    for(u32 i = 0; i < ARRAY_SIZE(expected); i++) {
+        order_ok &= skin.joint_order[i] == expected[i] && skin.joint_remap[expected[i]] == i;
+    }
+    TEST_BOOL(order_ok);
+    
+    // Every parent is before its children
+    bool parents_ok = true;
+    for(u32 j = 0; j < skin.joint_count; j++) {
+        const GLTFNode *node = &nodes[joints[j]];
+        for(u32 c = 0; c < node->child_count; c++) {
+            if(node->children[c] != 6)
+                parents_ok &= GLTFGetBoneIDFromNode(&gltf, joints[j]) < GLTFGetBoneIDFromNode(&gltf, node->children[c]);
+        }
+    }
+    TEST_BOOL(parents_ok);
+    TEST_BOOL(GLTFGetBoneIDFromNode(&gltf, 4) == 3);
+    
+    sArenaDestroy(&arena);
+    sLog("");
+}
+
+void TestArena() {
+    sLog("ARENA");
+    
+    sArena block = sArenaCreate(Kilobytes(4));
+    sArena permanent = sArenaCarve(&block, Kilobytes(1));
+    sArena frame = sArenaCarve(&block, Kilobytes(1));
+    TEST_BOOL(permanent.base >= block.base && permanent.base + permanent.size <= frame.base);
+    TEST_BOOL(frame.base + frame.size <= block.base + block.size);
+    
+    u32 *kept = sArenaPushArray(&frame, 4, u32);
+    kept[0] = 42;
+    u64 mark = sArenaGetMark(&frame);
+    u32 *temp = sArenaPushArray(&frame, 16, u32);
+    temp[0] = 1;
+    sArenaPopToMark(&frame, mark);
+    TEST_EQUALS((u32)frame.used, (u32)mark, "%u");
+    
+    // Pushes are zeroed even when the memory is reused
+    u32 *reused = sArenaPushArray(&frame, 16, u32);
+    TEST_BOOL(reused == temp);
+    TEST_EQUALS(reused[0], 0, "%u");
+    TEST_EQUALS(kept[0], 42, "%u");
+    
+    // frame.used is 80, the next push aligned on 64 starts at 128
+    TEST_EQUALS((u32)sArenaGetRemaining(&frame, 4), Kilobytes(1) - 80, "%u");
+    TEST_EQUALS((u32)sArenaGetRemaining(&frame, 64), Kilobytes(1) - 128, "%u");
+    sArenaPushArray(&frame, Kilobytes(1) - 80, u8);
+    TEST_EQUALS((u32)sArenaGetRemaining(&frame, 64), 0, "%u");
+    
+    sArenaDestroy(&block);
+    sLog("");
+}
+
+void TestPool() {
+    sLog("POOL");
+    
+    sPool pool = sPoolCreate(4, sizeof(u64));
+    sPoolHandle handles[100];
+    for(u32 i = 0; i < 100; i++) {
+        handles[i] = sPoolAdd(&pool);
+        *(u64 *)sPoolGet(&pool, handles[i]) = i;
+    }
+    TEST_EQUALS(pool.count, 100, "%u");
+    TEST_BOOL(handles[0] != POOL_INVALID_HANDLE);
+    
+    // Elements don't move when the pool grows
+    u64 *first = sPoolGet(&pool, handles[0]);
+    TEST_EQUALS((u32)*first, 0, "%u");
+    TEST_EQUALS((u32)*(u64 *)sPoolGet(&pool, handles[99]), 99, "%u");
+    
+    // Removed slots are reused, old handles become stale
+    sPoolRemove(&pool, handles[42]);
+    TEST_BOOL(sPoolGet(&pool, handles[42]) == NULL);
+    sPoolHandle reused = sPoolAdd(&pool);
+    TEST_EQUALS((reused & POOL_INDEX_MASK), (handles[42] & POOL_INDEX_MASK), "%u");
+    TEST_BOOL(reused != handles[42]);
+    TEST_BOOL(sPoolGet(&pool, handles[42]) == NULL);
+    TEST_EQUALS((u32)*(u64 *)sPoolGet(&pool, reused), 0, "%u");
+    TEST_EQUALS(pool.high_water, 100, "%u");
+    
+    u32 live = 0;
+    for(u32 i = 0; i < pool.high_water; i++) {
+        if(sPoolGetAt(&pool, i)) {
+            live++;
+        }
+    }
+    TEST_EQUALS(live, pool.count, "%u");
+    
+    sPoolDestroy(&pool);
+    sLog("");
+}
+
+void TestPushText() {
+    sLog("PUSHBUFFER TEXT");
+    
+    sArena arena = sArenaCreate(Kilobytes(4));
+    PushBuffer push_buffer = {0};
+    push_buffer.max_size = sizeof(PushBufferEntryText) * 4;
+    push_buffer.buf = sCalloc(push_buffer.max_size, 1);
+    push_buffer.arena = &arena;
+    
+    // Strings aren't capped anymore
+    char long_text[300];
+    memset(long_text, 'a', sizeof(long_text) - 1);
+    long_text[sizeof(long_text) - 1] = '\0';
+    UIPushText(&push_buffer, long_text, 0, 0, (Vec4){1.0f, 1.0f, 1.0f, 1.0f});
+    UIPushFmt(&push_buffer, 0, 0, (Vec4){1.0f, 1.0f, 1.0f, 1.0f}, "%s %d", long_text, 42);
+    
+    PushBufferEntryText *entry = (PushBufferEntryText *)push_buffer.buf;
+    TEST_EQUALS((u32)strlen(entry[0].text), (u32)strlen(long_text), "%u");
+    TEST_EQUALS((u32)strlen(entry[1].text), (u32)strlen(long_text) + 3, "%u");
+    TEST_BOOL((u8 *)entry[0].text >= arena.base && (u8 *)entry[1].text < arena.base + arena.size);
+    
+    sArenaReset(&arena);
+    TEST_EQUALS((u32)arena.used, 0, "%u");
+    
+    sFree(push_buffer.buf);
+    sArenaDestroy(&arena);
+    sLog("");
+}
+
+// Compares the frame arena with the old path of one heap allocation per string
+void BenchPushText() {
+    sLog("BENCH PUSHBUFFER TEXT");
+    
+    const u32 frame_count = 100;
+    const u32 string_count = 10000;
+    const char *text = "> Console history line, pushed every frame";
+    
+    PushBuffer push_buffer = {0};
+    push_buffer.max_size = sizeof(PushBufferEntryText) * string_count;
+    push_buffer.buf = sCalloc(push_buffer.max_size, 1);
+    sArena arena = sArenaCreate(Megabytes(1));
+    push_buffer.arena = &arena;
+    
+    sBeginTimer("Text heap (old)");
+    for(u32 frame = 0; frame < frame_count; frame++) {
+        for(u32 i = 0; i < string_count; i++) {
+            PushBufferEntryText *entry = PushBufferGetEntry(&push_buffer, PushBufferEntryText);
+            entry->type = PushBufferEntryType_Text;
+            entry->text = sCalloc(128, sizeof(char));
+            StringCopyLength(entry->text, text, 128);
+        }
+        // DrawUI used to free every string
+        for(u32 address = 0; address < push_buffer.size; address += sizeof(PushBufferEntryText)) {
+            PushBufferEntryText *entry = (PushBufferEntryText *)(push_buffer.buf + address);
+            sFree(entry->text);
+        }
+        push_buffer.size = 0;
+    }
+    sEndTimer("Text heap (old)");
+    
+    sBeginTimer("Text arena");
+    for(u32 frame = 0; frame < frame_count; frame++) {
+        for(u32 i = 0; i < string_count; i++) {
+            UIPushText(&push_buffer, text, 0, 0, (Vec4){1.0f, 1.0f, 1.0f, 1.0f});
+        }
+        push_buffer.size = 0;
+        sArenaReset(&arena);
+    }
+    sEndTimer("Text arena");
+    
+    sFree(push_buffer.buf);
+    sArenaDestroy(&arena);
+    sLog("");
+}
+
+void TestSegArray() {
+    sLog("SEGMENTED ARRAY");
+    
+    sSegArray array = sSegArrayCreate(4, sizeof(u32));
+    u32 id;
+    u32 *first = sSegArrayAdd(&array, &id);
+    *first = 42;
+    TEST_EQUALS(id, 0, "%u");
+    
+    // Growing past several chunks doesn't move the first element
+    for(u32 i = 1; i < 100; i++) {
+        *(u32 *)sSegArrayAdd(&array, NULL) = i;
+    }
+    TEST_EQUALS(array.count, 100, "%u");
+    TEST_EQUALS(array.chunk_count, 25, "%u");
+    TEST_BOOL(sSegArrayGet(&array, 0) == first);
+    TEST_EQUALS(*first, 42, "%u");
+    TEST_EQUALS(*(u32 *)sSegArrayGet(&array, 57), 57, "%u");
+    
+    u32 start = sSegArrayAddMultiple(&array, 10);
+    TEST_EQUALS(start, 100, "%u");
+    TEST_EQUALS(array.count, 110, "%u");
+    TEST_EQUALS(sSegArrayChunkCount(&array, 27), 2, "%u");
+    TEST_EQUALS(sSegArrayChunkCount(&array, 3), 4, "%u");
+    // Chunks past the last element are empty
+    TEST_EQUALS(sSegArrayChunkCount(&array, 28), 0, "%u");
+    TEST_EQUALS(sSegArrayChunkCount(&array, 1000), 0, "%u");
+    
+    sSegArrayDestroy(&array);
+    sLog("");
+}
+
+void BenchSegArray() {
+    sLog("BENCH SEGMENTED ARRAY");
+    
+    const u32 count = 1 << 20;
+    
+    sBeginTimer("sArray append 1M Transforms");
+    sArray array = sArrayCreate(1, sizeof(Transform));
+    for(u32 i = 0; i < count; i++) {
+        Transform *xform = sArrayGet(array, sArrayAdd(&array));
+        transform_identity(xform);
+    }
+    sEndTimer("sArray append 1M Transforms");
+    
+    sBeginTimer("sSegArray append 1M Transforms");
+    sSegArray seg_array = sSegArrayCreate(1024, sizeof(Transform));
+    for(u32 i = 0; i < count; i++) {
+        transform_identity(sSegArrayAdd(&seg_array, NULL));
+    }
+    sEndTimer("sSegArray append 1M Transforms");
+    
+    f32 sum = 0.0f;
+    sBeginTimer("sArray iterate");
+    for(u32 i = 0; i < array.count; i++) {
+        Transform *xform = sArrayGet(array, i);
+        sum += xform->scale.x;
+    }
+    sEndTimer("sArray iterate");
+    
+    sBeginTimer("sSegArray iterate by id");
+    for(u32 i = 0; i < seg_array.count; i++) {
+        Transform *xform = sSegArrayGet(&seg_array, i);
+        sum += xform->scale.x;
+    }
+    sEndTimer("sSegArray iterate by id");
+    
+    sBeginTimer("sSegArray iterate by chunk");
+    for(u32 chunk = 0; chunk < seg_array.chunk_count; chunk++) {
+        Transform *xforms = (Transform *)seg_array.chunks[chunk];
+        u32 chunk_count = sSegArrayChunkCount(&seg_array, chunk);
+        for(u32 i = 0; i < chunk_count; i++) {
+            sum += xforms[i].scale.x;
+        }
+    }
+    sEndTimer("sSegArray iterate by chunk");
+    TEST_EQUALS((u32)sum, count * 3, "%u");
+    
+    sArrayDestroy(array);
+    sSegArrayDestroy(&seg_array);
+    sLog("");
+}
+
+void TestLeak() {
+    sLog("LEAK TRACKING");
+    
+    const u32 count = 20000;
+    void **ptrs = malloc(count * sizeof(void *));
+    u32 live_before = list->count;
+    
+    sBeginTimer("Leak tracking 20k allocs/frees");
+    for(u32 i = 0; i < count; i++) {
+        ptrs[i] = sMalloc(16);
+    }
+    u32 site = 0;
+    for(u32 i = 0; i < list->slot_count; i++) {
+        if(list->slots[i].ptr == ptrs[0]) {
+            site = list->slots[i].site;
+        }
+    }
+    TEST_EQUALS(list->count, live_before + count, "%u");
+    TEST_EQUALS(list->sites[site].live_count, count, "%u");
+    TEST_EQUALS((u32)list->sites[site].live_bytes, count * 16, "%u");
+    
+    // Free every other allocation first to exercise the backward shift deletion
+    for(u32 i = 0; i < count; i += 2) {
+        sFree(ptrs[i]);
+    }
+    for(u32 i = 1; i < count; i += 2) {
+        sFree(ptrs[i]);
+    }
+    sEndTimer("Leak tracking 20k allocs/frees");
+    
+    TEST_EQUALS(list->count, live_before, "%u");
+    TEST_EQUALS((u32)list->sites[site].live_bytes, 0, "%u");
+    TEST_EQUALS((u32)list->sites[site].peak_bytes, count * 16, "%u");
+    
+    Leak_EndFrame();
+    TEST_EQUALS(list->sites[site].last_frame_allocs, count, "%u");
+    TEST_EQUALS(list->sites[site].frame_allocs, 0, "%u");
+    
+    free(ptrs);
+    sLog("");
+}
+
+void TestMemTags() {
+    sLog("MEMORY TAGS");
+    
+    MemTagCounters *counters = sMemGetTagCounters();
+    i64 render_before = counters->current[MEM_TAG_RENDER];
+    i64 image_before = counters->current[MEM_TAG_IMAGE];
+    
+    void *a = sMallocTagged(100, MEM_TAG_RENDER);
+    void *b = sCallocTagged(10, 8, MEM_TAG_IMAGE);
+    TEST_EQUALS(counters->current[MEM_TAG_RENDER] - render_before, 100, "%lld");
+    TEST_EQUALS(counters->current[MEM_TAG_IMAGE] - image_before, 80, "%lld");
+    
+    // sRealloc keeps the tag, sReallocTagged moves the block to the new one
+    a = sRealloc(a, 300);
+    TEST_EQUALS(counters->current[MEM_TAG_RENDER] - render_before, 300, "%lld");
+    b = sReallocTagged(b, 40, MEM_TAG_RENDER);
+    TEST_EQUALS(counters->current[MEM_TAG_RENDER] - render_before, 340, "%lld");
+    TEST_EQUALS(counters->current[MEM_TAG_IMAGE], image_before, "%lld");
+    
+    sFree(a);
+    sFree(b);
+    TEST_EQUALS(counters->current[MEM_TAG_RENDER], render_before, "%lld");
+    TEST_BOOL(counters->peak[MEM_TAG_RENDER] >= render_before + 340);
+    sLog("");
+}
+
+void TestIntern(sArena *arena) {
+    sLog("INTERN");
+    
+    sInternTable *previous = sInternGetTable();
+    sInternTable *table = sArenaPushArray(arena, 1, sInternTable);
+    *table = sInternCreate(arena, 64, 1024);
+    sInternSetTable(table);
+    
+    sStringID hips = sIntern("mixamorig:Hips");
+    sStringID spine = sIntern("mixamorig:Spine");
+    TEST_BOOL(hips != STRING_ID_NONE);
+    TEST_BOOL(hips != spine);
+    TEST_EQUALS(sIntern("mixamorig:Hips"), hips, "%u");
+    TEST_EQUALS(sInternLength("mixamorig:Spine1", 15), spine, "%u");
+    TEST_EQUALS(strcmp(sInternString(spine), "mixamorig:Spine"), 0, "%d");
+    
+    // Find never adds
+    TEST_EQUALS(sInternFind("mixamorig:Head"), STRING_ID_NONE, "%u");
+    TEST_EQUALS(table->count, 2, "%u");
+    
+    // Fill the table, every string keeps its ID
+    char name[32]; // "joint_" and any u32
+    for(u32 i = table->count; i < table->capacity; i++) {
+        snprintf(name, sizeof(name), "joint_%u", i);
+        sIntern(name);
+    }
+    TEST_EQUALS(sInternFind("joint_63"), 64, "%u");
+    TEST_EQUALS(sIntern("mixamorig:Hips"), hips, "%u");
+    
+    sInternSetTable(previous);
+    sLog("");
+}
+
 int main(const int argc, const char *argv[]) {
     Leak_Begin();
     TEST_BEGIN();
@@ -94,8 +1910,48 @@ int main(const int argc, const char *argv[]) {
 
     //TestHuffman();
     TestMat();
+    TestMatSIMD();
+    TestTRSBatch();
+    TestAffineInverse();
+    TestMathWide4();
+    TestMathWide8();
+    TestMat4Wide();
+    TestSlerpBatch();
+    TestFastMath();
+    TestAnimationSampler();
+    TestAnimationCompression();
+    TestAnimationStorage();
+    TestPoseBlend();
+    TestAnimationJobSplit();
+    TestAnimationBake();
+    TestSkinJointOrder();
 
     TESTCOLLISION();
+    
+    TestArena();
+    TestPool();
+    TestPushText();
+    TestMemTags();
+    TestSegArray();
+    
+    // The perf timers are interned
+    sArena intern_arena = sArenaCreate(Kilobytes(64));
+    sInternTable strings = sInternCreate(&intern_arena, 256, Kilobytes(4));
+    sInternSetTable(&strings);
+    TestIntern(&intern_arena);
+    
+    sInitPerf();
+    TestLeak();
+    BenchPushText();
+    BenchSegArray();
+    BenchMatSIMD();
+    BenchTRSBatch();
+    BenchAffineInverse();
+    BenchSlerpBatch();
+    BenchFastMath();
+    BenchAnimationSampler();
+    sDumpPerf();
+    sArenaDestroy(&intern_arena);
 
     TEST_END();
     Leak_End();
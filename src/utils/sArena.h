@@ -0,0 +1,113 @@
+#pragma once
+// SARENA
+// Linear allocator. Allocations are pushed one after the other into a single block, and everything is released at once with sArenaReset.
+// Use it for data that shares the same lifetime, for example everything that only needs to live for one frame.
+
+#include <string.h>
+
+#include "sTypes.h"
+#include "sLeak.h"
+
+#define ARENA_DEFAULT_ALIGNMENT 8
+
+#define Kilobytes(value) ((u64)(value) * 1024)
+#define Megabytes(value) (Kilobytes(value) * 1024)
+#define Gigabytes(value) (Megabytes(value) * 1024)
+
+typedef struct sArena {
+    u8 *base;  // Start of the block
+    u64 size;  // Total size of the block
+    u64 used;  // Bytes used, the next allocation starts here
+    u64 peak;  // Highest value of used since the creation, to size the arena
+} sArena;
+
+// Creates a new arena and allocates its block
+sArena sArenaCreate(const u64 size) {
+    sArena arena;
+    arena.base = sCalloc(size, 1);
+    arena.size = size;
+    arena.used = 0;
+    arena.peak = 0;
+    return arena;
+}
+
+// Creates an arena on top of an existing block of memory. The arena doesn't own it, don't call sArenaDestroy on it.
+sArena sArenaCreateFromMemory(void *base, const u64 size) {
+    sArena arena;
+    arena.base = (u8 *)base;
+    arena.size = size;
+    arena.used = 0;
+    arena.peak = 0;
+    return arena;
+}
+
+// Frees the block of the arena
+void sArenaDestroy(sArena *arena) {
+    sFree(arena->base);
+    *arena = (sArena){0};
+}
+
+internal void *sArenaAlloc_(sArena *arena, const u64 size, const u64 alignment) {
+    u64 start = (arena->used + alignment - 1) & ~(alignment - 1);
+    if(start + size > arena->size) {
+        ASSERT_MSG(0, "Arena is full");
+        return NULL;
+    }
+    arena->used = start + size;
+    if(arena->used > arena->peak) {
+        arena->peak = arena->used;
+    }
+    return arena->base + start;
+}
+
+// Returns size zeroed bytes aligned on alignment (must be a power of 2). Returns NULL if the arena is full.
+void *sArenaPushAligned(sArena *arena, const u64 size, const u64 alignment) {
+    void *result = sArenaAlloc_(arena, size, alignment);
+    if(result) {
+        memset(result, 0, size);
+    }
+    return result;
+}
+
+void *sArenaPush(sArena *arena, const u64 size) {
+    return sArenaPushAligned(arena, size, ARENA_DEFAULT_ALIGNMENT);
+}
+
+#define sArenaPushArray(arena, count, type) (type *)sArenaPush(arena, (count) * sizeof(type))
+
+// Copies length chars of string into the arena and adds a '\0' at the end
+char *sArenaPushString(sArena *arena, const char *string, const u32 length) {
+    char *result = sArenaAlloc_(arena, length + 1, 1);
+    if(result) {
+        memcpy(result, string, length);
+        result[length] = '\0';
+    }
+    return result;
+}
+
+// Takes size bytes out of parent to make a new arena. The memory goes back to the parent when it is reset or popped.
+sArena sArenaCarve(sArena *parent, const u64 size) {
+    return sArenaCreateFromMemory(sArenaAlloc_(parent, size, 64), size);
+}
+
+// Bytes that a push aligned on alignment can still get, to check for room before a push that may not fit
+u64 sArenaGetRemaining(const sArena *arena, const u64 alignment) {
+    u64 start = (arena->used + alignment - 1) & ~(alignment - 1);
+    return start < arena->size ? arena->size - start : 0;
+}
+
+// Returns the current position of the arena, to be used with sArenaPopToMark
+u64 sArenaGetMark(const sArena *arena) {
+    return arena->used;
+}
+
+// Releases every allocation made after mark was taken
+void sArenaPopToMark(sArena *arena, const u64 mark) {
+    ASSERT(mark <= arena->used);
+    arena->used = mark;
+}
+
+// Releases every allocation at once
+void sArenaReset(sArena *arena) {
+    arena->used = 0;
+}
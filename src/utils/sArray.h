@@ -65,4 +65,101 @@ u32 sArrayAddMultiple(sArray *array, const u32 nb) {
     array->count = new_count;
     return result;
     
-}
\ No newline at end of file
+}
+
+// SSEGARRAY
+// Dynamically sized array that grows by adding fixed size chunks instead of reallocating.
+// Elements never move, so pointers to them stay valid until the array is destroyed.
+// A chunk directory gives O(1) access : element id is in chunk id >> chunk_shift, at id & (chunk_capacity - 1).
+// Elements are only contiguous inside a chunk, iterate chunk by chunk to walk them linearly.
+
+typedef struct sSegArray {
+    u8 **chunks;             // Chunk directory, only this is reallocated when the array grows
+    u32 chunk_count;         // Allocated chunks
+    u32 directory_capacity;  // Size of the chunk directory
+    u32 chunk_shift;         // log2 of the elements in a chunk
+    u32 count;               // Number of elements in the array
+    u32 size;                // Size of each element
+} sSegArray;
+
+// Returned by sSegArrayAddMultiple when the array can't grow
+#define SSEGARRAY_INVALID_ID ((u32)-1)
+
+// Creates a new segmented array. chunk_capacity must be a power of 2. No memory is allocated until the first add.
+sSegArray sSegArrayCreate(const u32 chunk_capacity, const u32 element_size) {
+    ASSERT_MSG((chunk_capacity & (chunk_capacity - 1)) == 0, "Segmented array chunk capacity must be a power of 2");
+    sSegArray array = {0};
+    array.size = element_size;
+    while((1u << array.chunk_shift) < chunk_capacity) {
+        array.chunk_shift++;
+    }
+    return array;
+}
+
+void sSegArrayDestroy(sSegArray *array) {
+    for(u32 i = 0; i < array->chunk_count; i++) {
+        sFree(array->chunks[i]);
+    }
+    sFree(array->chunks);
+    *array = (sSegArray){0};
+}
+
+// Returns a pointer to element id in the array
+inline void *sSegArrayGet(const sSegArray *array, const u32 id) {
+    return array->chunks[id >> array->chunk_shift] + (id & ((1u << array->chunk_shift) - 1)) * array->size;
+}
+
+// Returns the number of elements stored in chunk, 0 for the chunks past the last element
+inline u32 sSegArrayChunkCount(const sSegArray *array, const u32 chunk) {
+    u32 first = chunk << array->chunk_shift;
+    u32 chunk_capacity = 1u << array->chunk_shift;
+    if(chunk >= array->chunk_count || first >= array->count) {
+        return 0;
+    }
+    return array->count - first < chunk_capacity ? array->count - first : chunk_capacity;
+}
+
+internal bool sSegArrayAddChunk_(sSegArray *array) {
+    if(array->chunk_count == array->directory_capacity) {
+        u32 new_capacity = array->directory_capacity ? array->directory_capacity * 2 : 8;
+        u8 **chunks = sRealloc(array->chunks, new_capacity * sizeof(u8 *));
+        ASSERT(chunks);
+        if(!chunks) {
+            return false;
+        }
+        array->chunks = chunks;
+        array->directory_capacity = new_capacity;
+    }
+    u8 *chunk = sMalloc((1u << array->chunk_shift) * array->size);
+    ASSERT(chunk);
+    if(!chunk) {
+        return false;
+    }
+    array->chunks[array->chunk_count++] = chunk;
+    return true;
+}
+
+// Adds a new element to the array and returns a pointer to it. If id isn't NULL, it is set to the id of the element.
+void *sSegArrayAdd(sSegArray *array, u32 *id) {
+    if(array->count == array->chunk_count << array->chunk_shift && !sSegArrayAddChunk_(array)) {
+        return NULL;
+    }
+    if(id) {
+        *id = array->count;
+    }
+    return sSegArrayGet(array, array->count++);
+}
+
+// Adds multiple new elements to the array. Returns the id of the first one, or SSEGARRAY_INVALID_ID if the array
+// couldn't grow, in which case nothing is added. The new elements may span several chunks, access them with sSegArrayGet.
+u32 sSegArrayAddMultiple(sSegArray *array, const u32 nb) {
+    u32 new_count = array->count + nb;
+    while(array->chunk_count << array->chunk_shift < new_count) {
+        if(!sSegArrayAddChunk_(array)) {
+            return SSEGARRAY_INVALID_ID;
+        }
+    }
+    u32 result = array->count;
+    array->count = new_count;
+    return result;
+}
@@ -0,0 +1,358 @@
+#pragma once
+// SFASTMATH
+// Approximations of sin, cos, atan2, acos and 1 / sqrt for gameplay and camera code, where a few ULP don't matter
+// but libm's one call per value does. The polynomials are the minimax fits of Cephes' float functions.
+// Every function has a wide version on f32x4 and f32x8 with the same math.
+// The maximum errors below are measured by TestFastMath against libm in double.
+//
+// fast_sin, fast_cos, fast_sincos : 2 ULP on [-pi/4, pi/4] and wherever the result is above 0.5. Elsewhere the error is
+//                                   under 1e-7 for |x| <= 8192, many ULP close to the zeros. Past 8192 the range reduction
+//                                   loses precision.
+// fast_atan2                      : 4 ULP
+// fast_acos                       : 2 ULP
+// fast_rsqrt                      : 4 ULP with SSE (hardware estimate and one Newton step), 2 ULP without
+//
+// The scalar sin and cos aren't faster than libm's sinf and cosf, keep those for one value at a time. The gain is in the
+// wide versions. The scalar atan2, acos and rsqrt do beat libm.
+
+#include "sTypes.h"
+#include "sMath.h"
+#include "sMathWide.h"
+
+// pi / 2 in 3 parts for the Cody-Waite reduction : q * FAST_PIO2_1 is exact for the q we get with |x| <= 8192
+#define FAST_PIO2_1 1.5703125f
+#define FAST_PIO2_2 4.837512969970703125e-4f
+#define FAST_PIO2_3 7.54978995489188216e-8f
+#define FAST_2_OVER_PI 0.636619772367581343f
+#define FAST_PI_OVER_2 1.57079632679489661923f
+#define FAST_PI_OVER_4 0.785398163397448309616f
+#define FAST_TAN_PI_OVER_8 0.414213562373095048802f
+#define FAST_ROUND_MAGIC 12582912.0f // 1.5 * 2^23, adding and removing it rounds to an integer
+#define FAST_MIN_NORMAL 1.17549435e-38f // Smallest normal float, rsqrt estimates of anything below are inf
+
+// --------
+// DECLARATIONS
+
+void fast_sincos(const f32 x, f32 *s, f32 *c);
+f32 fast_sin(const f32 x);
+f32 fast_cos(const f32 x);
+f32 fast_atan2(const f32 y, const f32 x);
+f32 fast_acos(const f32 x);
+f32 fast_rsqrt(const f32 x);
+
+Vec3 fast_vec3_normalize(const Vec3 v);
+Vec3 fast_spherical_to_carthesian(const Vec2f v);
+Quat fast_quat_from_axis(const Vec3 axis, const f32 angle);
+Quat fast_quat_lookat(const Vec3 pos, const Vec3 dest, const Vec3 up);
+
+// --------
+// SCALAR
+
+// sin(r) and cos(r) for r in [-pi/4, pi/4], z is r * r
+internal inline f32 fast_sin_poly_(const f32 r, const f32 z) {
+    return r + r * z * (-1.6666654611e-1f + z * (8.3321608736e-3f + z * -1.9515295891e-4f));
+}
+
+internal inline f32 fast_cos_poly_(const f32 z) {
+    return 1.0f - 0.5f * z + z * z * (4.166664568298827e-2f + z * (-1.388731625493765e-3f + z * 2.443315711809948e-5f));
+}
+
+// atan(t) for t in [0, 1]
+internal inline f32 fast_atan_poly_(f32 t) {
+    f32 base = 0.0f;
+    if(t > FAST_TAN_PI_OVER_8) {
+        base = FAST_PI_OVER_4;
+        t = (t - 1.0f) / (t + 1.0f);
+    }
+    f32 z = t * t;
+    return base + (((8.05374449538e-2f * z - 1.38776856032e-1f) * z + 1.99777106478e-1f) * z - 3.33329491539e-1f) * z * t + t;
+}
+
+// asin(x) for |x| <= 0.5
+internal inline f32 fast_asin_poly_(const f32 x) {
+    f32 z = x * x;
+    return ((((4.2163199048e-2f * z + 2.4181311049e-2f) * z + 4.5470025998e-2f) * z + 7.4953002686e-2f) * z + 1.6666752422e-1f) * z * x + x;
+}
+
+void fast_sincos(const f32 x, f32 *s, f32 *c) {
+    // x = q * pi / 2 + r, then the quadrant q picks sin or cos of r and its sign
+    f32 q = (x * FAST_2_OVER_PI + FAST_ROUND_MAGIC) - FAST_ROUND_MAGIC;
+    f32 r = ((x - q * FAST_PIO2_1) - q * FAST_PIO2_2) - q * FAST_PIO2_3;
+    f32 z = r * r;
+    f32 sin_r = fast_sin_poly_(r, z);
+    f32 cos_r = fast_cos_poly_(z);
+    // Written without branches, the quadrant of random inputs mispredicts
+    i32 quadrant = (i32)q;
+    f32 sin_x = (quadrant & 1) ? cos_r : sin_r;
+    f32 cos_x = (quadrant & 1) ? sin_r : cos_r;
+    *s = (quadrant & 2) ? -sin_x : sin_x;
+    *c = ((quadrant + 1) & 2) ? -cos_x : cos_x;
+}
+
+f32 fast_sin(const f32 x) {
+    f32 s, c;
+    fast_sincos(x, &s, &c);
+    return s;
+}
+
+f32 fast_cos(const f32 x) {
+    f32 s, c;
+    fast_sincos(x, &s, &c);
+    return c;
+}
+
+f32 fast_atan2(const f32 y, const f32 x) {
+    f32 ax = fabsf(x);
+    f32 ay = fabsf(y);
+    if(ax == 0.0f && ay == 0.0f) {
+        return 0.0f;
+    }
+    // Divide by the biggest to stay in [0, 1]
+    f32 result = ay > ax ? FAST_PI_OVER_2 - fast_atan_poly_(ax / ay) : fast_atan_poly_(ay / ax);
+    if(x < 0.0f) {
+        result = PI - result;
+    }
+    return y < 0.0f ? -result : result;
+}
+
+f32 fast_acos(const f32 x) {
+    f32 a = fabsf(x);
+    if(a > 0.5f) {
+        // acos(a) = 2 * asin(sqrt((1 - a) / 2))
+        f32 result = 2.0f * fast_asin_poly_(sqrtf(0.5f * (1.0f - a)));
+        return x < 0.0f ? PI - result : result;
+    }
+    return FAST_PI_OVER_2 - fast_asin_poly_(x);
+}
+
+f32 fast_rsqrt(const f32 x) {
+#if defined(SMATH_SSE2)
+    f32 y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+#else
+    // Integer estimate, 3.5% off, and two Newton steps
+    union { f32 f; u32 u; } bits = {x};
+    bits.u = 0x5f375a86 - (bits.u >> 1);
+    f32 y = bits.f;
+    y = y * (1.5f - 0.5f * x * y * y);
+    y = y * (1.5f - 0.5f * x * y * y);
+#endif
+    // Last Newton step, written as a correction of y so it rounds better
+    return y + y * (0.5f - 0.5f * x * y * y);
+}
+
+// A zero vector stays zero instead of becoming NaN
+Vec3 fast_vec3_normalize(const Vec3 v) {
+    f32 length_sq = vec3_dot(v, v);
+    if(length_sq < FAST_MIN_NORMAL) {
+        return (Vec3){0.0f, 0.0f, 0.0f};
+    }
+    return vec3_fmul(v, fast_rsqrt(length_sq));
+}
+
+// Same as spherical_to_carthesian
+Vec3 fast_spherical_to_carthesian(const Vec2f v) {
+    f32 sin_x, cos_x, sin_y, cos_y;
+    fast_sincos(v.x - (PI / 2.0f), &sin_x, &cos_x);
+    fast_sincos(v.y + (PI / 2.0f), &sin_y, &cos_y);
+    return (Vec3){cos_x * sin_y, cos_y, sin_x * sin_y};
+}
+
+// Same as quat_from_axis
+Quat fast_quat_from_axis(const Vec3 axis, const f32 angle) {
+    f32 sine, cosine;
+    fast_sincos(angle / 2.0f, &sine, &cosine);
+    return quat(axis.x * sine, axis.y * sine, axis.z * sine, cosine);
+}
+
+// Same as quat_lookat. The rotation from forward to look is built from their half vector, so there is no acos :
+// (forward x look, 1 + forward . look) normalized, with forward = +Z.
+// Looking straight back has no half vector, it turns by pi around up (a unit vector). The half vector's squared length
+// is about the squared angle to straight back, so that's within 1e-3 radians : look is only normalized to a few ULP.
+Quat fast_quat_lookat(const Vec3 pos, const Vec3 dest, const Vec3 up) {
+    Vec3 look = fast_vec3_normalize(vec3_sub(dest, pos));
+    Quat q = quat(-look.y, look.x, 0.0f, 1.0f + look.z);
+    f32 length_sq = q.x * q.x + q.y * q.y + q.w * q.w;
+    if(length_sq < 1e-6f) {
+        return quat(up.x, up.y, up.z, 0.0f);
+    }
+    f32 inv_length = fast_rsqrt(length_sq);
+    return quat(q.x * inv_length, q.y * inv_length, 0.0f, q.w * inv_length);
+}
+
+// --------
+// WIDE
+// The branches of the scalar versions become selects. Quadrants are found with rounds since the lanes are floats :
+// q is odd when q / 2 isn't an integer.
+
+// Lanes where the integer q is odd
+static inline f32x4 fast_is_odd_x4_(const f32x4 q) {
+    f32x4 half = f32x4_mul(q, f32x4_set1(0.5f));
+    return f32x4_cmpge(f32x4_abs(f32x4_sub(half, f32x4_round(half))), f32x4_set1(0.25f));
+}
+
+static inline void fast_sincos_x4(const f32x4 x, f32x4 *s, f32x4 *c) {
+    f32x4 q = f32x4_round(f32x4_mul(x, f32x4_set1(FAST_2_OVER_PI)));
+    f32x4 r = f32x4_sub(x, f32x4_mul(q, f32x4_set1(FAST_PIO2_1)));
+    r = f32x4_sub(r, f32x4_mul(q, f32x4_set1(FAST_PIO2_2)));
+    r = f32x4_sub(r, f32x4_mul(q, f32x4_set1(FAST_PIO2_3)));
+    f32x4 z = f32x4_mul(r, r);
+    
+    f32x4 sin_r = f32x4_madd(z, f32x4_set1(-1.9515295891e-4f), f32x4_set1(8.3321608736e-3f));
+    sin_r = f32x4_madd(z, sin_r, f32x4_set1(-1.6666654611e-1f));
+    sin_r = f32x4_madd(f32x4_mul(r, z), sin_r, r);
+    f32x4 cos_r = f32x4_madd(z, f32x4_set1(2.443315711809948e-5f), f32x4_set1(-1.388731625493765e-3f));
+    cos_r = f32x4_madd(z, cos_r, f32x4_set1(4.166664568298827e-2f));
+    cos_r = f32x4_madd(f32x4_mul(z, z), cos_r, f32x4_sub(f32x4_set1(1.0f), f32x4_mul(f32x4_set1(0.5f), z)));
+    
+    // Bit 0 of the quadrant swaps sin and cos, bit 1 is the sign of sin
+    f32x4 odd = fast_is_odd_x4_(q);
+    f32x4 high = fast_is_odd_x4_(f32x4_mul(f32x4_sub(q, f32x4_and(odd, f32x4_set1(1.0f))), f32x4_set1(0.5f)));
+    f32x4 sign = f32x4_set1(-0.0f);
+    *s = f32x4_xor(f32x4_select(odd, cos_r, sin_r), f32x4_and(high, sign));
+    *c = f32x4_xor(f32x4_select(odd, sin_r, cos_r), f32x4_and(f32x4_xor(high, odd), sign));
+}
+
+static inline f32x4 fast_sin_x4(const f32x4 x) {
+    f32x4 s, c;
+    fast_sincos_x4(x, &s, &c);
+    return s;
+}
+
+static inline f32x4 fast_cos_x4(const f32x4 x) {
+    f32x4 s, c;
+    fast_sincos_x4(x, &s, &c);
+    return c;
+}
+
+static inline f32x4 fast_atan2_x4(const f32x4 y, const f32x4 x) {
+    f32x4 ax = f32x4_abs(x);
+    f32x4 ay = f32x4_abs(y);
+    f32x4 biggest = f32x4_max(ax, ay);
+    f32x4 t = f32x4_div(f32x4_min(ax, ay), biggest);
+    
+    f32x4 reduce = f32x4_cmplt(f32x4_set1(FAST_TAN_PI_OVER_8), t);
+    t = f32x4_select(reduce, f32x4_div(f32x4_sub(t, f32x4_set1(1.0f)), f32x4_add(t, f32x4_set1(1.0f))), t);
+    f32x4 z = f32x4_mul(t, t);
+    f32x4 result = f32x4_madd(z, f32x4_set1(8.05374449538e-2f), f32x4_set1(-1.38776856032e-1f));
+    result = f32x4_madd(z, result, f32x4_set1(1.99777106478e-1f));
+    result = f32x4_madd(z, result, f32x4_set1(-3.33329491539e-1f));
+    result = f32x4_madd(f32x4_mul(z, t), result, t);
+    result = f32x4_add(result, f32x4_and(reduce, f32x4_set1(FAST_PI_OVER_4)));
+    
+    result = f32x4_select(f32x4_cmplt(ax, ay), f32x4_sub(f32x4_set1(FAST_PI_OVER_2), result), result);
+    result = f32x4_select(f32x4_cmplt(x, f32x4_zero()), f32x4_sub(f32x4_set1(PI), result), result);
+    result = f32x4_select(f32x4_cmplt(y, f32x4_zero()), f32x4_neg(result), result);
+    // 0 / 0 lanes
+    return f32x4_select(f32x4_cmplt(f32x4_zero(), biggest), result, f32x4_zero());
+}
+
+static inline f32x4 fast_acos_x4(const f32x4 x) {
+    f32x4 a = f32x4_abs(x);
+    f32x4 big = f32x4_cmplt(f32x4_set1(0.5f), a);
+    f32x4 w = f32x4_select(big, f32x4_sqrt(f32x4_mul(f32x4_set1(0.5f), f32x4_sub(f32x4_set1(1.0f), a))), x);
+    
+    f32x4 z = f32x4_mul(w, w);
+    f32x4 asin_w = f32x4_madd(z, f32x4_set1(4.2163199048e-2f), f32x4_set1(2.4181311049e-2f));
+    asin_w = f32x4_madd(z, asin_w, f32x4_set1(4.5470025998e-2f));
+    asin_w = f32x4_madd(z, asin_w, f32x4_set1(7.4953002686e-2f));
+    asin_w = f32x4_madd(z, asin_w, f32x4_set1(1.6666752422e-1f));
+    asin_w = f32x4_madd(f32x4_mul(z, w), asin_w, w);
+    
+    f32x4 twice = f32x4_add(asin_w, asin_w);
+    f32x4 big_result = f32x4_select(f32x4_cmplt(x, f32x4_zero()), f32x4_sub(f32x4_set1(PI), twice), twice);
+    return f32x4_select(big, big_result, f32x4_sub(f32x4_set1(FAST_PI_OVER_2), asin_w));
+}
+
+static inline f32x8 fast_is_odd_x8_(const f32x8 q) {
+    f32x8 half = f32x8_mul(q, f32x8_set1(0.5f));
+    return f32x8_cmpge(f32x8_abs(f32x8_sub(half, f32x8_round(half))), f32x8_set1(0.25f));
+}
+
+static inline void fast_sincos_x8(const f32x8 x, f32x8 *s, f32x8 *c) {
+    f32x8 q = f32x8_round(f32x8_mul(x, f32x8_set1(FAST_2_OVER_PI)));
+    f32x8 r = f32x8_sub(x, f32x8_mul(q, f32x8_set1(FAST_PIO2_1)));
+    r = f32x8_sub(r, f32x8_mul(q, f32x8_set1(FAST_PIO2_2)));
+    r = f32x8_sub(r, f32x8_mul(q, f32x8_set1(FAST_PIO2_3)));
+    f32x8 z = f32x8_mul(r, r);
+    
+    f32x8 sin_r = f32x8_madd(z, f32x8_set1(-1.9515295891e-4f), f32x8_set1(8.3321608736e-3f));
+    sin_r = f32x8_madd(z, sin_r, f32x8_set1(-1.6666654611e-1f));
+    sin_r = f32x8_madd(f32x8_mul(r, z), sin_r, r);
+    f32x8 cos_r = f32x8_madd(z, f32x8_set1(2.443315711809948e-5f), f32x8_set1(-1.388731625493765e-3f));
+    cos_r = f32x8_madd(z, cos_r, f32x8_set1(4.166664568298827e-2f));
+    cos_r = f32x8_madd(f32x8_mul(z, z), cos_r, f32x8_sub(f32x8_set1(1.0f), f32x8_mul(f32x8_set1(0.5f), z)));
+    
+    f32x8 odd = fast_is_odd_x8_(q);
+    f32x8 high = fast_is_odd_x8_(f32x8_mul(f32x8_sub(q, f32x8_and(odd, f32x8_set1(1.0f))), f32x8_set1(0.5f)));
+    f32x8 sign = f32x8_set1(-0.0f);
+    *s = f32x8_xor(f32x8_select(odd, cos_r, sin_r), f32x8_and(high, sign));
+    *c = f32x8_xor(f32x8_select(odd, sin_r, cos_r), f32x8_and(f32x8_xor(high, odd), sign));
+}
+
+static inline f32x8 fast_sin_x8(const f32x8 x) {
+    f32x8 s, c;
+    fast_sincos_x8(x, &s, &c);
+    return s;
+}
+
+static inline f32x8 fast_cos_x8(const f32x8 x) {
+    f32x8 s, c;
+    fast_sincos_x8(x, &s, &c);
+    return c;
+}
+
+static inline f32x8 fast_atan2_x8(const f32x8 y, const f32x8 x) {
+    f32x8 ax = f32x8_abs(x);
+    f32x8 ay = f32x8_abs(y);
+    f32x8 biggest = f32x8_max(ax, ay);
+    f32x8 t = f32x8_div(f32x8_min(ax, ay), biggest);
+    
+    f32x8 reduce = f32x8_cmplt(f32x8_set1(FAST_TAN_PI_OVER_8), t);
+    t = f32x8_select(reduce, f32x8_div(f32x8_sub(t, f32x8_set1(1.0f)), f32x8_add(t, f32x8_set1(1.0f))), t);
+    f32x8 z = f32x8_mul(t, t);
+    f32x8 result = f32x8_madd(z, f32x8_set1(8.05374449538e-2f), f32x8_set1(-1.38776856032e-1f));
+    result = f32x8_madd(z, result, f32x8_set1(1.99777106478e-1f));
+    result = f32x8_madd(z, result, f32x8_set1(-3.33329491539e-1f));
+    result = f32x8_madd(f32x8_mul(z, t), result, t);
+    result = f32x8_add(result, f32x8_and(reduce, f32x8_set1(FAST_PI_OVER_4)));
+    
+    result = f32x8_select(f32x8_cmplt(ax, ay), f32x8_sub(f32x8_set1(FAST_PI_OVER_2), result), result);
+    result = f32x8_select(f32x8_cmplt(x, f32x8_zero()), f32x8_sub(f32x8_set1(PI), result), result);
+    result = f32x8_select(f32x8_cmplt(y, f32x8_zero()), f32x8_neg(result), result);
+    return f32x8_select(f32x8_cmplt(f32x8_zero(), biggest), result, f32x8_zero());
+}
+
+static inline f32x8 fast_acos_x8(const f32x8 x) {
+    f32x8 a = f32x8_abs(x);
+    f32x8 big = f32x8_cmplt(f32x8_set1(0.5f), a);
+    f32x8 w = f32x8_select(big, f32x8_sqrt(f32x8_mul(f32x8_set1(0.5f), f32x8_sub(f32x8_set1(1.0f), a))), x);
+    
+    f32x8 z = f32x8_mul(w, w);
+    f32x8 asin_w = f32x8_madd(z, f32x8_set1(4.2163199048e-2f), f32x8_set1(2.4181311049e-2f));
+    asin_w = f32x8_madd(z, asin_w, f32x8_set1(4.5470025998e-2f));
+    asin_w = f32x8_madd(z, asin_w, f32x8_set1(7.4953002686e-2f));
+    asin_w = f32x8_madd(z, asin_w, f32x8_set1(1.6666752422e-1f));
+    asin_w = f32x8_madd(f32x8_mul(z, w), asin_w, w);
+    
+    f32x8 twice = f32x8_add(asin_w, asin_w);
+    f32x8 big_result = f32x8_select(f32x8_cmplt(x, f32x8_zero()), f32x8_sub(f32x8_set1(PI), twice), twice);
+    return f32x8_select(big, big_result, f32x8_sub(f32x8_set1(FAST_PI_OVER_2), asin_w));
+}
+
+static inline f32x4 fast_rsqrt_x4(const f32x4 x) {
+#if defined(SMATH_SSE2)
+    f32x4 y = _mm_rsqrt_ps(x);
+    return f32x4_madd(y, f32x4_sub(f32x4_set1(0.5f), f32x4_mul(f32x4_mul(f32x4_set1(0.5f), x), f32x4_mul(y, y))), y);
+#else
+    return f32x4_setr(fast_rsqrt(x.f[0]), fast_rsqrt(x.f[1]), fast_rsqrt(x.f[2]), fast_rsqrt(x.f[3]));
+#endif
+}
+
+static inline f32x8 fast_rsqrt_x8(const f32x8 x) {
+#if defined(SMATH_AVX)
+    f32x8 y = _mm256_rsqrt_ps(x);
+    return f32x8_madd(y, f32x8_sub(f32x8_set1(0.5f), f32x8_mul(f32x8_mul(f32x8_set1(0.5f), x), f32x8_mul(y, y))), y);
+#else
+    return (f32x8){fast_rsqrt_x4(x.low), fast_rsqrt_x4(x.high)};
+#endif
+}
@@ -63,7 +63,7 @@ typedef struct GLTFPrimitive {
 } GLTFPrimitive;
 
 typedef struct GLTFMesh {
-    char *name;
+    sStringID name;
     
     u32 primitive_count;
     GLTFPrimitive *primitives;
@@ -74,12 +74,15 @@ typedef struct GLTFSkin {
     
     u32 joint_count;
     u32 *joints;
+    // Joints sorted so that parents come before their children, see GLTFSortSkinJoints
+    u32 *joint_order; // joint_order[i] is the index in joints of the sorted joint i
+    u32 *joint_remap; // joint_remap[j] is the sorted index of joints[j]
     
-    char *name;
+    sStringID name;
 } GLTFSkin;
 
 typedef struct GLTFNode {
-    char *name;
+    sStringID name;
     
     Transform xform;
     
@@ -116,7 +119,7 @@ typedef struct GLTFAnimation {
     u32 channel_count;
     GLTFChannel *channels;
     
-    char *name;
+    sStringID name;
     
     u32 sampler_count;
     GLTFSampler *samplers;
@@ -126,6 +129,9 @@ typedef struct GLTFAnimation {
 typedef struct GLTF {
     const char* path;
     
+    sArena *arena;  // Everything below is allocated here
+    u64 arena_mark; // Position of the arena before loading
+    
     u32 accessor_count;
     GLTFAccessor *accessors;
     
@@ -247,6 +253,18 @@ char *JsonParseString(char *ptr, char *dst) {
     return (ptr++);
 }
 
+// Interns the string instead of copying it
+char *JsonParseStringID(char *ptr, sStringID *dst) {
+    ASSERT(*ptr == '\"');
+    ptr++;
+    char *start = ptr;
+    while(*ptr != '\"') {
+        ptr++;
+    }
+    *dst = sInternLength(start, ptr - start);
+    return ptr + 1;
+}
+
 char *JsonParseU32(char *ptr, u32 *dst){
     sscanf(ptr, "%d", dst);
     while(*ptr >= '0' && *ptr <= '9') ptr++;
@@ -285,11 +303,11 @@ char *JsonSkipValue(char *ptr) {
     return(ptr);
 }
 
-char *GLTFParseAccessors(char *ptr, GLTFAccessor **accessors, u32 *count) {
+char *GLTFParseAccessors(char *ptr, GLTFAccessor **accessors, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Accessors");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *accessors = sCalloc(array_count, sizeof(GLTFAccessor));
+    *accessors = sArenaPushArray(arena, array_count, GLTFAccessor);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -352,11 +370,11 @@ char *GLTFParseAccessors(char *ptr, GLTFAccessor **accessors, u32 *count) {
     return (ptr);
 }
 
-char *GLTFParseBufferViews(char *ptr, GLTFBufferView **buffer_views, u32 *count) {
+char *GLTFParseBufferViews(char *ptr, GLTFBufferView **buffer_views, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Buffer Views");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *buffer_views = sCalloc(array_count, sizeof(GLTFBufferView));
+    *buffer_views = sArenaPushArray(arena, array_count, GLTFBufferView);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -404,11 +422,11 @@ char *GLTFParseBufferViews(char *ptr, GLTFBufferView **buffer_views, u32 *count)
     return (ptr);
 }
 
-char *GLTFParseBuffers(char *ptr, GLTFBuffer **buffers, u32 *count, const char* path, PlatformAPI *platform) {
+char *GLTFParseBuffers(char *ptr, GLTFBuffer **buffers, u32 *count, const char* path, PlatformAPI *platform, sArena *arena) {
     sTrace("GLTF: Reading Buffers");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *buffers = sCalloc(array_count, sizeof(GLTFBuffer));
+    *buffers = sArenaPushArray(arena, array_count, GLTFBuffer);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -435,7 +453,7 @@ char *GLTFParseBuffers(char *ptr, GLTFBuffer **buffers, u32 *count, const char*
                 
                 if (strncmp(ptr, "\"data:", 6) == 0) { // We are embedded
                     sTrace("Loading buffer as embeded");
-                    buf->data = sCalloc(buf->byte_length, 1);
+                    buf->data = sArenaPush(arena, buf->byte_length);
                     ptr += 6;
                     
                     while(*(ptr++) != ',');
@@ -443,7 +461,7 @@ char *GLTFParseBuffers(char *ptr, GLTFBuffer **buffers, u32 *count, const char*
                     while(*(ptr++) != '\"');
                 } else {
                     u32 length = JsonGetStringLength(ptr);
-                    buf->uri = sCalloc(length, sizeof(char));
+                    buf->uri = sArenaPushArray(arena, length, char);
                     ptr = JsonParseString(ptr, buf->uri);
                     
                     char directory[128] = {0};
@@ -458,7 +476,7 @@ char *GLTFParseBuffers(char *ptr, GLTFBuffer **buffers, u32 *count, const char*
                     strcat(buffer_path, directory);
                     strcat(buffer_path, buf->uri);
                     platform->ReadBinary(buffer_path, &buffer_size, NULL);
-                    buf->data = sCalloc(buffer_size, 1);
+                    buf->data = sArenaPush(arena, buffer_size);
                     platform->ReadBinary(buffer_path, &buffer_size, buf->data);
                     
                 }
@@ -479,11 +497,11 @@ char *GLTFParseBuffers(char *ptr, GLTFBuffer **buffers, u32 *count, const char*
     return (ptr);
 }
 
-char *GLTFParseImages(char *ptr, GLTFImage **images, u32 *count) {
+char *GLTFParseImages(char *ptr, GLTFImage **images, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Images");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *images = sCalloc(array_count, sizeof(GLTFImage));
+    *images = sArenaPushArray(arena, array_count, GLTFImage);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -506,7 +524,7 @@ char *GLTFParseImages(char *ptr, GLTFImage **images, u32 *count) {
             ptr = JsonEatColon(ptr);
             if(strcmp(key, "uri") == 0) {
                 u32 length = JsonGetStringLength(ptr);
-                img->uri = sCalloc(length, sizeof(char));
+                img->uri = sArenaPushArray(arena, length, char);
                 ptr = JsonParseString(ptr, img->uri);
             } else {
                 sTrace("JSON: Unread value %s", key);
@@ -525,11 +543,11 @@ char *GLTFParseImages(char *ptr, GLTFImage **images, u32 *count) {
     return (ptr);
 }
 
-char *GLTFParsePrimitives(char *ptr, GLTFPrimitive **primitives, u32 *count) {
+char *GLTFParsePrimitives(char *ptr, GLTFPrimitive **primitives, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Buffers");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *primitives = sCalloc(array_count, sizeof(GLTFPrimitive));
+    *primitives = sArenaPushArray(arena, array_count, GLTFPrimitive);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -608,11 +626,11 @@ char *GLTFParsePrimitives(char *ptr, GLTFPrimitive **primitives, u32 *count) {
     return (ptr);
 }
 
-char *GLTFParseMeshes(char *ptr, GLTFMesh **meshes, u32 *count) {
+char *GLTFParseMeshes(char *ptr, GLTFMesh **meshes, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Buffers");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *meshes = sCalloc(array_count, sizeof(GLTFMesh));
+    *meshes = sArenaPushArray(arena, array_count, GLTFMesh);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -634,11 +652,9 @@ char *GLTFParseMeshes(char *ptr, GLTFMesh **meshes, u32 *count) {
             ptr = JsonParseString(ptr, key);
             ptr = JsonEatColon(ptr);
             if(strcmp(key, "primitives") == 0) {
-                ptr = GLTFParsePrimitives(ptr, &mesh->primitives, &mesh->primitive_count);
+                ptr = GLTFParsePrimitives(ptr, &mesh->primitives, &mesh->primitive_count, arena);
             } else if(strcmp(key, "name") == 0) {
-                u32 length = JsonGetStringLength(ptr);
-                mesh->name = sCalloc(length, sizeof(char));
-                ptr = JsonParseString(ptr, mesh->name);
+                ptr = JsonParseStringID(ptr, &mesh->name);
             } else {
                 sTrace("JSON: Unread value %s", key);
                 ptr = JsonSkipValue(ptr);
@@ -657,11 +673,11 @@ char *GLTFParseMeshes(char *ptr, GLTFMesh **meshes, u32 *count) {
 }
 
 
-char *GLTFParseSkins(char *ptr, GLTFSkin **skins, u32 *count) {
+char *GLTFParseSkins(char *ptr, GLTFSkin **skins, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Skins");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *skins = sCalloc(array_count, sizeof(GLTFSkin));
+    *skins = sArenaPushArray(arena, array_count, GLTFSkin);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -685,12 +701,10 @@ char *GLTFParseSkins(char *ptr, GLTFSkin **skins, u32 *count) {
             if(strcmp(key, "inverseBindMatrices") == 0) {
                 ptr = JsonParseU32(ptr, &skin->inverse_bind_matrices);
             } else if(strcmp(key, "name") == 0) {
-                u32 length = JsonGetStringLength(ptr);
-                skin->name = sCalloc(length, sizeof(char));
-                ptr = JsonParseString(ptr, skin->name);
+                ptr = JsonParseStringID(ptr, &skin->name);
             } else if(strcmp(key, "joints") == 0) {
                 skin->joint_count = JsonCountArray(ptr);
-                skin->joints = sCalloc(skin->joint_count, sizeof(u32));
+                skin->joints = sArenaPushArray(arena, skin->joint_count, u32);
                 ptr++; // '['
                 ptr = EatSpaces(ptr);
                 for(u32 j = 0; j < skin->joint_count; j++) {
@@ -718,11 +732,11 @@ char *GLTFParseSkins(char *ptr, GLTFSkin **skins, u32 *count) {
     return (ptr);
 }
 
-char *GLTFParseNodes(char *ptr, GLTFNode **nodes, u32 *count) {
+char *GLTFParseNodes(char *ptr, GLTFNode **nodes, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Nodes");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *nodes = sCalloc(array_count, sizeof(GLTFNode));
+    *nodes = sArenaPushArray(arena, array_count, GLTFNode);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -746,12 +760,10 @@ char *GLTFParseNodes(char *ptr, GLTFNode **nodes, u32 *count) {
             ptr = JsonEatColon(ptr);
             
             if(strcmp(key, "name") == 0) {
-                u32 length = JsonGetStringLength(ptr);
-                node->name = sCalloc(length, sizeof(char));
-                ptr = JsonParseString(ptr, node->name);
+                ptr = JsonParseStringID(ptr, &node->name);
             } else if(strcmp(key, "children") == 0) {
                 node->child_count = JsonCountArray(ptr);
-                node->children = sCalloc(node->child_count, sizeof(u32));
+                node->children = sArenaPushArray(arena, node->child_count, u32);
                 ptr ++; // '['
                 for(u32 j = 0; j < node->child_count; j++) {
                     ptr = EatSpaces(ptr);
@@ -809,12 +821,12 @@ char *GLTFParseNodes(char *ptr, GLTFNode **nodes, u32 *count) {
     return (ptr);
 }
 
-char *GLTFParseChannels(char *ptr, GLTFChannel **channels, u32 *count) {
+char *GLTFParseChannels(char *ptr, GLTFChannel **channels, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Channels");
     
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *channels = sCalloc(array_count, sizeof(GLTFChannel));
+    *channels = sArenaPushArray(arena, array_count, GLTFChannel);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -902,12 +914,12 @@ char *GLTFParseChannels(char *ptr, GLTFChannel **channels, u32 *count) {
     return (ptr);
 }
 
-char *GLTFParseSamplers(char *ptr, GLTFSampler **samplers, u32 *count) {
+char *GLTFParseSamplers(char *ptr, GLTFSampler **samplers, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Channels");
     
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *samplers = sCalloc(array_count, sizeof(GLTFSampler));
+    *samplers = sArenaPushArray(arena, array_count, GLTFSampler);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -965,11 +977,11 @@ char *GLTFParseSamplers(char *ptr, GLTFSampler **samplers, u32 *count) {
     return (ptr);
 }
 
-char *GLTFParseAnimations(char *ptr, GLTFAnimation **animations, u32 *count) {
+char *GLTFParseAnimations(char *ptr, GLTFAnimation **animations, u32 *count, sArena *arena) {
     sTrace("GLTF: Reading Animations");
     u32 array_count = JsonCountArray(ptr);
     *count = array_count;
-    *animations = sCalloc(array_count, sizeof(GLTFAnimation));
+    *animations = sArenaPushArray(arena, array_count, GLTFAnimation);
     ptr++; // '['
     ptr = EatSpaces(ptr);
     
@@ -992,14 +1004,12 @@ char *GLTFParseAnimations(char *ptr, GLTFAnimation **animations, u32 *count) {
             ptr = JsonEatColon(ptr);
             
             if(strcmp(key, "name") == 0) {
-                u32 length = JsonGetStringLength(ptr);
-                animation->name = sCalloc(length, sizeof(char));
-                ptr = JsonParseString(ptr, animation->name);
+                ptr = JsonParseStringID(ptr, &animation->name);
             } else if(strcmp(key, "channels") == 0) {
-                ptr = GLTFParseChannels(ptr, &animation->channels, &animation->channel_count);
+                ptr = GLTFParseChannels(ptr, &animation->channels, &animation->channel_count, arena);
                 ptr = EatSpaces(ptr);
             } else if(strcmp(key, "samplers") == 0) {
-                ptr = GLTFParseSamplers(ptr, &animation->samplers, &animation->sampler_count);
+                ptr = GLTFParseSamplers(ptr, &animation->samplers, &animation->sampler_count, arena);
                 ptr = EatSpaces(ptr);
             } else {
                 sTrace("JSON: Unread value %s", key);
@@ -1020,11 +1030,56 @@ char *GLTFParseAnimations(char *ptr, GLTFAnimation **animations, u32 *count) {
     
 }
 
+#define GLTF_NO_JOINT 0xFFFFFFFF
+
+// Depth first order of the joints, so a parent is always before its children and each subtree is contiguous
+internal void GLTFSortSkinJoints(const GLTF *gltf, GLTFSkin *skin, sArena *arena) {
+    skin->joint_order = sArenaPushArray(arena, skin->joint_count, u32);
+    skin->joint_remap = sArenaPushArray(arena, skin->joint_count, u32);
+    
+    u64 mark = sArenaGetMark(arena);
+    u32 *node_joints = sArenaPushArray(arena, gltf->node_count, u32);
+    memset(node_joints, 0xFF, gltf->node_count * sizeof(u32));
+    for(u32 j = 0; j < skin->joint_count; j++) {
+        node_joints[skin->joints[j]] = j;
+    }
+    bool *is_child = sArenaPushArray(arena, skin->joint_count, bool);
+    for(u32 j = 0; j < skin->joint_count; j++) {
+        const GLTFNode *node = &gltf->nodes[skin->joints[j]];
+        for(u32 c = 0; c < node->child_count; c++) {
+            if(node_joints[node->children[c]] != GLTF_NO_JOINT)
+                is_child[node_joints[node->children[c]]] = true;
+        }
+    }
+    
+    // Pushed in reverse so the roots and the children come out in the file order
+    u32 *stack = sArenaPushArray(arena, skin->joint_count, u32);
+    u32 stack_size = 0;
+    for(u32 j = skin->joint_count; j-- > 0;) {
+        if(!is_child[j])
+            stack[stack_size++] = j;
+    }
+    u32 sorted_count = 0;
+    while(stack_size > 0) {
+        const u32 j = stack[--stack_size];
+        skin->joint_remap[j] = sorted_count;
+        skin->joint_order[sorted_count++] = j;
+        const GLTFNode *node = &gltf->nodes[skin->joints[j]];
+        for(u32 c = node->child_count; c-- > 0;) {
+            if(node_joints[node->children[c]] != GLTF_NO_JOINT)
+                stack[stack_size++] = node_joints[node->children[c]];
+        }
+    }
+    ASSERT_MSG(sorted_count == skin->joint_count, "Skin joints aren't a hierarchy");
+    sArenaPopToMark(arena, mark);
+}
+
+// Sorted index of the joint of a node, see GLTFSortSkinJoints
 u32 GLTFGetBoneIDFromNode(const GLTF *gltf, const u32 node_id) {
     
     for(u32 i = 0; i < gltf->skins[0].joint_count; ++i) {
         if(gltf->skins[0].joints[i] == node_id)
-            return (i);
+            return gltf->skins[0].joint_remap[i];
     }
     ASSERT(0);
     return 0;
@@ -1069,7 +1124,9 @@ void GLTFCopyAccessor(const GLTF *gltf, const u32 acc_id, void *dst, const u32 o
     }
 }
 
-GLTF *LoadGLTF(const char *path, PlatformAPI *platform) {
+// Parses the file into arena. Everything is released by DestroyGLTF, so don't push anything else
+// on top of it if it needs to outlive the GLTF.
+GLTF *LoadGLTF(const char *path, PlatformAPI *platform, sArena *arena) {
     
     FILE *file = fopen(path, "r");
     if(!file) {
@@ -1077,16 +1134,20 @@ GLTF *LoadGLTF(const char *path, PlatformAPI *platform) {
         return NULL;
     }
     
+    u64 arena_mark = sArenaGetMark(arena);
+    
     i32 file_size;
     platform->ReadWholeFile(path, &file_size, NULL);
-    char *file_start = sCalloc(file_size, sizeof(char));
+    char *file_start = sArenaPushArray(arena, file_size + 1, char); // +1 for the '\0'
     platform->ReadWholeFile(path, &file_size, file_start);
     
     sTrace("File read. %d characters", file_size);
     
-    GLTF *gltf = sCalloc(1, sizeof(GLTF));
+    GLTF *gltf = sArenaPushArray(arena, 1, GLTF);
     
     gltf->path = path;
+    gltf->arena = arena;
+    gltf->arena_mark = arena_mark;
     
     bool parsing = true;
     u32 depth = 0;
@@ -1115,21 +1176,21 @@ GLTF *LoadGLTF(const char *path, PlatformAPI *platform) {
                     ptr = JsonParseString(ptr, key);
                     ptr = JsonEatColon(ptr);
                     if (strcmp(key, "accessors") == 0)
-                        ptr = GLTFParseAccessors(ptr, &gltf->accessors, &gltf->accessor_count);
+                        ptr = GLTFParseAccessors(ptr, &gltf->accessors, &gltf->accessor_count, arena);
                     else if (strcmp(key, "bufferViews") == 0)
-                        ptr = GLTFParseBufferViews(ptr, &gltf->buffer_views, &gltf->buffer_view_count);
+                        ptr = GLTFParseBufferViews(ptr, &gltf->buffer_views, &gltf->buffer_view_count, arena);
                     else if (strcmp(key, "buffers") == 0)
-                        ptr = GLTFParseBuffers(ptr, &gltf->buffers, &gltf->buffer_count, path, platform);
+                        ptr = GLTFParseBuffers(ptr, &gltf->buffers, &gltf->buffer_count, path, platform, arena);
                     else if (strcmp(key, "images") == 0)
-                        ptr = GLTFParseImages(ptr, &gltf->images, &gltf->image_count);
+                        ptr = GLTFParseImages(ptr, &gltf->images, &gltf->image_count, arena);
                     else if (strcmp(key, "meshes") == 0)
-                        ptr = GLTFParseMeshes(ptr, &gltf->meshes, &gltf->mesh_count);
+                        ptr = GLTFParseMeshes(ptr, &gltf->meshes, &gltf->mesh_count, arena);
                     else if (strcmp(key, "skins") == 0)
-                        ptr = GLTFParseSkins(ptr, &gltf->skins, &gltf->skin_count);
+                        ptr = GLTFParseSkins(ptr, &gltf->skins, &gltf->skin_count, arena);
                     else if (strcmp(key, "nodes") == 0)
-                        ptr = GLTFParseNodes(ptr, &gltf->nodes, &gltf->node_count);
+                        ptr = GLTFParseNodes(ptr, &gltf->nodes, &gltf->node_count, arena);
                     else if (strcmp(key, "animations") == 0)
-                        ptr = GLTFParseAnimations(ptr, &gltf->animations, &gltf->animation_count);
+                        ptr = GLTFParseAnimations(ptr, &gltf->animations, &gltf->animation_count, arena);
                     else  {
                         sTrace("JSON: Unread value %s", key);
                         ptr = JsonSkipValue(ptr);
@@ -1142,66 +1203,14 @@ GLTF *LoadGLTF(const char *path, PlatformAPI *platform) {
         }
     }
     
-    
-    
-    sFree(file_start);
+    for(u32 i = 0; i < gltf->skin_count; i++) {
+        GLTFSortSkinJoints(gltf, &gltf->skins[i], arena);
+    }
     
     return gltf;
 }
 
+// Everything loaded by LoadGLTF is in the arena after gltf->arena_mark, so it is released in one go
 void DestroyGLTF(GLTF *gltf) {
-    
-    sFree(gltf->accessors);
-    sFree(gltf->buffer_views);
-    
-    for(u32 i = 0; i < gltf->buffer_count; i++) {
-        if(gltf->buffers[i].uri)
-            sFree(gltf->buffers[i].uri);
-        
-        sFree(gltf->buffers[i].data);
-    }
-    sFree(gltf->buffers);
-    
-    if(gltf->image_count > 0) {
-        for(u32 i = 0; i < gltf->image_count; i++) {
-            sFree(gltf->images[i].uri);
-        }
-        sFree(gltf->images);
-    }
-    
-    if(gltf->mesh_count > 0) { 
-        for(u32 i = 0; i < gltf->mesh_count; i++) {
-            sFree(gltf->meshes[i].primitives);
-            sFree(gltf->meshes[i].name);
-        }
-        sFree(gltf->meshes);
-    }
-    
-    if(gltf->skin_count > 0) {
-        for(u32 i = 0; i < gltf->skin_count; i++) {
-            sFree(gltf->skins[i].joints);
-            sFree(gltf->skins[i].name);
-        }
-        sFree(gltf->skins);
-    } 
-    
-    if(gltf->node_count > 0) {
-        for(u32 i = 0; i < gltf->node_count; i++) {
-            sFree(gltf->nodes[i].name);
-            if(gltf->nodes[i].child_count > 0)
-                sFree(gltf->nodes[i].children);
-        }
-        sFree(gltf->nodes);
-    } 
-    
-    if(gltf->animation_count > 0) {
-        for(u32 i = 0; i < gltf->animation_count; i++) {
-            sFree(gltf->animations[i].channels);
-            sFree(gltf->animations[i].samplers);
-            sFree(gltf->animations[i].name);
-        }
-        sFree(gltf->animations);
-    }
-    
-    sFree(gltf);
-}
\ No newline at end of file
+    sArenaPopToMark(gltf->arena, gltf->arena_mark);
+}
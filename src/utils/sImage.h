@@ -250,12 +250,12 @@ internal void HuffmanCompute(const u32 size, const u32 *lengths, u32 *huffman_ta
     u32 max_length = HuffmanGetMaxLength(size, lengths);
 
     // We will store here the amount of occurences of length i. ie : length_counts[9] == 8 > there are 8 codes with a length of 9
-    u32 *length_counts = sCalloc(max_length + 1, sizeof(u32));
+    u32 *length_counts = sCallocTagged(max_length + 1, sizeof(u32), MEM_TAG_IMAGE);
 
     HuffmanGetLengthCounts(size, lengths, length_counts);
     length_counts[0] = 0;
     // We will store here the next value to assign to a length i. if we want to query the next value for length 4 -> length_values[4].
-    u32 *length_values = sCalloc(max_length + 1, sizeof(u32));
+    u32 *length_values = sCallocTagged(max_length + 1, sizeof(u32), MEM_TAG_IMAGE);
 
     length_values[0] = 0;
 
@@ -330,7 +330,7 @@ internal void PNGReadPacket(FILE *file, PNG_Packet *packet) {
         sWarn("PNG : Type %s (unhandled)", str);
     }
 
-    packet->data = sMalloc(packet->length * sizeof(u8));
+    packet->data = sMallocTagged(packet->length * sizeof(u8), MEM_TAG_IMAGE);
     fread(packet->data, sizeof(u8), packet->length, file);
 
     // CRC
@@ -383,7 +383,7 @@ internal bool PNGParse(FILE *file, PNG_DataStream *stream, PNG_Image *image) {
             sFree(packet.data);
         } break;
         case PNG_TYPE_IDAT: {
-            PNG_DataChunk *chunk = sMalloc(sizeof(PNG_DataChunk));
+            PNG_DataChunk *chunk = sMallocTagged(sizeof(PNG_DataChunk), MEM_TAG_IMAGE);
             chunk->next = 0;
             chunk->data = packet.data;
             chunk->size = packet.length;
@@ -447,10 +447,10 @@ internal void PNGDecode(PNG_DataStream *stream, u8 *out_ptr, u8 *dbg_end) {
                     u32 value = StreamReadBits(stream, 3);
                     HCLENLengthTable[HCLENSwizzle[i]] = value;
                 }
-                u32 *HCLENCodes = sCalloc(19, sizeof(u32));
+                u32 *HCLENCodes = sCallocTagged(19, sizeof(u32), MEM_TAG_IMAGE);
                 HuffmanCompute(19, HCLENLengthTable, HCLENCodes);
 
-                HLITHDISTLengths = sCalloc(HLIT + HDIST, sizeof(u32));
+                HLITHDISTLengths = sCallocTagged(HLIT + HDIST, sizeof(u32), MEM_TAG_IMAGE);
                 u32 index = 0;
                 while(index < HLIT + HDIST) {
                     u32 decoded = HuffmanDecode(stream, HCLENCodes, HCLENLengthTable, 19);
@@ -485,8 +485,8 @@ internal void PNGDecode(PNG_DataStream *stream, u8 *out_ptr, u8 *dbg_end) {
                     }
                 }
 
-                litlen_table = sCalloc(HLIT, sizeof(u32));
-                distance_table = sCalloc(HDIST, sizeof(u32));
+                litlen_table = sCallocTagged(HLIT, sizeof(u32), MEM_TAG_IMAGE);
+                distance_table = sCallocTagged(HDIST, sizeof(u32), MEM_TAG_IMAGE);
                 HuffmanCompute(HLIT, HLITHDISTLengths, litlen_table);
                 HuffmanCompute(HDIST, HLITHDISTLengths + HLIT, distance_table);
                 sFree(HCLENCodes);
@@ -622,7 +622,7 @@ internal void PNGDefilter(PNG_Image *image, u8 *decompressed_image) {
 }
 
 PNG_Image *sLoadImage(const char *path) {
-    PNG_Image *image = sMalloc(sizeof(PNG_Image));
+    PNG_Image *image = sMallocTagged(sizeof(PNG_Image), MEM_TAG_IMAGE);
     // Check extension
     u32 length = strlen(path);
     u32 fmt_index = length - 3;
@@ -654,7 +654,7 @@ PNG_Image *sLoadImage(const char *path) {
     }
 
     u32 decompressed_image_size = image->width * image->height * image->bpp + image->height;
-    u8 *decompressed_image = sMalloc(decompressed_image_size);
+    u8 *decompressed_image = sMallocTagged(decompressed_image_size, MEM_TAG_IMAGE);
     u8 *decompressed_end = decompressed_image + decompressed_image_size;
     srTrace("PNG : Decoding");
     PNGDecode(&stream, decompressed_image, decompressed_end);
@@ -670,7 +670,7 @@ PNG_Image *sLoadImage(const char *path) {
     }
 
     // Defilter
-    image->pixels = sMalloc(image->width * image->height * 4); //RGBA always
+    image->pixels = sMallocTagged(image->width * image->height * 4, MEM_TAG_IMAGE); //RGBA always
     sTrace("PNG : Filtering");
 
     PNGDefilter(image, decompressed_image);
@@ -762,7 +762,7 @@ bool sLoadImageTo(const char *path, void *dst) {
     }
 
     u32 decompressed_image_size = image.width * image.height * image.bpp + image.height;
-    u8 *decompressed_image = sMalloc(decompressed_image_size);
+    u8 *decompressed_image = sMallocTagged(decompressed_image_size, MEM_TAG_IMAGE);
     u8 *decompressed_end = decompressed_image + decompressed_image_size;
     srTrace("PNG : Decoding");
     PNGDecode(&stream, decompressed_image, decompressed_end);
@@ -0,0 +1,126 @@
+#pragma once
+// SINTERN
+// String interning. Each distinct string is stored once and gets a stable 32-bit ID, so comparing strings is comparing IDs.
+// The characters are pushed into an arena and an open-addressed hash index maps a string to its ID. IDs start at 1, 0 means no string.
+// Like the leak list, there is one table for the whole program : the exe creates it and the dll gets it with sInternSetTable.
+
+#include <string.h>
+
+#include "sTypes.h"
+#include "sLeak.h"
+#include "sArena.h"
+
+typedef u32 sStringID;
+
+#define STRING_ID_NONE 0
+
+typedef struct sInternEntry {
+    u32 hash;
+    u32 length;
+    const char *string; // '\0' terminated, in the table's arena
+} sInternEntry;
+
+typedef struct sInternTable {
+    sArena strings;
+
+    sInternEntry *entries; // Entry of ID i is entries[i - 1]
+    u32 count;
+    u32 capacity;
+
+    sStringID *index; // Twice the capacity so it never gets more than half full. STRING_ID_NONE if the slot is empty
+    u32 index_mask;
+} sInternTable;
+
+global sInternTable *intern_table;
+
+// Creates a table of at most capacity strings, holding string_bytes characters in total. Everything comes from arena.
+sInternTable sInternCreate(sArena *arena, const u32 capacity, const u64 string_bytes) {
+    sInternTable table = {0};
+    u32 index_size = 1;
+    while(index_size < capacity * 2) {
+        index_size <<= 1;
+    }
+    table.strings = sArenaCarve(arena, string_bytes);
+    table.entries = sArenaPushArray(arena, capacity, sInternEntry);
+    table.capacity = capacity;
+    table.index = sArenaPushArray(arena, index_size, sStringID);
+    table.index_mask = index_size - 1;
+    return table;
+}
+
+sInternTable *sInternGetTable() {
+    return intern_table;
+}
+
+void sInternSetTable(sInternTable *table) {
+    intern_table = table;
+}
+
+internal u32 sInternHash_(const char *string, const u32 length) {
+    // FNV-1a
+    u32 hash = 2166136261u;
+    for(u32 i = 0; i < length; i++) {
+        hash ^= (u8)string[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Returns the slot of string in the index. It is empty if the string isn't in the table.
+internal u32 sInternFindSlot_(const char *string, const u32 length, const u32 hash) {
+    u32 i = hash & intern_table->index_mask;
+    while(intern_table->index[i] != STRING_ID_NONE) {
+        const sInternEntry *entry = &intern_table->entries[intern_table->index[i] - 1];
+        if(entry->hash == hash && entry->length == length && memcmp(entry->string, string, length) == 0) {
+            break;
+        }
+        i = (i + 1) & intern_table->index_mask;
+    }
+    return i;
+}
+
+// Returns the ID of the first length chars of string, adding them to the table if needed.
+// Returns STRING_ID_NONE if the table is full.
+sStringID sInternLength(const char *string, const u32 length) {
+    ASSERT_MSG(intern_table, "No intern table, call sInternSetTable first");
+    u32 hash = sInternHash_(string, length);
+    u32 slot = sInternFindSlot_(string, length, hash);
+    if(intern_table->index[slot] != STRING_ID_NONE) {
+        return intern_table->index[slot];
+    }
+
+    if(intern_table->count == intern_table->capacity) {
+        sError("Intern table is full, %.*s is ignored", length, string);
+        return STRING_ID_NONE;
+    }
+    const char *copy = sArenaPushString(&intern_table->strings, string, length);
+    if(!copy) {
+        return STRING_ID_NONE;
+    }
+    sInternEntry *entry = &intern_table->entries[intern_table->count++];
+    entry->hash = hash;
+    entry->length = length;
+    entry->string = copy;
+    intern_table->index[slot] = intern_table->count;
+    return intern_table->count;
+}
+
+sStringID sIntern(const char *string) {
+    return sInternLength(string, strlen(string));
+}
+
+// Returns the ID of string if it was already interned, STRING_ID_NONE otherwise. Doesn't add anything to the table.
+sStringID sInternFind(const char *string) {
+    ASSERT_MSG(intern_table, "No intern table, call sInternSetTable first");
+    u32 length = strlen(string);
+    return intern_table->index[sInternFindSlot_(string, length, sInternHash_(string, length))];
+}
+
+// Returns the characters of id, or "" for STRING_ID_NONE
+const char *sInternString(const sStringID id) {
+    if(id == STRING_ID_NONE) {
+        return "";
+    }
+    ASSERT(id <= intern_table->count);
+    return intern_table->entries[id - 1].string;
+}
@@ -8,6 +8,8 @@
 // Include this file where you need, define the macro DEBUG, call DEBUG_Begin() at the start, and DEBUG_End() at the end of your program.
 // It will override malloc, calloc, realloc and free and give you a rundown of what wasn't freed. There's also an assert on freeing an unknown pointer
 // If your program has different contexts, (dynamic libraries for example), you can use DEBUG_GetLeakList() and DEBUG_SetLeakList(list) to link the contexts together
+// Call Leak_EndFrame() once per frame to get per frame allocation counts, and Leak_DumpStats() to log the counters of each call site
+// In every build, sMallocTagged/sCallocTagged/sReallocTagged charge the allocation to a MemTag. sMemDumpTags() logs the current and peak bytes of each tag
 
 #if 0
 
@@ -23,13 +25,131 @@ int main() {
 
 #endif
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "sTypes.h"
 #include "sLogging.h"
 
+// --------
+// Memory tags
+
+// Each allocation is preceded by a small header holding its size and tag, so freeing it
+// updates the counters of its tag without looking anything up.
+// The counters are shared between modules the same way as the leak list : the exe owns them
+// and passes them to the dll with sMemSetTagCounters.
+
+typedef enum MemTag {
+    MEM_TAG_GENERAL,
+    MEM_TAG_RENDER,    // Push buffers, shader sources, font data
+    MEM_TAG_ANIMATION, // Skeletons, poses and animation tracks
+    MEM_TAG_IMAGE,     // PNG decoding
+    
+    MEM_TAG_COUNT,
+} MemTag;
+
+global const char *mem_tag_names[MEM_TAG_COUNT] = {
+    "General",
+    "Render",
+    "Animation",
+    "Image",
+};
+
+typedef struct MemTagCounters {
+    i64 current[MEM_TAG_COUNT];
+    i64 peak[MEM_TAG_COUNT];
+} MemTagCounters;
+
+// 16 bytes so the memory after it keeps the alignment of malloc
+typedef struct MemHeader {
+    u64 size;
+    u32 tag;
+    u32 pad;
+} MemHeader;
+
+global MemTagCounters mem_local_counters;
+global MemTagCounters *mem_counters = &mem_local_counters;
+
+MemTagCounters *sMemGetTagCounters() {
+    return mem_counters;
+}
+
+void sMemSetTagCounters(MemTagCounters *counters) {
+    mem_counters = counters;
+}
+
+internal void mem_tag_add(const u32 tag, const i64 size) {
+    i64 current = __atomic_add_fetch(&mem_counters->current[tag], size, __ATOMIC_RELAXED);
+    // The peak is only written when it grows, which stops happening once the program is warmed up
+    i64 peak = __atomic_load_n(&mem_counters->peak[tag], __ATOMIC_RELAXED);
+    while(current > peak && !__atomic_compare_exchange_n(&mem_counters->peak[tag], &peak, current, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+internal void *mem_tag_header(void *base, const u64 size, const u32 tag) {
+    MemHeader *header = (MemHeader *)base;
+    header->size = size;
+    header->tag = tag;
+    mem_tag_add(tag, (i64)size);
+    return header + 1;
+}
+
+internal MemHeader *mem_get_header(void *ptr) {
+    return (MemHeader *)ptr - 1;
+}
+
+void *_tagged_malloc(size_t size, const u32 tag) {
+    void *base = malloc(sizeof(MemHeader) + size);
+    return base ? mem_tag_header(base, size, tag) : NULL;
+}
+
+void *_tagged_calloc(size_t num, size_t size, const u32 tag) {
+    void *base = calloc(1, sizeof(MemHeader) + num * size);
+    return base ? mem_tag_header(base, num * size, tag) : NULL;
+}
+
+// A NULL ptr gets tag, otherwise the block keeps its own tag unless keep_tag is false
+void *_tagged_realloc(void *ptr, size_t new_size, u32 tag, const bool keep_tag) {
+    void *base = NULL;
+    if(ptr) {
+        MemHeader *header = mem_get_header(ptr);
+        mem_tag_add(header->tag, -(i64)header->size);
+        if(keep_tag) {
+            tag = header->tag;
+        }
+        base = header;
+    }
+    void *new_base = realloc(base, sizeof(MemHeader) + new_size);
+    if(!new_base) {
+        if(ptr) {
+            MemHeader *header = mem_get_header(ptr);
+            mem_tag_add(header->tag, (i64)header->size);
+        }
+        return NULL;
+    }
+    return mem_tag_header(new_base, new_size, tag);
+}
+
+void _tagged_free(void *ptr) {
+    if(!ptr) {
+        return;
+    }
+    MemHeader *header = mem_get_header(ptr);
+    mem_tag_add(header->tag, -(i64)header->size);
+    free(header);
+}
+
+// Logs the current and peak bytes of each tag
+void sMemDumpTags() {
+    for(u32 i = 0; i < MEM_TAG_COUNT; i++) {
+        sLog("%s | Current: %lld bytes | Peak: %lld bytes", mem_tag_names[i], mem_counters->current[i], mem_counters->peak[i]);
+    }
+}
+
 #if defined(DEBUG)
 
 #include <stdio.h>
-#include <stdlib.h>
+#include <stdint.h>
 
 #define ASSERT(expression)                                                                         \
 if(!(expression)) {                                                                            \
@@ -57,27 +177,59 @@ global bool DBG_keep_console_open;
 
 #define KEEP_CONSOLE_OPEN(value) DBG_keep_console_open |= value
 
+// Allocations are tracked in an open-addressed hash table keyed by pointer, so both adding and removing are O(1).
+// Each allocation also points to its call site (__FILE__:__LINE__), which keeps running counters for Leak_DumpStats.
+
+#define LEAK_TABLE_INITIAL_SIZE 1024 // Must be a power of 2
+#define LEAK_SITES_INITIAL_SIZE 256  // Must be a power of 2
+
 typedef struct MemoryInfo {
-    void *ptr;
+    void *ptr; // NULL if the slot is empty
     size_t size;
-    const char *file;
-    u32 line;
+    u32 site;  // Index in MemoryLeakList.sites
 } MemoryInfo;
 
-typedef struct MemoryLeak {
-    MemoryInfo info;
-    struct MemoryLeak *next;
-} MemoryLeak;
+typedef struct LeakSite {
+    char *file; // Own copy, __FILE__ strings from a dll are gone once it is unloaded
+    u32 line;
+    
+    u32 live_count;
+    u64 live_bytes;
+    u64 peak_bytes;
+    u32 frame_allocs;      // Allocations since the last Leak_EndFrame
+    u32 last_frame_allocs; // Allocations during the previous frame
+} LeakSite;
+
+typedef struct LeakSiteKey {
+    const char *file; // NULL if the slot is empty
+    u32 line;
+    u32 site;
+} LeakSiteKey;
 
 typedef struct MemoryLeakList {
-    MemoryLeak *array_start;
-    MemoryLeak *array_end;
+    MemoryInfo *slots;
+    u32 slot_count; // Power of 2
+    u32 count;
+    
+    LeakSite *sites;
+    u32 site_count;
+    u32 site_capacity;
+    
+    // Open-addressed, keyed by the __FILE__ pointer and the line so we don't hash strings on each allocation.
+    // It is cleared in Leak_SetList since the pointers of a reloaded dll may be reused by other strings.
+    LeakSiteKey *site_lookup;
+    u32 site_lookup_size;
+    u32 site_lookup_count;
 } MemoryLeakList;
 
 global MemoryLeakList *list;
 
 void Leak_Begin() {
     list = calloc(1, sizeof(MemoryLeakList));
+    list->slot_count = LEAK_TABLE_INITIAL_SIZE;
+    list->slots = calloc(list->slot_count, sizeof(MemoryInfo));
+    list->site_lookup_size = LEAK_SITES_INITIAL_SIZE;
+    list->site_lookup = calloc(list->site_lookup_size, sizeof(LeakSiteKey));
 }
 
 void *Leak_GetList() {
@@ -86,94 +238,234 @@ void *Leak_GetList() {
 
 void Leak_SetList(void *in_list) {
     list = (MemoryLeakList *)in_list;
+    memset(list->site_lookup, 0, list->site_lookup_size * sizeof(LeakSiteKey));
+    list->site_lookup_count = 0;
+}
+
+internal u32 leak_hash_ptr(const void *ptr) {
+    // Allocations are at least 16 bytes aligned, the low bits don't carry anything
+    u64 key = (u64)(uintptr_t)ptr >> 4;
+    return (u32)((key * 11400714819323198485ull) >> 32);
+}
+
+internal u32 leak_hash_site(const char *file, u32 line) {
+    return leak_hash_ptr(file) ^ (line * 2654435761u);
+}
+
+internal void leak_insert_site_key(LeakSiteKey *lookup, u32 lookup_size, const LeakSiteKey *key) {
+    u32 mask = lookup_size - 1;
+    u32 i = leak_hash_site(key->file, key->line) & mask;
+    while(lookup[i].file) {
+        i = (i + 1) & mask;
+    }
+    lookup[i] = *key;
+}
+
+internal void leak_insert_slot(MemoryInfo *slots, u32 slot_count, const MemoryInfo *info) {
+    u32 mask = slot_count - 1;
+    u32 i = leak_hash_ptr(info->ptr) & mask;
+    while(slots[i].ptr) {
+        i = (i + 1) & mask;
+    }
+    slots[i] = *info;
+}
+
+internal void leak_grow_table() {
+    u32 new_count = list->slot_count * 2;
+    MemoryInfo *new_slots = calloc(new_count, sizeof(MemoryInfo));
+    for(u32 i = 0; i < list->slot_count; i++) {
+        if(list->slots[i].ptr) {
+            leak_insert_slot(new_slots, new_count, &list->slots[i]);
+        }
+    }
+    free(list->slots);
+    list->slots = new_slots;
+    list->slot_count = new_count;
+}
+
+internal u32 leak_find_site(const char *filename, u32 line) {
+    u32 mask = list->site_lookup_size - 1;
+    u32 i = leak_hash_site(filename, line) & mask;
+    while(list->site_lookup[i].file) {
+        if(list->site_lookup[i].file == filename && list->site_lookup[i].line == line) {
+            return list->site_lookup[i].site;
+        }
+        i = (i + 1) & mask;
+    }
+    
+    // First allocation from this pointer. The site may still exist if the lookup was cleared, or if
+    // the same file is compiled in several modules
+    u32 index = list->site_count;
+    for(u32 s = 0; s < list->site_count; s++) {
+        if(list->sites[s].line == line && strcmp(list->sites[s].file, filename) == 0) {
+            index = s;
+            break;
+        }
+    }
+    
+    if(index == list->site_count) {
+        if(list->site_count == list->site_capacity) {
+            list->site_capacity = list->site_capacity ? list->site_capacity * 2 : LEAK_SITES_INITIAL_SIZE;
+            list->sites = realloc(list->sites, list->site_capacity * sizeof(LeakSite));
+        }
+        list->site_count++;
+        LeakSite *site = &list->sites[index];
+        *site = (LeakSite){0};
+        size_t length = strlen(filename);
+        site->file = malloc(length + 1);
+        memcpy(site->file, filename, length + 1);
+        site->line = line;
+    }
+    
+    LeakSiteKey key = {filename, line, index};
+    list->site_lookup[i] = key;
+    list->site_lookup_count++;
+    
+    // Keep the lookup under half full
+    if(list->site_lookup_count * 2 > list->site_lookup_size) {
+        u32 new_size = list->site_lookup_size * 2;
+        LeakSiteKey *new_lookup = calloc(new_size, sizeof(LeakSiteKey));
+        for(u32 k = 0; k < list->site_lookup_size; k++) {
+            if(list->site_lookup[k].file) {
+                leak_insert_site_key(new_lookup, new_size, &list->site_lookup[k]);
+            }
+        }
+        free(list->site_lookup);
+        list->site_lookup = new_lookup;
+        list->site_lookup_size = new_size;
+    }
+    return index;
 }
 
 internal void add_memory_info(void *ptr, size_t size, const char *filename, u32 line) {
-    MemoryLeak *leak = (MemoryLeak *)malloc(sizeof(MemoryLeak));
+    // Keep the load factor under 3/4
+    if((list->count + 1) * 4 > list->slot_count * 3) {
+        leak_grow_table();
+    }
     
-    leak->info.ptr = ptr;
-    leak->info.size = size;
-    leak->info.file = filename;
-    leak->info.line = line;
-    leak->next = NULL;
+    MemoryInfo info;
+    info.ptr = ptr;
+    info.size = size;
+    info.site = leak_find_site(filename, line);
+    leak_insert_slot(list->slots, list->slot_count, &info);
+    list->count++;
     //sLog("Allocation 0x%p, %s:%d", ptr, filename, line);
     
-    if(list->array_start == NULL) {
-        list->array_start = leak;
-        list->array_end = leak;
-    } else {
-        list->array_end->next = leak;
-        list->array_end = leak;
+    LeakSite *site = &list->sites[info.site];
+    site->live_count++;
+    site->live_bytes += size;
+    if(site->live_bytes > site->peak_bytes) {
+        site->peak_bytes = site->live_bytes;
     }
+    site->frame_allocs++;
 }
 
 internal void delete_memory_info(void *ptr) {
-    ASSERT_MSG(list->array_start, "Attempting to free a nullptr!");
-    
-    // Si c'est le premier dans la liste
-    if(list->array_start->info.ptr == ptr) {
-        MemoryLeak *leak = list->array_start;
-        list->array_start = list->array_start->next;
-        
-        free(leak);
-        return;
-    }
-    
-    // Sinon
-    for(MemoryLeak *leak = list->array_start; leak != NULL; leak = leak->next) {
-        MemoryLeak *next_leak = leak->next;
-        if(!next_leak) {
-            // The ptr couldn't be found in the list of leaks. Multiple options
+    u32 mask = list->slot_count - 1;
+    u32 i = leak_hash_ptr(ptr) & mask;
+    while(list->slots[i].ptr != ptr) {
+        if(!list->slots[i].ptr) {
+            // The ptr couldn't be found in the table. Multiple options
             // 1. We could have freed a nullptr. Hopefully the program will crash in that case
             // 2. DLL/Threads shinanigans, ie : when we reloaded a dll, this header was included, so a new list was created, so when we free the ptr, it doesn't exist in the list
             sWarn("Attempting to free a nullptr!");
             return;
         }
-        
-        if(next_leak->info.ptr == ptr) { // Si il faut supprimer le suivant
-            if(list->array_end == next_leak) {
-                leak->next = NULL;
-                list->array_end = leak;
-            } else {
-                leak->next = next_leak->next;
-            }
-            free(next_leak);
-            return;
+        i = (i + 1) & mask;
+    }
+    
+    LeakSite *site = &list->sites[list->slots[i].site];
+    site->live_count--;
+    site->live_bytes -= list->slots[i].size;
+    list->count--;
+    
+    // Backward shift deletion : pull back the following entries of the cluster so no tombstones are needed
+    u32 hole = i;
+    u32 j = i;
+    while(true) {
+        j = (j + 1) & mask;
+        if(!list->slots[j].ptr) {
+            break;
+        }
+        u32 home = leak_hash_ptr(list->slots[j].ptr) & mask;
+        // Move j into the hole only if its home isn't between the hole and j (cyclically)
+        if(((j - home) & mask) >= ((j - hole) & mask)) {
+            list->slots[hole] = list->slots[j];
+            hole = j;
         }
     }
+    list->slots[hole] = (MemoryInfo){0};
 }
 
 internal void clear_array() {
-    MemoryLeak *leak = list->array_start;
-    MemoryLeak *to_delete = list->array_start;
-    
-    while(leak != NULL) {
-        leak = leak->next;
-        free(to_delete);
-        to_delete = leak;
+    for(u32 i = 0; i < list->site_count; i++) {
+        free(list->sites[i].file);
     }
-    
+    free(list->sites);
+    free(list->site_lookup);
+    free(list->slots);
     free(list);
 }
 
-void *_malloc(size_t size, const char *filename, u32 line) {
-    void *ptr = malloc(size);
+// Rolls the per frame allocation counters over. Call once at the end of each frame.
+void Leak_EndFrame() {
+    for(u32 i = 0; i < list->site_count; i++) {
+        list->sites[i].last_frame_allocs = list->sites[i].frame_allocs;
+        list->sites[i].frame_allocs = 0;
+    }
+}
+
+internal int leak_compare_sites(const void *a, const void *b) {
+    const LeakSite *site_a = &list->sites[*(const u32 *)a];
+    const LeakSite *site_b = &list->sites[*(const u32 *)b];
+    if(site_a->live_bytes != site_b->live_bytes) {
+        return site_a->live_bytes < site_b->live_bytes ? 1 : -1;
+    }
+    return site_a->peak_bytes < site_b->peak_bytes ? 1 : (site_a->peak_bytes > site_b->peak_bytes ? -1 : 0);
+}
+
+// Logs the counters of every allocation site, sorted by live bytes
+void Leak_DumpStats() {
+    u32 *order = malloc(list->site_count * sizeof(u32));
+    for(u32 i = 0; i < list->site_count; i++) {
+        order[i] = i;
+    }
+    qsort(order, list->site_count, sizeof(u32), &leak_compare_sites);
+    
+    u64 total_live = 0;
+    for(u32 i = 0; i < list->site_count; i++) {
+        const LeakSite *site = &list->sites[order[i]];
+        total_live += site->live_bytes;
+        sLog("%s:%d | Live: %llu bytes (%d allocs) | Peak: %llu bytes | Last frame: %d allocs",
+             site->file,
+             site->line,
+             site->live_bytes,
+             site->live_count,
+             site->peak_bytes,
+             site->last_frame_allocs);
+    }
+    sLog("%d live allocations, %llu bytes, %d call sites", list->count, total_live, list->site_count);
+    free(order);
+}
+
+void *_malloc(size_t size, const u32 tag, const char *filename, u32 line) {
+    void *ptr = _tagged_malloc(size, tag);
     if(ptr != NULL) {
         add_memory_info(ptr, size, filename, line);
     }
     return ptr;
 }
 
-void *_calloc(size_t num, size_t size, const char *filename, u32 line) {
-    void *ptr = calloc(num, size);
+void *_calloc(size_t num, size_t size, const u32 tag, const char *filename, u32 line) {
+    void *ptr = _tagged_calloc(num, size, tag);
     if(ptr != NULL) {
         add_memory_info(ptr, num * size, filename, line);
     }
     return ptr;
 }
 
-void *_realloc(void *ptr, size_t new_size, const char *filename, u32 line) {
-    void *new_ptr = realloc(ptr, new_size);
+void *_realloc(void *ptr, size_t new_size, const u32 tag, const bool keep_tag, const char *filename, u32 line) {
+    void *new_ptr = _tagged_realloc(ptr, new_size, tag, keep_tag);
     if(new_ptr != NULL) {
         if(ptr != NULL)
             delete_memory_info(ptr);
@@ -187,23 +479,27 @@ void _free(void *ptr) {
     ASSERT_MSG(ptr, "Attempting to free ptr 0x0");
     //sLog("Freed %p", ptr);
     delete_memory_info(ptr);
-    free(ptr);
+    _tagged_free(ptr);
 }
 
 void _free_verbose(void *ptr, const char *string) {
     sLog("Freed %p %s", ptr, string);
     delete_memory_info(ptr);
-    free(ptr);
+    _tagged_free(ptr);
 }
 
 internal bool DumpMemoryLeaks() {
     int count = 0;
-    for(MemoryLeak *leak = list->array_start; leak != NULL; leak = leak->next) {
+    for(u32 i = 0; i < list->slot_count; i++) {
+        const MemoryInfo *info = &list->slots[i];
+        if(!info->ptr) {
+            continue;
+        }
         sError("Memory leak found - Address: %p | Size: %06d | Last alloc: %s:%d",
-               leak->info.ptr,
-               (u64)leak->info.size,
-               leak->info.file,
-               leak->info.line);
+               info->ptr,
+               (u64)info->size,
+               list->sites[info->site].file,
+               list->sites[info->site].line);
         count++;
     }
     clear_array();
@@ -218,9 +514,12 @@ void Leak_End() {
     }
 }
 
-#define sMalloc(size) _malloc(size, __FILE__, __LINE__)
-#define sCalloc(num, size) _calloc(num, size, __FILE__, __LINE__)
-#define sRealloc(ptr, size) _realloc(ptr, size, __FILE__, __LINE__)
+#define sMallocTagged(size, tag) _malloc(size, tag, __FILE__, __LINE__)
+#define sCallocTagged(num, size, tag) _calloc(num, size, tag, __FILE__, __LINE__)
+#define sReallocTagged(ptr, size, tag) _realloc(ptr, size, tag, false, __FILE__, __LINE__)
+#define sMalloc(size) _malloc(size, MEM_TAG_GENERAL, __FILE__, __LINE__)
+#define sCalloc(num, size) _calloc(num, size, MEM_TAG_GENERAL, __FILE__, __LINE__)
+#define sRealloc(ptr, size) _realloc(ptr, size, MEM_TAG_GENERAL, true, __FILE__, __LINE__) // Keeps the tag of ptr
 #define sFree(ptr) _free(ptr)
 //#define sFree(ptr) _free_verbose(ptr, #ptr)
 
@@ -235,10 +534,15 @@ void Leak_End() {
 #define Leak_End()
 #define Leak_GetList() 0
 #define Leak_SetList(arg)
-
-#define sMalloc(size) malloc(size)
-#define sCalloc(num, size) calloc(num, size)
-#define sRealloc(ptr, size) realloc(ptr, size)
-#define sFree(ptr) free(ptr)
+#define Leak_EndFrame()
+#define Leak_DumpStats() sLog("Allocation stats are only tracked in DEBUG builds")
+
+#define sMallocTagged(size, tag) _tagged_malloc(size, tag)
+#define sCallocTagged(num, size, tag) _tagged_calloc(num, size, tag)
+#define sReallocTagged(ptr, size, tag) _tagged_realloc(ptr, size, tag, false)
+#define sMalloc(size) _tagged_malloc(size, MEM_TAG_GENERAL)
+#define sCalloc(num, size) _tagged_calloc(num, size, MEM_TAG_GENERAL)
+#define sRealloc(ptr, size) _tagged_realloc(ptr, size, MEM_TAG_GENERAL, true) // Keeps the tag of ptr
+#define sFree(ptr) _tagged_free(ptr)
 
 #endif // #if DEBUG
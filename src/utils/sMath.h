@@ -6,6 +6,37 @@
 #include "sTypes.h"
 #include "sLogging.h"
 
+// SIMD paths are picked at compile time from the target flags : SSE2 is the x64 baseline,
+// AVX and FMA are used when building with -mavx -mfma (or -march=native).
+// The scalar versions are kept as *_scalar for reference and testing.
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define SMATH_SSE2
+#endif
+
+#if defined(SMATH_SSE2) && defined(__AVX__)
+#define SMATH_AVX
+#endif
+
+#if defined(SMATH_SSE2) && defined(__FMA__)
+#define SMATH_FMA
+#define SMATH_MADD_PS(a, b, c) _mm_fmadd_ps(a, b, c)
+#define SMATH_MADD256_PS(a, b, c) _mm256_fmadd_ps(a, b, c)
+#else
+#define SMATH_MADD_PS(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#define SMATH_MADD256_PS(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#endif
+
+#if defined(SMATH_AVX) && defined(SMATH_FMA)
+#define SMATH_SIMD_NAME "AVX+FMA"
+#elif defined(SMATH_AVX)
+#define SMATH_SIMD_NAME "AVX"
+#elif defined(SMATH_SSE2)
+#define SMATH_SIMD_NAME "SSE2"
+#else
+#define SMATH_SIMD_NAME "Scalar"
+#endif
+
 #define PI 3.1415926535897932384626433f
 #define HALF_PI 1.57079632679489f
 #define MAX(x, y) x > y ? x : y
@@ -97,7 +128,11 @@ void mat4_transpose(Mat4 *restrict mat);
 void mat4_mul(const f32 *restrict const a, const f32 *restrict const b, f32 *result);
 Vec4 mat4_mul_vec4(const f32 *restrict const mat, const Vec4 vec);
 Vec3 mat4_mul_vec3(const f32 *const mat, const Vec3 vec);
+void mat4_mul_scalar(const f32 *restrict const a, const f32 *restrict const b, f32 *result);
+Vec4 mat4_mul_vec4_scalar(const f32 *restrict const mat, const Vec4 vec);
+Vec3 mat4_mul_vec3_scalar(const f32 *const mat, const Vec3 vec);
 void mat4_inverse(const f32 *const restrict m, f32 *out);
+void mat4_inverse_affine(const f32 *const restrict m, f32 *out);
 
 Vec3 mat4_get_translation(const Mat4 mat);
 inline void mat4_translateby(f32 *mat, const Vec3 vec);
@@ -121,6 +156,8 @@ Quat quat(f32 x, f32 y, f32 z, f32 w) { return (Quat){{{x, y, z, w}}};}
 void quat_to_mat4(f32 *dst, const Quat *q);
 Quat quat_from_axis(const Vec3 axis, const f32 angle);
 Quat quat_identity();
+Quat quat_mul(const Quat a, const Quat b);
+Quat quat_conjugate(const Quat q);
 inline Quat quat_normalize(Quat q);
 Quat quat_nlerp(const Quat a, const Quat b, const f32 t);
 Quat quat_slerp(const Quat, const Quat, const f32);
@@ -132,6 +169,10 @@ void quat_sprint(const Quat q, char *buf);
 inline void transform_identity(Transform *xform);
 inline void transform_to_mat4(const Transform *xform, Mat4* mat);
 inline void mat4_to_transform(const Mat4 *mat, Transform *xform) ;
+void transform_inverse(const Transform *xform, Transform *result);
+void transform_inverse_to_mat4(const Transform *xform, f32 *out);
+void trs_quat_to_mat4_batch(const Vec3 *t, const Quat *r, const Vec3 *s, const u32 count, Mat4 *dst);
+void transforms_to_mat4_batch(const Transform *xforms, const u32 count, Mat4 *dst);
 
 // -----------
 // Bit operations
@@ -474,7 +515,7 @@ void mat4_transpose(Mat4 *restrict mat) {
     }
 }
 
-void mat4_mul(const f32 *restrict const a, const f32 *restrict const b, f32 *result) {
+void mat4_mul_scalar(const f32 *restrict const a, const f32 *restrict const b, f32 *result) {
     memset(result, 0, 16*sizeof(f32));
     
     for(u32 i = 0; i < 4; i++) {
@@ -486,7 +527,7 @@ void mat4_mul(const f32 *restrict const a, const f32 *restrict const b, f32 *res
     }
 }
 
-Vec4 mat4_mul_vec4(const f32 *restrict const mat, const Vec4 vec) {
+Vec4 mat4_mul_vec4_scalar(const f32 *restrict const mat, const Vec4 vec) {
     Vec4 result = {0};
     result.x = vec.x * mat[0] + vec.y * mat[4] + vec.z * mat[8] + vec.w * mat[12];
     result.y = vec.x * mat[1] + vec.y * mat[5] + vec.z * mat[9] + vec.w * mat[13];
@@ -496,7 +537,7 @@ Vec4 mat4_mul_vec4(const f32 *restrict const mat, const Vec4 vec) {
 }
 
 // This assumes that w == 1
-Vec3 mat4_mul_vec3(const f32 *const mat, const Vec3 vec) {
+Vec3 mat4_mul_vec3_scalar(const f32 *const mat, const Vec3 vec) {
     Vec3 result = {0};
     result.x = vec.x * mat[0] + vec.y * mat[4] + vec.z * mat[8] + mat[12];
     result.y = vec.x * mat[1] + vec.y * mat[5] + vec.z * mat[9] + mat[13];
@@ -504,6 +545,76 @@ Vec3 mat4_mul_vec3(const f32 *const mat, const Vec3 vec) {
     return result;
 }
 
+#if defined(SMATH_SSE2)
+
+// Matrices are column major : each column of the result is a linear combination of the columns of a,
+// weighted by the matching column of b.
+void mat4_mul(const f32 *restrict const a, const f32 *restrict const b, f32 *result) {
+#if defined(SMATH_AVX)
+    // Two columns of the result at a time, one per 128-bit lane
+    __m256 a0 = _mm256_broadcast_ps((const __m128 *)&a[0]);
+    __m256 a1 = _mm256_broadcast_ps((const __m128 *)&a[4]);
+    __m256 a2 = _mm256_broadcast_ps((const __m128 *)&a[8]);
+    __m256 a3 = _mm256_broadcast_ps((const __m128 *)&a[12]);
+    for(u32 j = 0; j < 16; j += 8) {
+        __m256 bj = _mm256_loadu_ps(&b[j]);
+        __m256 r = _mm256_mul_ps(a0, _mm256_shuffle_ps(bj, bj, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = SMATH_MADD256_PS(a1, _mm256_shuffle_ps(bj, bj, _MM_SHUFFLE(1, 1, 1, 1)), r);
+        r = SMATH_MADD256_PS(a2, _mm256_shuffle_ps(bj, bj, _MM_SHUFFLE(2, 2, 2, 2)), r);
+        r = SMATH_MADD256_PS(a3, _mm256_shuffle_ps(bj, bj, _MM_SHUFFLE(3, 3, 3, 3)), r);
+        _mm256_storeu_ps(&result[j], r);
+    }
+#else
+    __m128 a0 = _mm_loadu_ps(&a[0]);
+    __m128 a1 = _mm_loadu_ps(&a[4]);
+    __m128 a2 = _mm_loadu_ps(&a[8]);
+    __m128 a3 = _mm_loadu_ps(&a[12]);
+    for(u32 j = 0; j < 16; j += 4) {
+        __m128 r = _mm_mul_ps(a0, _mm_set1_ps(b[j]));
+        r = SMATH_MADD_PS(a1, _mm_set1_ps(b[j + 1]), r);
+        r = SMATH_MADD_PS(a2, _mm_set1_ps(b[j + 2]), r);
+        r = SMATH_MADD_PS(a3, _mm_set1_ps(b[j + 3]), r);
+        _mm_storeu_ps(&result[j], r);
+    }
+#endif
+}
+
+Vec4 mat4_mul_vec4(const f32 *restrict const mat, const Vec4 vec) {
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(&mat[0]), _mm_set1_ps(vec.x));
+    r = SMATH_MADD_PS(_mm_loadu_ps(&mat[4]), _mm_set1_ps(vec.y), r);
+    r = SMATH_MADD_PS(_mm_loadu_ps(&mat[8]), _mm_set1_ps(vec.z), r);
+    r = SMATH_MADD_PS(_mm_loadu_ps(&mat[12]), _mm_set1_ps(vec.w), r);
+    Vec4 result;
+    _mm_storeu_ps(&result.x, r);
+    return result;
+}
+
+// This assumes that w == 1
+Vec3 mat4_mul_vec3(const f32 *const mat, const Vec3 vec) {
+    __m128 r = SMATH_MADD_PS(_mm_loadu_ps(&mat[0]), _mm_set1_ps(vec.x), _mm_loadu_ps(&mat[12]));
+    r = SMATH_MADD_PS(_mm_loadu_ps(&mat[4]), _mm_set1_ps(vec.y), r);
+    r = SMATH_MADD_PS(_mm_loadu_ps(&mat[8]), _mm_set1_ps(vec.z), r);
+    alignas(16) f32 tmp[4];
+    _mm_store_ps(tmp, r);
+    return (Vec3){tmp[0], tmp[1], tmp[2]};
+}
+
+#else
+
+void mat4_mul(const f32 *restrict const a, const f32 *restrict const b, f32 *result) {
+    mat4_mul_scalar(a, b, result);
+}
+
+Vec4 mat4_mul_vec4(const f32 *restrict const mat, const Vec4 vec) {
+    return mat4_mul_vec4_scalar(mat, vec);
+}
+
+Vec3 mat4_mul_vec3(const f32 *const mat, const Vec3 vec) {
+    return mat4_mul_vec3_scalar(mat, vec);
+}
+
+#endif
+
 void mat4_inverse(const f32 *const restrict m, f32 *out) {
     Mat4 inv;
     float det;
@@ -586,6 +697,74 @@ void mat4_inverse(const f32 *const restrict m, f32 *out) {
         out[i] = inv[i] * det;
 }
 
+// Inverse of a matrix whose last row is (0, 0, 0, 1), like any TRS. Much cheaper than mat4_inverse :
+// the 3x3 part is inverted with cross products (rows of the inverse are b x c, c x a and a x b over the determinant),
+// then the translation is brought back through it.
+void mat4_inverse_affine(const f32 *const restrict m, f32 *out) {
+#if defined(SMATH_SSE2)
+    const __m128 xyz_mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+    __m128 a = _mm_and_ps(_mm_loadu_ps(&m[0]), xyz_mask);
+    __m128 b = _mm_and_ps(_mm_loadu_ps(&m[4]), xyz_mask);
+    __m128 c = _mm_and_ps(_mm_loadu_ps(&m[8]), xyz_mask);
+    
+#define SMATH_CROSS_(u, v)                                                                         \
+_mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(u, u, _MM_SHUFFLE(3, 0, 2, 1)), _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 1, 0, 2))), \
+           _mm_mul_ps(_mm_shuffle_ps(u, u, _MM_SHUFFLE(3, 1, 0, 2)), _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1))))
+    __m128 r0 = SMATH_CROSS_(b, c);
+    __m128 r1 = SMATH_CROSS_(c, a);
+    __m128 r2 = SMATH_CROSS_(a, b);
+#undef SMATH_CROSS_
+    
+    __m128 det = _mm_mul_ps(a, r0);
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+    if(_mm_cvtss_f32(det) == 0.0f) {
+        sLog("Inverse of matrix doesn't exist");
+        return;
+    }
+    __m128 inv_det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    r0 = _mm_mul_ps(r0, inv_det);
+    r1 = _mm_mul_ps(r1, inv_det);
+    r2 = _mm_mul_ps(r2, inv_det);
+    __m128 r3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    
+    // r0..r2 are now the columns of the inverse with w = 0
+    __m128 t = SMATH_MADD_PS(r0, _mm_set1_ps(m[12]), _mm_mul_ps(r1, _mm_set1_ps(m[13])));
+    t = SMATH_MADD_PS(r2, _mm_set1_ps(m[14]), t);
+    t = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), t);
+    _mm_storeu_ps(&out[0], r0);
+    _mm_storeu_ps(&out[4], r1);
+    _mm_storeu_ps(&out[8], r2);
+    _mm_storeu_ps(&out[12], t);
+#else
+    const Vec3 a = {m[0], m[1], m[2]};
+    const Vec3 b = {m[4], m[5], m[6]};
+    const Vec3 c = {m[8], m[9], m[10]};
+    Vec3 r0 = vec3_cross(b, c);
+    Vec3 r1 = vec3_cross(c, a);
+    Vec3 r2 = vec3_cross(a, b);
+    f32 det = vec3_dot(a, r0);
+    if(det == 0.0f) {
+        sLog("Inverse of matrix doesn't exist");
+        return;
+    }
+    f32 inv_det = 1.0f / det;
+    r0 = vec3_fmul(r0, inv_det);
+    r1 = vec3_fmul(r1, inv_det);
+    r2 = vec3_fmul(r2, inv_det);
+    const Vec3 t = {m[12], m[13], m[14]};
+    
+    out[0] = r0.x; out[1] = r1.x; out[2] = r2.x; out[3] = 0.0f;
+    out[4] = r0.y; out[5] = r1.y; out[6] = r2.y; out[7] = 0.0f;
+    out[8] = r0.z; out[9] = r1.z; out[10] = r2.z; out[11] = 0.0f;
+    out[12] = -vec3_dot(r0, t);
+    out[13] = -vec3_dot(r1, t);
+    out[14] = -vec3_dot(r2, t);
+    out[15] = 1.0f;
+#endif
+}
+
 Vec3 mat4_get_translation(const Mat4 mat) {
     Vec3 result = *(Vec3 *)&mat[12]; // Haxxxxxxxorzzz
     return result;
@@ -801,6 +980,21 @@ Quat quat_identity() {
     return quat(0.0f, 0.0f, 0.0f, 1.0f);
 }
 
+// a * b : rotates by b, then by a
+Quat quat_mul(const Quat a, const Quat b) {
+    Quat result;
+    result.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+    result.y = a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x;
+    result.z = a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w;
+    result.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+    return result;
+}
+
+// Inverse of a unit quaternion
+Quat quat_conjugate(const Quat q) {
+    return quat(-q.x, -q.y, -q.z, q.w);
+}
+
 inline Quat quat_normalize(Quat q) {
     Quat result;
     f32 length = sqrt(q.x * q.x +  q.y * q.y + q.z * q.z + q.w * q.w);
@@ -885,6 +1079,255 @@ inline void transform_to_mat4(const Transform *xform, Mat4* mat) {
     trs_quat_to_mat4(&xform->translation, &xform->rotation, &xform->scale, (f32 *)mat);
 }
 
+// Inverse as a TRS : conjugate rotation, reciprocal scale and the negative translation brought back through both.
+// Only exact with a uniform scale, the inverse of a non uniform scale followed by a rotation can't be written as a TRS.
+// Use transform_inverse_to_mat4 when the scale may be non uniform.
+void transform_inverse(const Transform *xform, Transform *result) {
+    const Quat q = xform->rotation;
+    const Vec3 inv_scale = {1.0f / xform->scale.x, 1.0f / xform->scale.y, 1.0f / xform->scale.z};
+    result->rotation = quat(-q.x, -q.y, -q.z, q.w);
+    Vec3 t = vec3_rotate(vec3_fmul(xform->translation, -1.0f), result->rotation);
+    result->translation = (Vec3){t.x * inv_scale.x, t.y * inv_scale.y, t.z * inv_scale.z};
+    result->scale = inv_scale;
+}
+
+// Inverse matrix of a TRS, exact for any scale. The inverse of T * R * S is S^-1 * R^T * T^-1 :
+// the columns of R^T scaled by the reciprocal scale, then the negative translation brought through them.
+void transform_inverse_to_mat4(const Transform *xform, f32 *out) {
+    // Rows of the rotation matrix built by trs_quat_to_mat4, they are the columns of R^T
+    const Quat *r = &xform->rotation;
+    const f32 sqx = 2.0f * r->x * r->x;
+    const f32 sqy = 2.0f * r->y * r->y;
+    const f32 sqz = 2.0f * r->z * r->z;
+    const f32 xy = 2.0f * r->x * r->y;
+    const f32 zw = 2.0f * r->z * r->w;
+    const f32 xz = 2.0f * r->x * r->z;
+    const f32 yw = 2.0f * r->y * r->w;
+    const f32 yz = 2.0f * r->y * r->z;
+    const f32 xw = 2.0f * r->x * r->w;
+    const f32 rotation_t[3][3] = {
+        {1.0f - sqy - sqz, xy - zw, xz + yw},
+        {xy + zw, 1.0f - sqx - sqz, yz - xw},
+        {xz - yw, yz + xw, 1.0f - sqx - sqy},
+    };
+#if defined(SMATH_SSE2)
+    __m128 c0 = _mm_setr_ps(rotation_t[0][0], rotation_t[0][1], rotation_t[0][2], 0.0f);
+    __m128 c1 = _mm_setr_ps(rotation_t[1][0], rotation_t[1][1], rotation_t[1][2], 0.0f);
+    __m128 c2 = _mm_setr_ps(rotation_t[2][0], rotation_t[2][1], rotation_t[2][2], 0.0f);
+    __m128 inv_scale = _mm_div_ps(_mm_set1_ps(1.0f), _mm_setr_ps(xform->scale.x, xform->scale.y, xform->scale.z, 1.0f));
+    c0 = _mm_mul_ps(c0, inv_scale);
+    c1 = _mm_mul_ps(c1, inv_scale);
+    c2 = _mm_mul_ps(c2, inv_scale);
+    __m128 t = SMATH_MADD_PS(c0, _mm_set1_ps(xform->translation.x), _mm_mul_ps(c1, _mm_set1_ps(xform->translation.y)));
+    t = SMATH_MADD_PS(c2, _mm_set1_ps(xform->translation.z), t);
+    t = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), t);
+    _mm_storeu_ps(&out[0], c0);
+    _mm_storeu_ps(&out[4], c1);
+    _mm_storeu_ps(&out[8], c2);
+    _mm_storeu_ps(&out[12], t);
+#else
+    const f32 inv_scale[3] = {1.0f / xform->scale.x, 1.0f / xform->scale.y, 1.0f / xform->scale.z};
+    for(u32 column = 0; column < 3; column++) {
+        for(u32 row = 0; row < 3; row++) {
+            out[column * 4 + row] = rotation_t[column][row] * inv_scale[row];
+        }
+        out[column * 4 + 3] = 0.0f;
+    }
+    const Vec3 t = xform->translation;
+    for(u32 row = 0; row < 3; row++) {
+        out[12 + row] = -(out[row] * t.x + out[4 + row] * t.y + out[8 + row] * t.z);
+    }
+    out[15] = 1.0f;
+#endif
+}
+
+// --------
+// Batched TRS to matrix
+// Same math as trs_quat_to_mat4, on 4 (SSE2) or 8 (AVX) transforms at once. Each SIMD lane is one transform,
+// the 16 elements are computed for all lanes and then transposed into the matrices.
+
+#if defined(SMATH_SSE2)
+
+// elements[k] holds the element k of 4 matrices
+internal inline void smath_store_mat4x4_(__m128 *elements, Mat4 *dst) {
+    for(u32 column = 0; column < 4; column++) {
+        __m128 r0 = elements[column * 4 + 0];
+        __m128 r1 = elements[column * 4 + 1];
+        __m128 r2 = elements[column * 4 + 2];
+        __m128 r3 = elements[column * 4 + 3];
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(&dst[0][column * 4], r0);
+        _mm_storeu_ps(&dst[1][column * 4], r1);
+        _mm_storeu_ps(&dst[2][column * 4], r2);
+        _mm_storeu_ps(&dst[3][column * 4], r3);
+    }
+}
+
+internal inline void smath_trs_to_mat4x4_(__m128 tx, __m128 ty, __m128 tz, __m128 qx, __m128 qy, __m128 qz, __m128 qw, __m128 sx, __m128 sy, __m128 sz, Mat4 *dst) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+    
+    __m128 sqx = _mm_mul_ps(two, _mm_mul_ps(qx, qx));
+    __m128 sqy = _mm_mul_ps(two, _mm_mul_ps(qy, qy));
+    __m128 sqz = _mm_mul_ps(two, _mm_mul_ps(qz, qz));
+    __m128 xy = _mm_mul_ps(qx, qy);
+    __m128 zw = _mm_mul_ps(qz, qw);
+    __m128 xz = _mm_mul_ps(qx, qz);
+    __m128 yw = _mm_mul_ps(qy, qw);
+    __m128 yz = _mm_mul_ps(qy, qz);
+    __m128 xw = _mm_mul_ps(qx, qw);
+    
+    __m128 elements[16];
+    elements[0] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, sqy), sqz), sx);
+    elements[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, zw)), sx);
+    elements[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, yw)), sx);
+    elements[3] = zero;
+    elements[4] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, zw)), sy);
+    elements[5] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, sqx), sqz), sy);
+    elements[6] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, xw)), sy);
+    elements[7] = zero;
+    elements[8] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, yw)), sz);
+    elements[9] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, xw)), sz);
+    elements[10] = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, sqx), sqy), sz);
+    elements[11] = zero;
+    elements[12] = tx;
+    elements[13] = ty;
+    elements[14] = tz;
+    elements[15] = one;
+    smath_store_mat4x4_(elements, dst);
+}
+
+#if defined(SMATH_AVX)
+internal inline void smath_trs_to_mat4x8_(__m256 tx, __m256 ty, __m256 tz, __m256 qx, __m256 qy, __m256 qz, __m256 qw, __m256 sx, __m256 sy, __m256 sz, Mat4 *dst) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    
+    __m256 sqx = _mm256_mul_ps(two, _mm256_mul_ps(qx, qx));
+    __m256 sqy = _mm256_mul_ps(two, _mm256_mul_ps(qy, qy));
+    __m256 sqz = _mm256_mul_ps(two, _mm256_mul_ps(qz, qz));
+    __m256 xy = _mm256_mul_ps(qx, qy);
+    __m256 zw = _mm256_mul_ps(qz, qw);
+    __m256 xz = _mm256_mul_ps(qx, qz);
+    __m256 yw = _mm256_mul_ps(qy, qw);
+    __m256 yz = _mm256_mul_ps(qy, qz);
+    __m256 xw = _mm256_mul_ps(qx, qw);
+    
+    __m256 elements[16];
+    elements[0] = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(one, sqy), sqz), sx);
+    elements[1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, zw)), sx);
+    elements[2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, yw)), sx);
+    elements[3] = _mm256_setzero_ps();
+    elements[4] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, zw)), sy);
+    elements[5] = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(one, sqx), sqz), sy);
+    elements[6] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, xw)), sy);
+    elements[7] = _mm256_setzero_ps();
+    elements[8] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, yw)), sz);
+    elements[9] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, xw)), sz);
+    elements[10] = _mm256_mul_ps(_mm256_sub_ps(_mm256_sub_ps(one, sqx), sqy), sz);
+    elements[11] = _mm256_setzero_ps();
+    elements[12] = tx;
+    elements[13] = ty;
+    elements[14] = tz;
+    elements[15] = one;
+    
+    // The transposes are done on 128-bit halves
+    __m128 low[16];
+    __m128 high[16];
+    for(u32 i = 0; i < 16; i++) {
+        low[i] = _mm256_castps256_ps128(elements[i]);
+        high[i] = _mm256_extractf128_ps(elements[i], 1);
+    }
+    smath_store_mat4x4_(low, dst);
+    smath_store_mat4x4_(high, dst + 4);
+}
+#endif
+
+// Loads the members of 4 consecutive transforms in SoA form. A Transform is 10 floats,
+// three overlapping loads and transposes per group give every member.
+internal inline void smath_load_transforms4_(const Transform *x, __m128 *members) {
+    __m128 a0 = _mm_loadu_ps(&x[0].translation.x); // tx ty tz qx
+    __m128 a1 = _mm_loadu_ps(&x[1].translation.x);
+    __m128 a2 = _mm_loadu_ps(&x[2].translation.x);
+    __m128 a3 = _mm_loadu_ps(&x[3].translation.x);
+    _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+    __m128 b0 = _mm_loadu_ps(&x[0].rotation.y); // qy qz qw sx
+    __m128 b1 = _mm_loadu_ps(&x[1].rotation.y);
+    __m128 b2 = _mm_loadu_ps(&x[2].rotation.y);
+    __m128 b3 = _mm_loadu_ps(&x[3].rotation.y);
+    _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+    __m128 c0 = _mm_loadu_ps(&x[0].rotation.w); // qw sx sy sz
+    __m128 c1 = _mm_loadu_ps(&x[1].rotation.w);
+    __m128 c2 = _mm_loadu_ps(&x[2].rotation.w);
+    __m128 c3 = _mm_loadu_ps(&x[3].rotation.w);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    members[0] = a0; // tx
+    members[1] = a1; // ty
+    members[2] = a2; // tz
+    members[3] = a3; // qx
+    members[4] = b0; // qy
+    members[5] = b1; // qz
+    members[6] = b2; // qw
+    members[7] = c1; // sx
+    members[8] = c2; // sy
+    members[9] = c3; // sz
+}
+
+#define SMATH_GATHER4_(array, member) _mm_setr_ps((array)[0]member, (array)[1]member, (array)[2]member, (array)[3]member)
+#define SMATH_GATHER8_(array, member) _mm256_setr_ps((array)[0]member, (array)[1]member, (array)[2]member, (array)[3]member, (array)[4]member, (array)[5]member, (array)[6]member, (array)[7]member)
+
+#endif
+
+// Converts count TRS into matrices, dst[i] is made from t[i], r[i] and s[i]
+void trs_quat_to_mat4_batch(const Vec3 *t, const Quat *r, const Vec3 *s, const u32 count, Mat4 *dst) {
+    u32 i = 0;
+#if defined(SMATH_AVX)
+    for(; i + 8 <= count; i += 8) {
+        smath_trs_to_mat4x8_(SMATH_GATHER8_(t + i, .x), SMATH_GATHER8_(t + i, .y), SMATH_GATHER8_(t + i, .z),
+                             SMATH_GATHER8_(r + i, .x), SMATH_GATHER8_(r + i, .y), SMATH_GATHER8_(r + i, .z), SMATH_GATHER8_(r + i, .w),
+                             SMATH_GATHER8_(s + i, .x), SMATH_GATHER8_(s + i, .y), SMATH_GATHER8_(s + i, .z), dst + i);
+    }
+#endif
+#if defined(SMATH_SSE2)
+    for(; i + 4 <= count; i += 4) {
+        smath_trs_to_mat4x4_(SMATH_GATHER4_(t + i, .x), SMATH_GATHER4_(t + i, .y), SMATH_GATHER4_(t + i, .z),
+                             SMATH_GATHER4_(r + i, .x), SMATH_GATHER4_(r + i, .y), SMATH_GATHER4_(r + i, .z), SMATH_GATHER4_(r + i, .w),
+                             SMATH_GATHER4_(s + i, .x), SMATH_GATHER4_(s + i, .y), SMATH_GATHER4_(s + i, .z), dst + i);
+    }
+#endif
+    for(; i < count; i++) {
+        trs_quat_to_mat4(&t[i], &r[i], &s[i], dst[i]);
+    }
+}
+
+// Converts count transforms into matrices
+void transforms_to_mat4_batch(const Transform *xforms, const u32 count, Mat4 *dst) {
+    u32 i = 0;
+#if defined(SMATH_AVX)
+    for(; i + 8 <= count; i += 8) {
+        __m128 low[10];
+        __m128 high[10];
+        smath_load_transforms4_(xforms + i, low);
+        smath_load_transforms4_(xforms + i + 4, high);
+        __m256 m[10];
+        for(u32 k = 0; k < 10; k++) {
+            m[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(low[k]), high[k], 1);
+        }
+        smath_trs_to_mat4x8_(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], dst + i);
+    }
+#endif
+#if defined(SMATH_SSE2)
+    for(; i + 4 <= count; i += 4) {
+        __m128 m[10];
+        smath_load_transforms4_(xforms + i, m);
+        smath_trs_to_mat4x4_(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7], m[8], m[9], dst + i);
+    }
+#endif
+    for(; i < count; i++) {
+        transform_to_mat4(&xforms[i], &dst[i]);
+    }
+}
+
 // @Optimize, we do stuff in double when doing this
 inline void mat4_to_transform(const Mat4 *mat, Transform *xform) {
     xform->translation = mat4_get_translation((f32 *)mat);
@@ -2,21 +2,31 @@
 
 #include "sTypes.h"
 #include "sLogging.h"
+#include "sIntern.h"
 
 #if defined(__WIN32__)
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 typedef struct PerfInfo {
-    const char *name;
+    sStringID name;
     i64 start_time;
     i64 accumulated_time;
     u32 calls;
 } PerfInfo;
 
+// Value reported each frame, for example the memory used by something
+typedef struct PerfCounter {
+    sStringID name;
+    u64 value;
+    u64 max;
+} PerfCounter;
+
 i64 clock_frequency = 0;
 const u32 infos_size = 64;
 u32 counter = 0;
 PerfInfo infos[64] = {0};
+u32 perf_counter_count = 0;
+PerfCounter perf_counters[32] = {0};
 
 void sInitPerf() {
     LARGE_INTEGER frequency;
@@ -24,11 +34,35 @@ void sInitPerf() {
     clock_frequency = frequency.QuadPart;
 }
 
-#define sBeginTimer(name) sBeginTimer_(name)
-void sBeginTimer_(const char *name) {
+// Interns name once per call site, the timers and counters are then looked up by ID.
+// The call site keeps the first name it gets, so name must be a string literal. DEBUG builds check it.
+#if defined(DEBUG)
+#define sPerfNameID_(name)                                                                         \
+({                                                                                                 \
+static sStringID name_id_ = STRING_ID_NONE;                                                        \
+static const char *name_ptr_ = NULL;                                                               \
+if(name_id_ == STRING_ID_NONE) {                                                                   \
+name_ptr_ = (name);                                                                                \
+name_id_ = sIntern(name_ptr_);                                                                     \
+}                                                                                                  \
+ASSERT_MSG(name_ptr_ == (name), "sPerf names must be string literals");                            \
+name_id_;                                                                                          \
+})
+#else
+#define sPerfNameID_(name)                                                                         \
+({                                                                                                 \
+static sStringID name_id_ = STRING_ID_NONE;                                                        \
+if(name_id_ == STRING_ID_NONE)                                                                     \
+name_id_ = sIntern(name);                                                                          \
+name_id_;                                                                                          \
+})
+#endif
+
+#define sBeginTimer(name) sBeginTimer_(sPerfNameID_(name))
+void sBeginTimer_(const sStringID name) {
     PerfInfo *info = 0;
     for(u32 i = 0; i < counter; i++) {
-        if(strcmp(infos[i].name, name) == 0) {
+        if(infos[i].name == name) {
             info = &infos[i];
         }
     }
@@ -41,19 +75,19 @@ void sBeginTimer_(const char *name) {
     info->start_time = start.QuadPart;
 }
 
-#define sEndTimer(name) sEndTimer_(name)
-void sEndTimer_(const char *name) {
+#define sEndTimer(name) sEndTimer_(sPerfNameID_(name))
+void sEndTimer_(const sStringID name) {
     LARGE_INTEGER end;
     QueryPerformanceCounter(&end);
 
     PerfInfo *info = 0;
     for(u32 i = 0; i < counter; i++) {
-        if(strcmp(infos[i].name, name) == 0) {
+        if(infos[i].name == name) {
             info = &infos[i];
         }
     }
     if(!info) {
-        sError("No performance counter start for %s", name);
+        sError("No performance counter start for %s", sInternString(name));
         return;
     }
 
@@ -64,6 +98,28 @@ void sEndTimer_(const char *name) {
     info->calls++;
 }
 
+#define sPerfSetCounter(name, value) sPerfSetCounter_(sPerfNameID_(name), value)
+void sPerfSetCounter_(const sStringID name, const u64 value) {
+    PerfCounter *perf_counter = 0;
+    for(u32 i = 0; i < perf_counter_count; i++) {
+        if(perf_counters[i].name == name) {
+            perf_counter = &perf_counters[i];
+        }
+    }
+    if(!perf_counter) {
+        if(perf_counter_count == ARRAY_SIZE(perf_counters)) {
+            sError("Too many performance counters, %s is ignored", sInternString(name));
+            return;
+        }
+        perf_counter = &perf_counters[perf_counter_count++];
+        perf_counter->name = name;
+    }
+    perf_counter->value = value;
+    if(value > perf_counter->max) {
+        perf_counter->max = value;
+    }
+}
+
 #define sDumpPerf() sDumpPerf_()
 void sDumpPerf_() {
     for(u32 i = 0; i < counter; i++) {
@@ -73,13 +129,18 @@ void sDumpPerf_() {
         f64 average = total_time / (f32)info->calls;
 
         sLog("%s - Total time : %fms (Calls : %u, Avg : %f)",
-             info->name,
+             sInternString(info->name),
              total_time,
              info->calls,
              average);
     }
+    for(u32 i = 0; i < perf_counter_count; i++) {
+        sLog("%s - Current : %llu (Max : %llu)", sInternString(perf_counters[i].name), perf_counters[i].value, perf_counters[i].max);
+    }
 }
 
 #else
 
+#define sPerfSetCounter(name, value)
+
 #endif
@@ -0,0 +1,178 @@
+#pragma once
+// SPOOL
+// Pool of fixed size elements accessed through generational handles.
+// Elements never move : memory is allocated in chunks that double in size (chunk k holds base_capacity << k elements),
+// so pointers returned by sPoolGet stay valid until the element is removed.
+// Removed slots are chained in an intrusive free list and reused first. Each slot keeps a generation that is bumped on
+// add and remove, a handle to a removed element is detected as stale and sPoolGet returns NULL.
+
+#include <string.h>
+
+#include "sTypes.h"
+#include "sLeak.h"
+#include "sArena.h"
+
+// Handle layout : the low bits are the slot index, the high bits the slot generation.
+// Live slots have an odd generation, so a valid handle is never 0.
+typedef u32 sPoolHandle;
+
+#define POOL_INVALID_HANDLE 0
+#define POOL_INDEX_BITS 22
+#define POOL_INDEX_MASK ((1u << POOL_INDEX_BITS) - 1)
+#define POOL_GENERATION_MASK ((1u << (32 - POOL_INDEX_BITS)) - 1)
+#define POOL_MAX_CHUNKS 32
+
+typedef struct sPool {
+    u8 *chunks[POOL_MAX_CHUNKS]; // Elements, followed by the u32 generation of each slot
+    u32 chunk_count;
+
+    u32 element_size;
+    u32 base_capacity; // Capacity of the first chunk, must be a power of 2
+    u32 base_shift;    // log2(base_capacity)
+
+    u32 count;      // Live elements
+    u32 capacity;   // Slots in all the allocated chunks
+    u32 high_water; // Slots that have been used at least once, iterate up to this
+    u32 free_head;  // First free slot index + 1, 0 if the free list is empty
+
+    sArena *arena; // If set, chunks are pushed here instead of being allocated. sPoolDestroy won't free them.
+} sPool;
+
+// Creates a new pool. base_capacity must be a power of 2. element_size must be at least 4 bytes to store the free list.
+sPool sPoolCreate(const u32 base_capacity, const u32 element_size) {
+    ASSERT_MSG((base_capacity & (base_capacity - 1)) == 0, "Pool base capacity must be a power of 2");
+    ASSERT_MSG(element_size >= sizeof(u32), "Pool elements must be at least 4 bytes");
+    sPool pool = {0};
+    pool.element_size = element_size;
+    pool.base_capacity = base_capacity;
+    while((1u << pool.base_shift) < base_capacity) {
+        pool.base_shift++;
+    }
+    return pool;
+}
+
+// Creates a pool that allocates its chunks in arena
+sPool sPoolCreateInArena(sArena *arena, const u32 base_capacity, const u32 element_size) {
+    sPool pool = sPoolCreate(base_capacity, element_size);
+    pool.arena = arena;
+    return pool;
+}
+
+void sPoolDestroy(sPool *pool) {
+    if(!pool->arena) {
+        for(u32 i = 0; i < pool->chunk_count; i++) {
+            sFree(pool->chunks[i]);
+        }
+    }
+    *pool = (sPool){0};
+}
+
+internal u32 sPoolChunkCapacity_(const sPool *pool, const u32 chunk) {
+    return pool->base_capacity << chunk;
+}
+
+// Returns the address of the element at index and its generation
+internal void *sPoolSlot_(const sPool *pool, const u32 index, u32 **generation) {
+    // Chunk k starts at base * (2^k - 1)
+    u32 q = (index >> pool->base_shift) + 1;
+    u32 chunk = 31 - __builtin_clz(q);
+    u32 offset = index - ((pool->base_capacity << chunk) - pool->base_capacity);
+    u8 *base = pool->chunks[chunk];
+    u32 chunk_capacity = sPoolChunkCapacity_(pool, chunk);
+    *generation = (u32 *)(base + chunk_capacity * pool->element_size) + offset;
+    return base + offset * pool->element_size;
+}
+
+internal bool sPoolGrow_(sPool *pool) {
+    if(pool->chunk_count == POOL_MAX_CHUNKS) {
+        return false;
+    }
+    u32 chunk_capacity = sPoolChunkCapacity_(pool, pool->chunk_count);
+    if(pool->capacity + chunk_capacity > POOL_INDEX_MASK) {
+        return false;
+    }
+    // The generations come after the elements, elements are at least 4 bytes so they stay aligned
+    u64 size = (u64)chunk_capacity * pool->element_size + (u64)chunk_capacity * sizeof(u32);
+    u8 *chunk = pool->arena ? sArenaPushAligned(pool->arena, size, 16) : sCalloc(size, 1);
+    if(!chunk) {
+        return false;
+    }
+    pool->chunks[pool->chunk_count++] = chunk;
+    pool->capacity += chunk_capacity;
+    return true;
+}
+
+// Adds a zeroed element to the pool and returns its handle. Returns POOL_INVALID_HANDLE if the pool is full.
+sPoolHandle sPoolAdd(sPool *pool) {
+    u32 index;
+    if(pool->free_head) {
+        index = pool->free_head - 1;
+    } else {
+        if(pool->high_water == pool->capacity && !sPoolGrow_(pool)) {
+            ASSERT_MSG(0, "Pool is full");
+            return POOL_INVALID_HANDLE;
+        }
+        index = pool->high_water++;
+    }
+
+    u32 *generation;
+    void *element = sPoolSlot_(pool, index, &generation);
+    if(pool->free_head) {
+        pool->free_head = *(u32 *)element;
+    }
+    (*generation)++;
+    memset(element, 0, pool->element_size);
+    pool->count++;
+
+    return ((*generation & POOL_GENERATION_MASK) << POOL_INDEX_BITS) | index;
+}
+
+// Returns the element of handle, or NULL if it was removed
+void *sPoolGet(const sPool *pool, const sPoolHandle handle) {
+    u32 index = handle & POOL_INDEX_MASK;
+    if(handle == POOL_INVALID_HANDLE || index >= pool->high_water) {
+        return NULL;
+    }
+    u32 *generation;
+    void *element = sPoolSlot_(pool, index, &generation);
+    if((*generation & POOL_GENERATION_MASK) != (handle >> POOL_INDEX_BITS)) {
+        return NULL;
+    }
+    return element;
+}
+
+bool sPoolIsValid(const sPool *pool, const sPoolHandle handle) {
+    return sPoolGet(pool, handle) != NULL;
+}
+
+// Returns the live element in slot index, or NULL if the slot is free. Used to iterate : for(i = 0; i < pool->high_water; i++)
+void *sPoolGetAt(const sPool *pool, const u32 index) {
+    ASSERT(index < pool->high_water);
+    u32 *generation;
+    void *element = sPoolSlot_(pool, index, &generation);
+    return (*generation & 1) ? element : NULL;
+}
+
+// Returns the handle of the element in slot index. The slot must be live
+sPoolHandle sPoolGetHandleAt(const sPool *pool, const u32 index) {
+    u32 *generation;
+    sPoolSlot_(pool, index, &generation);
+    ASSERT(*generation & 1);
+    return ((*generation & POOL_GENERATION_MASK) << POOL_INDEX_BITS) | index;
+}
+
+// Removes the element of handle. Handles to it become stale
+void sPoolRemove(sPool *pool, const sPoolHandle handle) {
+    void *element = sPoolGet(pool, handle);
+    ASSERT_MSG(element, "Removing a stale pool handle");
+    if(!element) {
+        return;
+    }
+    u32 index = handle & POOL_INDEX_MASK;
+    u32 *generation;
+    sPoolSlot_(pool, index, &generation);
+    (*generation)++;
+    *(u32 *)element = pool->free_head;
+    pool->free_head = index + 1;
+    pool->count--;
+}
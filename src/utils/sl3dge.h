@@ -5,8 +5,13 @@
 #include "sImage.h"
 #include "sLogging.h"
 #include "sMath.h"
+#include "sMathWide.h"
+#include "sFastMath.h"
 #include "sModule.h"
+#include "sIntern.h"
 #include "sPerf.h"
 #include "sString.h"
 #include "sTests.h"
-#include "sArray.h"
\ No newline at end of file
+#include "sArray.h"
+#include "sArena.h"
+#include "sPool.h"
\ No newline at end of file
@@ -1,21 +1,58 @@
 
-void WorldInit(World *world, u32 size) {
-    world->entities = sCalloc(size, sizeof(Entity));
-    world->entities_size = size;
+// size is the capacity of the first chunk of entities (power of 2), the world grows past it as needed
+void WorldInit(World *world, sArena *arena, u32 size) {
+    *world = (World){0};
+    world->arena = arena;
+    world->entities = sPoolCreateInArena(arena, size, sizeof(Entity));
+    world->alive_capacity = size;
+    world->alive = sArenaPushArray(arena, world->alive_capacity, EntityID);
 }
 
 EntityID WorldCreateEntity(World *world) {
-    ASSERT(world->entity_count < world->entities_size); // Entity limit
-    Entity *e = &world->entities[world->entity_count];
-    *e = (Entity){0};
-    e->id = world->entity_count;
+    EntityID id = sPoolAdd(&world->entities);
+    Entity *e = sPoolGet(&world->entities, id);
+    
+    if(world->alive_count == world->alive_capacity) {
+        // The old list stays in the arena until the level is reset, it's at most as big as the new one
+        u32 new_capacity = world->alive_capacity * 2;
+        EntityID *new_alive = sArenaPushArray(world->arena, new_capacity, EntityID);
+        memcpy(new_alive, world->alive, world->alive_count * sizeof(EntityID));
+        world->alive = new_alive;
+        world->alive_capacity = new_capacity;
+    }
+    
+    e->id = id;
+    e->alive_index = world->alive_count;
+    world->alive[world->alive_count++] = id;
     transform_identity(&e->transform);
     e->color = (Vec3){1.0f, 1.0f, 1.0f};
-    return world->entity_count++;
+    return id;
 }
 
+// Returns NULL if the entity was destroyed
 inline Entity *WorldGetEntity(World *world, EntityID id) {
-    return &world->entities[id];
+    return sPoolGet(&world->entities, id);
+}
+
+// The entity's slot is reused by the next WorldCreateEntity, its ID becomes stale.
+void WorldDestroyEntity(World *world, EntityID id) {
+    Entity *e = WorldGetEntity(world, id);
+    ASSERT_MSG(e, "Destroying a stale entity");
+    if(!e) {
+        return;
+    }
+    
+    // Swap the last alive entity into the hole
+    EntityID last = world->alive[--world->alive_count];
+    if(last != id) {
+        world->alive[e->alive_index] = last;
+        WorldGetEntity(world, last)->alive_index = e->alive_index;
+    }
+    if(e->render_type == RenderingType_SkinnedMesh) {
+        RendererFreePose(global_renderer, e->skinned_mesh, e->pose);
+        EntityStopAnimations(e);
+    }
+    sPoolRemove(&world->entities, id);
 }
 
 EntityID WorldCreateAndGetEntity(World *world, Entity **result) {
@@ -24,19 +61,125 @@ EntityID WorldCreateAndGetEntity(World *world, Entity **result) {
     return e_id;
 }
 
+// The world's memory lives in the level arena, it is released when the arena is reset
 void WorldDestroy(World *world) {
-    for(u32 i = 0; i < world->entity_count; i++) {
-        Entity *e = WorldGetEntity(world, i);
-        // @Clean : this is kind of dirty
-        if(e->skeleton) {
-            sFree(e->skeleton);
+    // Samplers are on the heap
+    for(u32 i = 0; i < world->alive_count; i++) {
+        Entity *e = WorldGetEntity(world, world->alive[i]);
+        if(e->render_type == RenderingType_SkinnedMesh) {
+            EntityStopAnimations(e);
+        }
+    }
+    *world = (World){0};
+}
+
+// Walking NPCs standing in a grid behind the level, each one at a different point of the cycle
+void WorldSpawnCrowd(World *world, Renderer *renderer, SkinnedMeshHandle skin, AnimationHandle animation, const u32 count) {
+    const u32 row_size = 32;
+    const Animation *clip = sPoolGet(&renderer->animations, animation);
+    for(u32 i = 0; i < count; i++) {
+        EntityID id = InstantiateSkin(renderer, world, skin);
+        Entity *e = WorldGetEntity(world, id);
+        e->transform.translation = (Vec3){(f32)(i % row_size) - row_size / 2.0f, 0.0f, -10.0f - (f32)(i / row_size)};
+        // Golden ratio sequence, spreads the start times evenly
+        f32 phase = fmodf(i * 0.618034f, 1.0f);
+        EntityPlayAnimation(renderer, e, animation, phase * clip->length);
+    }
+}
+
+// Picks the LOD from the distance to the camera, NULL settings keep everything at full rate
+internal AnimationLOD WorldPickAnimationLOD(const AnimationLODSettings *lod, const Vec3 camera, const Vec3 position) {
+    if(!lod) {
+        return AnimationLOD_Full;
+    }
+    Vec3 diff = vec3_sub(position, camera);
+    f32 distance_sq = vec3_dot(diff, diff);
+    if(distance_sq >= lod->freeze_distance * lod->freeze_distance) {
+        return AnimationLOD_Frozen;
+    } else if(distance_sq >= lod->throttle_distance * lod->throttle_distance) {
+        return AnimationLOD_Throttled;
+    }
+    return AnimationLOD_Full;
+}
+
+// Advances the animations of every awake animated entity and updates their poses, in job_count jobs.
+// 0 picks the job count from the number of instances. Returns the number of instances updated.
+// Throttled instances get their key on different frames : the frame counter is offset by the pose index.
+u32 WorldAnimateEntities(World *world, Renderer *renderer, const AnimationLODSettings *lod, f32 delta_time, u32 job_count) {
+    sArena *frame_arena = &platform->memory->frame;
+    AnimationInstance *instances = sArenaPushArray(frame_arena, world->alive_count, AnimationInstance);
+    AnimationLayer *layers = sArenaPushArray(frame_arena, world->alive_count * ENTITY_ANIMATION_LAYERS, AnimationLayer);
+    if(!instances || !layers) {
+        sError("Animation : no room in the frame arena for %u instances", world->alive_count);
+        return 0;
+    }
+    u32 lod_counts[AnimationLOD_Count] = {0};
+    u32 count = 0;
+    for(u32 i = 0; i < world->alive_count; i++) {
+        Entity *e = WorldGetEntity(world, world->alive[i]);
+        if(e->render_type != RenderingType_SkinnedMesh || e->animation_count == 0 || (e->flags & EntityFlag_Sleeping)) {
+            continue;
+        }
+        const SkinnedMesh *skin = sPoolGet(&renderer->skins, e->skinned_mesh);
+        if(!skin || !EntityUpdateAnimations(renderer, e, delta_time)) {
+            continue;
+        }
+        
+        AnimationLOD previous_lod = e->animation_lod;
+        e->animation_lod = WorldPickAnimationLOD(lod, renderer->camera_pos, e->transform.translation);
+        lod_counts[e->animation_lod]++;
+        if(e->animation_lod == AnimationLOD_Frozen) {
+            continue;
         }
+        
+        AnimationInstance *instance = &instances[count++];
+        *instance = (AnimationInstance){layers, 0, skin, e->pose, ANIMATION_UPDATE_FULL};
+        // The base is always evaluated, the layers on top only if they contribute
+        for(u32 l = 0; l < e->animation_count; l++) {
+            EntityAnimation *animation = &e->animations[l];
+            if(l > 0 && animation->weight <= 0.0f) {
+                continue;
+            }
+            layers[instance->layer_count++] = (AnimationLayer){
+                sPoolGet(&renderer->animations, animation->animation), &animation->sampler, animation->time,
+                animation->weight, animation->mode, animation->joint_weights};
+        }
+        layers += instance->layer_count;
+        
+        if(e->animation_lod == AnimationLOD_Throttled) {
+            const u32 phase = (world->animation_frame + e->pose) % lod->interval;
+            if(previous_lod != AnimationLOD_Throttled) {
+                instance->update = ANIMATION_UPDATE_RESET;
+            } else if(phase == 0) {
+                // The pose reached at the next key, the blend gets there in interval frames
+                instance->update = ANIMATION_UPDATE_KEY;
+                for(u32 l = 0; l < instance->layer_count; l++) {
+                    AnimationLayer *layer = &instance->layers[l];
+                    layer->time = AnimationWrapTime(layer->time + (lod->interval - 1) * delta_time, layer->animation->length);
+                }
+                instance->blend = 1.0f / lod->interval;
+            } else {
+                instance->update = ANIMATION_UPDATE_BLEND;
+                instance->blend = (phase + 1.0f) / lod->interval;
+            }
+        }
+    }
+    world->animation_frame++;
+    sPerfSetCounter("Animation LOD full", lod_counts[AnimationLOD_Full]);
+    sPerfSetCounter("Animation LOD throttled", lod_counts[AnimationLOD_Throttled]);
+    sPerfSetCounter("Animation LOD frozen", lod_counts[AnimationLOD_Frozen]);
+    
+    if(job_count == 0) {
+        job_count = (count + ANIMATION_JOB_SIZE - 1) / ANIMATION_JOB_SIZE;
+        job_count = MIN(job_count, ANIMATION_MAX_JOBS);
     }
-    sFree(world->entities);
+    RendererAnimateInstances(platform, frame_arena, instances, count, job_count);
+    return count;
 }
 
 void UpdateAndDrawEntities(GameData *game_data, World *world, Input *input, Renderer *renderer, f32 delta_time) {
-    for(u32 id = 0; id < world->entity_count; id++) {
+    for(u32 i = 0; i < world->alive_count;) {
+        EntityID id = world->alive[i];
         Entity *e = WorldGetEntity(world, id);
         if(!(e->flags & EntityFlag_Sleeping)) {
             // Update entity
@@ -55,6 +198,10 @@ void UpdateAndDrawEntities(GameData *game_data, World *world, Input *input, Rend
                 }
                 default : break;
             }
+            // The entity destroyed itself, the last alive entity was moved into slot i
+            if(!WorldGetEntity(world, id)) {
+                continue;
+            }
         }
         if(!(e->flags & EntityFlag_Hidden)) {
             // Draw entity
@@ -63,9 +210,10 @@ void UpdateAndDrawEntities(GameData *game_data, World *world, Input *input, Rend
                     PushMesh(&renderer->scene_pushbuffer, e->static_mesh, &e->transform, e->color);
                 } break;
                 case(RenderingType_SkinnedMesh) : {
-                    PushSkinnedMesh(&renderer->scene_pushbuffer, e->skinned_mesh, &e->transform, e->skeleton, e->color);
+                    PushSkinnedMesh(&renderer->scene_pushbuffer, e->skinned_mesh, &e->transform, e->pose, e->color);
                 } break;
             }
         }
+        i++;
     }
 }
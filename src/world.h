@@ -1,9 +1,27 @@
 #pragma once
 
+// Distances to the camera where the animation LODs start, see AnimationLOD
+typedef struct AnimationLODSettings {
+    f32 throttle_distance;
+    f32 freeze_distance;
+    u32 interval; // Frames between two evaluations of a throttled instance
+} AnimationLODSettings;
+
+#define ANIMATION_LOD_THROTTLE_DISTANCE 15.0f
+#define ANIMATION_LOD_FREEZE_DISTANCE 40.0f
+#define ANIMATION_LOD_INTERVAL 4
+
 typedef struct World {
-    Entity *entities;
-    u32 entity_count;
-    u32 entities_size;
+    sArena *arena; // Level arena, everything owned by the world is allocated here
+
+    sPool entities; // EntityIDs are handles into this pool. Stale IDs get NULL from WorldGetEntity
+
+    // Dense list of the live entities, in no particular order. Iterate this instead of the pool.
+    EntityID *alive;
+    u32 alive_count;
+    u32 alive_capacity;
+
+    u32 animation_frame; // Counts the calls to WorldAnimateEntities, staggers the throttled instances
 
     Entity *static_entities;
     u32 static_entity_count;
@@ -12,9 +30,12 @@ typedef struct World {
 } World;
 
 
-void WorldInit(World *world, u32 size);
+void WorldInit(World *world, sArena *arena, u32 size);
 EntityID WorldCreateEntity(World *world);
 inline Entity *WorldGetEntity(World *world, EntityID id);
 EntityID WorldCreateAndGetEntity(World *world, Entity **result);
+void WorldDestroyEntity(World *world, EntityID id);
 void WorldDestroy(World *world);
+void WorldSpawnCrowd(World *world, Renderer *renderer, SkinnedMeshHandle skin, AnimationHandle animation, const u32 count);
+u32 WorldAnimateEntities(World *world, Renderer *renderer, const AnimationLODSettings *lod, f32 delta_time, u32 job_count);
 void UpdateAndDrawEntities(GameData *game_data, World *world, Input *input, Renderer *renderer, f32 delta_time);